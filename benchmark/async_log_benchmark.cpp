@@ -0,0 +1,67 @@
+// Times each cpp_dump() call of 16 threads that log at once, writing synchronously to std::clog
+// and through cpp_dump::start_async_log(), with and without defer_formatting.
+// Run with the standard error output redirected, e.g. ./async_log_benchmark 2>/dev/null.
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../cpp-dump.hpp"
+
+//
+using namespace std;
+namespace cp = cpp_dump;
+
+void run(const char *name, int iterations) {
+  constexpr int thread_count = 16;
+  vector<vector<long long>> latencies(thread_count);
+  vector<thread> threads;
+  for (int t = 0; t < thread_count; ++t) {
+    threads.emplace_back([t, iterations, &latencies] {
+      vector<int> vec{t, 1, 2, 3, 4, 5, 6, 7};
+      auto &latency = latencies[t];
+      latency.reserve(iterations);
+      for (int i = 0; i < iterations; ++i) {
+        auto start = chrono::steady_clock::now();
+        cpp_dump(t, i, vec);
+        auto end = chrono::steady_clock::now();
+        latency.push_back(chrono::duration_cast<chrono::nanoseconds>(end - start).count());
+      }
+    });
+  }
+  for (auto &th : threads) th.join();
+  cp::flush_async_log();
+
+  vector<long long> all;
+  for (const auto &latency : latencies) all.insert(all.end(), latency.begin(), latency.end());
+  sort(all.begin(), all.end());
+  auto percentile = [&](double p) {
+    return all[static_cast<size_t>(static_cast<double>(all.size() - 1) * p)];
+  };
+  cout << name << ": p50 " << percentile(0.5) << " ns, p99 " << percentile(0.99) << " ns, max "
+       << all.back() << " ns" << endl;
+}
+
+int main(int argc, char *argv[]) {
+  int iterations = argc >= 2 ? stoi(argv[1]) : 20000;
+  CPP_DUMP_SET_OPTION(es_style, cp::types::es_style_t::no_es);
+
+  run("sync", iterations);
+
+  cp::start_async_log();
+  run("async block", iterations);
+  cp::start_async_log({4096, cp::types::log_overflow_t::drop_newest});
+  run("async drop_newest", iterations);
+  cout << "dropped: " << cp::async_log_dropped_count() << endl;
+  cp::start_async_log({4096, cp::types::log_overflow_t::block, 2, true});
+  run("async deferred", iterations);
+  cp::start_async_log({4096, cp::types::log_overflow_t::drop_newest, 2, true});
+  run("async deferred drop_newest", iterations);
+  cout << "dropped: " << cp::async_log_dropped_count() << endl;
+  cp::stop_async_log();
+
+  return 0;
+}
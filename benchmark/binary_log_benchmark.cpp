@@ -0,0 +1,75 @@
+// Compares the time and the size of the output of cpp_dump() writing the text and writing the
+// binary records of cpp_dump::start_binary_log(), both to a temporary file.
+
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "../cpp-dump.hpp"
+
+//
+using namespace std;
+namespace cp = cpp_dump;
+
+FILE *text_file = nullptr;
+
+namespace cpp_dump {
+
+template <>
+void write_log(std::string_view output) {
+  fwrite(output.data(), 1, output.size(), text_file);
+  fputc('\n', text_file);
+}
+
+}  // namespace cpp_dump
+
+template <typename Dump>
+void run(const char *name, int iterations, Dump dump) {
+  auto measure = [&](bool binary) {
+    FILE *file = tmpfile();
+    if (binary) {
+      cp::start_binary_log(fileno(file));
+    } else {
+      text_file = file;
+    }
+    auto start = chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i) dump(i);
+    if (binary) {
+      cp::stop_binary_log();
+    } else {
+      fflush(file);
+    }
+    auto end = chrono::steady_clock::now();
+    auto size = ftell(file);
+    fclose(file);
+    auto ns = chrono::duration_cast<chrono::nanoseconds>(end - start).count() / iterations;
+    return make_pair(ns, size);
+  };
+
+  auto [text_ns, text_size] = measure(false);
+  auto [binary_ns, binary_size] = measure(true);
+  cout << name << ": text " << text_ns << " ns, " << text_size << " bytes; binary " << binary_ns
+       << " ns, " << binary_size << " bytes" << endl;
+}
+
+int main(int argc, char *argv[]) {
+  int iterations = argc >= 2 ? stoi(argv[1]) : 100000;
+
+  vector<int> vec{1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16};
+  vector<double> doubles(16, 3.25);
+  map<string, int> m{{"alpha", 1}, {"beta", 2}, {"gamma", 3}};
+  string str = "a short string";
+
+  run("scalars", iterations, [&](int i) { cpp_dump(i, i * 0.5, str); });
+  run("vector<int>(16)", iterations, [&](int i) {
+    vec[0] = i;
+    cpp_dump(vec);
+  });
+  run("vector<double>(16)", iterations, [&](int) { cpp_dump(doubles); });
+  run("map<string, int>(3)", iterations, [&](int) { cpp_dump(m); });
+
+  return 0;
+}
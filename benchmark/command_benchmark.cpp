@@ -0,0 +1,83 @@
+// Composes manipulators and exports a small vector with them, as cpp_dump(v | ...) in a loop does.
+// "compose" times building the commands alone, and "export" times cp::export_to() with them.
+// The allocations are counted per iteration.
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "../cpp-dump.hpp"
+
+//
+using namespace std;
+namespace cp = cpp_dump;
+
+static size_t allocation_count = 0;
+
+// GCC cannot tell that these replace the global operators.
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 11
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+void *operator new(size_t size) {
+  ++allocation_count;
+  if (void *p = malloc(size == 0 ? 1 : size)) return p;
+  throw bad_alloc();
+}
+
+void operator delete(void *p) noexcept { free(p); }
+void operator delete(void *p, size_t) noexcept { free(p); }
+
+// Keeps the composed commands from being optimized away.
+static const void *volatile escaped;
+
+template <typename Compose>
+void run(const char *name, Compose compose, int iterations) {
+  size_t check = 0;
+  size_t count = allocation_count;
+  auto start = chrono::steady_clock::now();
+  for (int i = 0; i < iterations; ++i) {
+    auto vc = compose();
+    escaped = &vc;
+  }
+  auto middle = chrono::steady_clock::now();
+  size_t compose_allocations = allocation_count - count;
+  string output;
+  for (int i = 0; i < iterations; ++i) {
+    output.clear();
+    cp::export_to(output, compose());
+    check += output.size();
+  }
+  auto end = chrono::steady_clock::now();
+  if (check == 0 || escaped == nullptr) abort();
+
+  auto per_call = [&](auto duration) {
+    auto ns = chrono::duration_cast<chrono::nanoseconds>(duration).count();
+    return static_cast<double>(ns) / iterations;
+  };
+  cout << name << ": compose " << per_call(middle - start) << " ns ("
+       << static_cast<double>(compose_allocations) / iterations << " allocations), export "
+       << per_call(end - middle) << " ns" << endl;
+}
+
+int main(int argc, char *argv[]) {
+  int iterations = argc >= 2 ? stoi(argv[1]) : 200000;
+  CPP_DUMP_SET_OPTION(es_style, cp::types::es_style_t::no_es);
+
+  vector<int> vec{1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12};
+  map<int, vector<int>> m{{1, {10, 11, 12}}, {2, {20, 21, 22}}, {3, {30, 31, 32}}};
+
+  run("v | hex() | front(8)", [&] { return vec | cp::hex() | cp::front(8); }, iterations);
+  run("v | front(3) | back(2) | index()",
+      [&] { return vec | cp::front(3) | cp::back(2) | cp::index(); },
+      iterations);
+  run("m | front(2) | map_kv(hex() | back(2), front(2))",
+      [&] { return m | cp::front(2) | cp::map_kv(cp::hex() | cp::back(2), cp::front(2)); },
+      iterations);
+
+  return 0;
+}
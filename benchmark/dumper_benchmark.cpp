@@ -0,0 +1,60 @@
+// Measures the time of a call of cpp_dump() with the shared options, with an options_scope, and
+// with a dumper.
+
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "../cpp-dump.hpp"
+
+//
+using namespace std;
+namespace cp = cpp_dump;
+
+size_t printed = 0;
+
+namespace cpp_dump {
+
+template <>
+void write_log(std::string_view output) {
+  printed += output.size();
+}
+
+}  // namespace cpp_dump
+
+template <typename Loop>
+void run(const char *name, int iterations, Loop loop) {
+  printed = 0;
+  auto start = chrono::steady_clock::now();
+  loop(iterations);
+  auto end = chrono::steady_clock::now();
+  auto ns = chrono::duration_cast<chrono::nanoseconds>(end - start).count();
+  cout << name << ": " << static_cast<double>(ns) / iterations << " ns per call, " << printed
+       << " bytes" << endl;
+}
+
+int main(int argc, char *argv[]) {
+  int iterations = argc >= 2 ? stoi(argv[1]) : 1000000;
+
+  vector<int> vec{1, 2, 3, 4, 5, 6, 7, 8};
+  CPP_DUMP_SET_OPTION(max_line_width, 200);
+
+  run("cpp_dump", iterations, [&](int n) {
+    for (int i = 0; i < n; ++i) cpp_dump(i, vec);
+  });
+  run("cpp_dump in an options_scope", iterations, [&](int n) {
+    cp::options_scope scope{cp::types::options_snapshot_t()};
+    for (int i = 0; i < n; ++i) cpp_dump(i, vec);
+  });
+  const cp::dumper dumper;
+  run("cpp_dump_with", iterations, [&](int n) {
+    for (int i = 0; i < n; ++i) cpp_dump_with(dumper, i, vec);
+  });
+  run("dumper::operator()", iterations, [&](int n) {
+    for (int i = 0; i < n; ++i) dumper(i, vec);
+  });
+
+  return 0;
+}
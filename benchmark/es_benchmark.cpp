@@ -0,0 +1,41 @@
+// Runs the dump indent test without output many times.
+// Build this with and without CPP_DUMP_DISABLE_ES to compare the colored and no-color builds.
+
+#include <chrono>
+#include <iostream>
+#include <streambuf>
+#include <string>
+
+#define main dump_indent_test_main
+#include "../test/dump_indent_test.cpp"
+#undef main
+
+struct null_buffer : std::streambuf {
+  int overflow(int c) override { return c; }
+  std::streamsize xsputn(const char *, std::streamsize n) override { return n; }
+};
+
+int main(int argc, char *argv[]) {
+  // es_style: 0 = no_es, 1 = original, 2 = by_syntax
+  std::string es_style = argc >= 2 ? argv[1] : "0";
+  int iterations = argc >= 3 ? std::stoi(argv[2]) : 200;
+  std::string width = "160", depth = "4", color_test = "0";
+  char *args[] = {argv[0], width.data(), depth.data(), es_style.data(), color_test.data()};
+
+  null_buffer buffer;
+  auto *original_buffer = std::clog.rdbuf(&buffer);
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < iterations; ++i) {
+    dump_indent_test_main(5, args);
+  }
+  auto end = std::chrono::steady_clock::now();
+  std::clog.rdbuf(original_buffer);
+
+  auto us = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+#if defined(CPP_DUMP_DISABLE_ES)
+  std::cout << "CPP_DUMP_DISABLE_ES";
+#else
+  std::cout << "es_style=" << es_style;
+#endif
+  std::cout << ": " << us / iterations << " us/run" << std::endl;
+}
@@ -0,0 +1,77 @@
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "../cpp-dump.hpp"
+
+//
+using namespace std;
+namespace cp = cpp_dump;
+
+static size_t allocation_count = 0;
+
+// GCC cannot tell that these replace the global operators.
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 11
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+void *operator new(size_t size) {
+  ++allocation_count;
+  if (void *p = malloc(size == 0 ? 1 : size)) return p;
+  throw bad_alloc();
+}
+
+void operator delete(void *p) noexcept { free(p); }
+void operator delete(void *p, size_t) noexcept { free(p); }
+
+template <typename F>
+void run(const string &name, int iterations, F f) {
+  allocation_count = 0;
+  auto start = chrono::steady_clock::now();
+  for (int i = 0; i < iterations; ++i) f();
+  auto end = chrono::steady_clock::now();
+  auto us = chrono::duration_cast<chrono::microseconds>(end - start).count();
+  cout << name << ": " << allocation_count / iterations << " allocations/call, "
+       << us / iterations << " us/call" << endl;
+}
+
+int main() {
+  CPP_DUMP_SET_OPTION(max_iteration_count, 100);
+
+  // depth 0: vector, 1: map, 2: vector, 3: int
+  vector<map<string, vector<int>>> data(8);
+  for (size_t i = 0; i < data.size(); ++i) {
+    for (int j = 0; j < 8; ++j) {
+      auto &v = data[i]["key" + to_string(j)];
+      for (int k = 0; k < 16; ++k) v.push_back(k * j);
+    }
+  }
+
+  const int iterations = 200;
+  size_t length = cp::export_var(data).size();
+  cout << "output length: " << length << endl;
+
+  run("export_var()                 ", iterations, [&] {
+    string s = cp::export_var(data);
+    if (s.size() != length) abort();
+  });
+
+  string reused;
+  reused.reserve(length);
+  run("export_to(std::string &)     ", iterations, [&] {
+    reused.clear();
+    cp::export_to(reused, data);
+    if (reused.size() != length) abort();
+  });
+
+  vector<char> buffer(length);
+  run("export_to(cpp_dump::char_span)", iterations, [&] {
+    cp::char_span span(buffer.data(), buffer.size());
+    cp::export_to(span, data);
+    if (span.size() != length) abort();
+  });
+}
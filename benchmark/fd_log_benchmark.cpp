@@ -0,0 +1,46 @@
+// Measures the throughput of cpp_dump::write_log() writing a formatted log to std::clog and
+// through cpp_dump::start_fd_log(), with 1 and 8 threads that log at once.
+// The log is formatted once, so this measures the output alone.
+// Run with the standard error output redirected, e.g. ./fd_log_benchmark 2>/dev/null.
+
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../cpp-dump.hpp"
+
+//
+using namespace std;
+namespace cp = cpp_dump;
+
+void run(const char *name, int thread_count, int iterations) {
+  auto start = chrono::steady_clock::now();
+  vector<thread> threads;
+  for (int t = 0; t < thread_count; ++t) {
+    threads.emplace_back([t, iterations] {
+      string output = "[dump] t => " + to_string(t) + ", vec => [ 0, 1, 2, 3, 4, 5, 6, 7 ]";
+      for (int i = 0; i < iterations; ++i) cp::write_log(output);
+    });
+  }
+  for (auto &th : threads) th.join();
+  auto end = chrono::steady_clock::now();
+  auto ns = chrono::duration_cast<chrono::nanoseconds>(end - start).count();
+  auto logs = static_cast<double>(thread_count) * iterations;
+  cout << name << ", " << thread_count << " threads: " << logs * 1e9 / static_cast<double>(ns)
+       << " logs per second" << endl;
+}
+
+int main(int argc, char *argv[]) {
+  int iterations = argc >= 2 ? stoi(argv[1]) : 100000;
+
+  for (int thread_count : {1, 8}) {
+    run("std::clog", thread_count, iterations);
+    cp::start_fd_log();
+    run("start_fd_log()", thread_count, iterations);
+    cp::stop_fd_log();
+  }
+
+  return 0;
+}
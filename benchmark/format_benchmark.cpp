@@ -0,0 +1,65 @@
+// Formats numbers with cp::format().
+// "format" times the formatting of one number, and "export" times cp::export_to() of a vector,
+// which also builds and lays out the document.
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../cpp-dump.hpp"
+
+//
+using namespace std;
+namespace cp = cpp_dump;
+
+template <typename T>
+void run(const vector<T> &values, const char *f, int iterations) {
+  auto manipulator = cp::format(f);
+  cp::_detail::export_command command(manipulator);
+
+  size_t length = 0;
+  auto start = chrono::steady_clock::now();
+  for (int i = 0; i < iterations; ++i) {
+    cp::_detail::dump_scope scope;
+    for (T v : values) length += command.format(v).size();
+  }
+  auto middle = chrono::steady_clock::now();
+  string output;
+  for (int i = 0; i < iterations; ++i) {
+    output.clear();
+    cp::export_to(output, cp::format(f) << values);
+    length += output.size();
+  }
+  auto end = chrono::steady_clock::now();
+  if (length == 0) abort();
+
+  auto per_value = [&](auto duration) {
+    auto ns = chrono::duration_cast<chrono::nanoseconds>(duration).count();
+    return static_cast<double>(ns) / iterations / static_cast<double>(values.size());
+  };
+  cout << f << ": format " << per_value(middle - start) << " ns/value, export "
+       << per_value(end - middle) << " ns/value" << endl;
+}
+
+int main(int argc, char *argv[]) {
+  int iterations = argc >= 2 ? stoi(argv[1]) : 200;
+  CPP_DUMP_SET_OPTION(max_iteration_count, 1000);
+  CPP_DUMP_SET_OPTION(es_style, cp::types::es_style_t::no_es);
+
+  mt19937_64 engine(1);
+  vector<double> doubles(1000);
+  for (auto &v : doubles) v = uniform_real_distribution<double>(-1e6, 1e6)(engine);
+  vector<int> ints(1000);
+  for (auto &v : ints) v = static_cast<int>(engine());
+
+  run(doubles, "%.3f", iterations);
+  run(doubles, "%10.2f", iterations);
+  run(doubles, "%e", iterations);
+  run(ints, "%d", iterations);
+  run(ints, "%08x", iterations);
+  // Passed to snprintf()
+  run(doubles, "%g", iterations);
+}
@@ -0,0 +1,72 @@
+// Exports integers of every width with cp::hex(), cp::bin(64, 8), and cp::udec().
+// "format" times the formatting of one integer, and "export" times cp::export_to() of a vector,
+// which also builds and lays out the document.
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../cpp-dump.hpp"
+
+//
+using namespace std;
+namespace cp = cpp_dump;
+
+template <typename T, typename Command>
+void run(const string &type_name, const string &style_name, Command command, int iterations) {
+  mt19937_64 engine(1);
+  vector<T> values(1000);
+  for (auto &v : values) v = static_cast<T>(engine());
+
+  size_t length = 0;
+  auto start = chrono::steady_clock::now();
+  for (int i = 0; i < iterations; ++i) {
+    cp::_detail::dump_scope scope;
+    cp::_detail::export_command export_command(command);
+    for (T v : values) {
+      length += cp::_detail::_export_arithmetic::_export_integer(v, export_command).size();
+    }
+  }
+  auto middle = chrono::steady_clock::now();
+  string output;
+  for (int i = 0; i < iterations; ++i) {
+    output.clear();
+    cp::export_to(output, command << values);
+    length += output.size();
+  }
+  auto end = chrono::steady_clock::now();
+  if (length == 0) abort();
+
+  auto per_integer = [&](auto duration) {
+    auto ns = chrono::duration_cast<chrono::nanoseconds>(duration).count();
+    return static_cast<double>(ns) / iterations / static_cast<double>(values.size());
+  };
+  cout << type_name << " " << style_name << ": format " << per_integer(middle - start)
+       << " ns/integer, export " << per_integer(end - middle) << " ns/integer" << endl;
+}
+
+template <typename T>
+void run_all(const string &type_name, int iterations) {
+  run<T>(type_name, "hex()     ", cp::hex(), iterations);
+  run<T>(type_name, "bin(64, 8)", cp::bin(64, 8), iterations);
+  run<T>(type_name, "udec()    ", cp::udec(), iterations);
+}
+
+int main(int argc, char *argv[]) {
+  int iterations = argc >= 2 ? stoi(argv[1]) : 200;
+  CPP_DUMP_SET_OPTION(max_iteration_count, 1000);
+  CPP_DUMP_SET_OPTION(es_style, cp::types::es_style_t::no_es);
+
+  run_all<int8_t>("int8_t  ", iterations);
+  run_all<uint8_t>("uint8_t ", iterations);
+  run_all<int16_t>("int16_t ", iterations);
+  run_all<uint16_t>("uint16_t", iterations);
+  run_all<int32_t>("int32_t ", iterations);
+  run_all<uint32_t>("uint32_t", iterations);
+  run_all<int64_t>("int64_t ", iterations);
+  run_all<uint64_t>("uint64_t", iterations);
+}
@@ -0,0 +1,88 @@
+// Groups the equal keys of std::multimap<int, int>s with 1M entries, each key repeated 1000 times
+// or twice.
+// "key_groups" sweeps the map once, and "equal_range" is the lookup per key that it replaces.
+// The others export the map, whose keys and values are cut off at max_iteration_count.
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <string>
+
+#include "../cpp-dump.hpp"
+
+//
+using namespace std;
+namespace cp = cpp_dump;
+
+template <typename Func>
+void run(const char *name, Func func, int iterations) {
+  size_t check = 0;
+  auto start = chrono::steady_clock::now();
+  for (int i = 0; i < iterations; ++i) check += func();
+  auto end = chrono::steady_clock::now();
+  if (check == 0) abort();
+
+  auto ns = chrono::duration_cast<chrono::nanoseconds>(end - start).count();
+  cout << name << ": " << static_cast<double>(ns) / iterations / 1000000 << " ms" << endl;
+}
+
+void bench(const multimap<int, int> &mmap, int iterations) {
+  run(
+      "key_groups",
+      [&] {
+        size_t count = 0;
+        cp::_detail::key_groups<multimap<int, int>> grouped(mmap);
+        for (auto it = grouped.begin(); it != grouped.end(); ++it) count += it.count();
+        return count;
+      },
+      iterations
+  );
+  run(
+      "equal_range",
+      [&] {
+        size_t count = 0;
+        for (auto it = mmap.begin(); it != mmap.end();) {
+          auto range = mmap.equal_range(it->first);
+          count += mmap.count(it->first);
+          it = range.second;
+        }
+        return count;
+      },
+      iterations
+  );
+
+  string output;
+  run(
+      "export",
+      [&] {
+        output.clear();
+        cp::export_to(output, mmap);
+        return output.size();
+      },
+      iterations
+  );
+  run(
+      "export | back(3)",
+      [&] {
+        output.clear();
+        cp::export_to(output, mmap | cp::back(3));
+        return output.size();
+      },
+      iterations
+  );
+}
+
+int main(int argc, char *argv[]) {
+  int iterations = argc >= 2 ? stoi(argv[1]) : 20;
+  CPP_DUMP_SET_OPTION(es_style, cp::types::es_style_t::no_es);
+
+  for (int multiplicity : {1000, 2}) {
+    multimap<int, int> mmap;
+    for (int i = 0; i < 1000000; ++i) mmap.emplace_hint(mmap.end(), i / multiplicity, i);
+    cout << "multiplicity " << multiplicity << endl;
+    bench(mmap, iterations);
+  }
+
+  return 0;
+}
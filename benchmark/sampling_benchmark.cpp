@@ -0,0 +1,56 @@
+// Measures the time of a call of cpp_dump_sampled() skipped by each policy.
+
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "../cpp-dump.hpp"
+
+//
+using namespace std;
+namespace cp = cpp_dump;
+
+size_t printed = 0;
+
+namespace cpp_dump {
+
+template <>
+void write_log(std::string_view) {
+  ++printed;
+}
+
+}  // namespace cpp_dump
+
+template <typename Loop>
+void run(const char *name, int iterations, Loop loop) {
+  printed = 0;
+  auto start = chrono::steady_clock::now();
+  loop(iterations);
+  auto end = chrono::steady_clock::now();
+  auto ns = chrono::duration_cast<chrono::nanoseconds>(end - start).count();
+  cout << name << ": " << static_cast<double>(ns) / iterations << " ns per call, " << printed
+       << " printed" << endl;
+}
+
+int main(int argc, char *argv[]) {
+  int iterations = argc >= 2 ? stoi(argv[1]) : 10000000;
+
+  vector<int> vec{1, 2, 3, 4, 5, 6, 7, 8};
+
+  run("first(10)", iterations, [&](int n) {
+    for (int i = 0; i < n; ++i) cpp_dump_sampled(cp::sampling::first(10), i, vec);
+  });
+  run("every(100000)", iterations, [&](int n) {
+    for (int i = 0; i < n; ++i) cpp_dump_sampled(cp::sampling::every(100000), i, vec);
+  });
+  run("per_second(10)", iterations, [&](int n) {
+    for (int i = 0; i < n; ++i) cpp_dump_sampled(cp::sampling::per_second(10), i, vec);
+  });
+  run("probability(0.00001)", iterations, [&](int n) {
+    for (int i = 0; i < n; ++i) cpp_dump_sampled(cp::sampling::probability(0.00001), i, vec);
+  });
+
+  return 0;
+}
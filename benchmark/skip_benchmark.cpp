@@ -0,0 +1,80 @@
+// "walk" times iterating a skip container with the default policy, which shows every element.
+// The others export containers through the skip manipulators.
+// The tails of the large list and map are found by stepping backward from the end.
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <list>
+#include <map>
+#include <numeric>
+#include <string>
+#include <vector>
+
+#include "../cpp-dump.hpp"
+
+//
+using namespace std;
+namespace cp = cpp_dump;
+
+template <typename T, typename Command>
+void run(const char *name, const T &container, Command command, int iterations) {
+  size_t length = 0;
+  string output;
+  auto start = chrono::steady_clock::now();
+  for (int i = 0; i < iterations; ++i) {
+    output.clear();
+    cp::export_to(output, container | command);
+    length += output.size();
+  }
+  auto end = chrono::steady_clock::now();
+  if (length == 0) abort();
+
+  auto ns = chrono::duration_cast<chrono::nanoseconds>(end - start).count();
+  cout << name << ": " << static_cast<double>(ns) / iterations << " ns" << endl;
+}
+
+void walk(const vector<int> &vec, int iterations) {
+  CPP_DUMP_SET_OPTION(max_iteration_count, vec.size());
+  size_t sum = 0;
+  auto start = chrono::steady_clock::now();
+  for (int i = 0; i < iterations; ++i) {
+    auto skipped = cp::_detail::export_command::default_command.create_skip_container(vec);
+    for (auto &&[is_ellipsis, it, index] : skipped) {
+      if (!is_ellipsis) sum += static_cast<size_t>(*it) + index;
+    }
+  }
+  auto end = chrono::steady_clock::now();
+  if (sum == 0) abort();
+
+  auto ns = chrono::duration_cast<chrono::nanoseconds>(end - start).count();
+  cout << "walk: " << static_cast<double>(ns) / iterations / static_cast<double>(vec.size())
+       << " ns/element" << endl;
+  CPP_DUMP_SET_OPTION(max_iteration_count, 16);
+}
+
+int main(int argc, char *argv[]) {
+  int iterations = argc >= 2 ? stoi(argv[1]) : 20000;
+  CPP_DUMP_SET_OPTION(es_style, cp::types::es_style_t::no_es);
+
+  vector<int> vec(1000);
+  iota(vec.begin(), vec.end(), 0);
+  list<int> lst(vec.begin(), vec.end());
+  list<int> large_lst(1000000);
+  map<int, int> large_map;
+  for (int i = 0; i < 1000000; ++i) large_map.emplace_hint(large_map.end(), i, i);
+
+  walk(vec, iterations);
+
+  run("vector | front(50)", vec, cp::front(50), iterations);
+  run("vector | back(10)", vec, cp::back(10), iterations);
+  run("vector | both_ends(5)", vec, cp::both_ends(5), iterations);
+  run("vector | middle(10)", vec, cp::middle(10), iterations);
+  run("list | back(10)", lst, cp::back(10), iterations);
+  run("list | both_ends(5)", lst, cp::both_ends(5), iterations);
+  run("list(1M) | back(5)", large_lst, cp::back(5), iterations);
+  run("map(1M) | back(5)", large_map, cp::back(5), iterations);
+  run("map(1M) | both_ends(5)", large_map, cp::both_ends(5), iterations);
+
+  return 0;
+}
@@ -0,0 +1,58 @@
+// Exports a multi-megabyte payload with and without cp::stresc().
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+
+#include "../cpp-dump.hpp"
+
+//
+using namespace std;
+namespace cp = cpp_dump;
+
+template <typename F>
+void run(const string &name, size_t bytes, int iterations, F f) {
+  size_t length = 0;
+  auto start = chrono::steady_clock::now();
+  for (int i = 0; i < iterations; ++i) length += f();
+  auto end = chrono::steady_clock::now();
+  if (length == 0) abort();
+
+  auto us = chrono::duration_cast<chrono::microseconds>(end - start).count();
+  cout << name << ": " << static_cast<double>(bytes) * iterations / static_cast<double>(us)
+       << " MB/s" << endl;
+}
+
+int main(int argc, char *argv[]) {
+  int iterations = argc >= 2 ? stoi(argv[1]) : 20;
+  CPP_DUMP_SET_OPTION(es_style, cp::types::es_style_t::no_es);
+
+  // Printable text with a byte that needs escaping about every 200 bytes.
+  mt19937 engine(1);
+  string payload(4 << 20, ' ');
+  for (auto &c : payload) {
+    c = static_cast<char>(engine() % 200 == 0 ? engine() % 32 : 'a' + engine() % 26);
+  }
+  // The same text with no byte that needs escaping and no newline.
+  string plain = payload;
+  for (auto &c : plain) {
+    if (c < ' ') c = '.';
+  }
+
+  run("stresc(), es_style=no_es      ", payload.size(), iterations, [&] {
+    return cp::export_var(cp::stresc() << payload).size();
+  });
+  run("plain string, es_style=no_es  ", plain.size(), iterations, [&] {
+    return cp::export_var(plain).size();
+  });
+
+  CPP_DUMP_SET_OPTION(es_style, cp::types::es_style_t::original);
+  run("stresc(), es_style=original   ", payload.size(), iterations, [&] {
+    return cp::export_var(cp::stresc() << payload).size();
+  });
+  run("plain string, es_style=original", plain.size(), iterations, [&] {
+    return cp::export_var(plain).size();
+  });
+}
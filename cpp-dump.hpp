@@ -9,18 +9,33 @@
 
 #include <algorithm>
 #include <array>
+#include <chrono>
 #include <functional>
 #include <initializer_list>
 #include <iostream>
+#include <memory>
+#include <optional>
 #include <string>
 #include <string_view>
+#include <tuple>
 #include <type_traits>
 
+#include "./cpp-dump/hpp/arena.hpp"
+#include "./cpp-dump/hpp/async_log.hpp"
+#include "./cpp-dump/hpp/binary_log.hpp"
+#include "./cpp-dump/hpp/call_site.hpp"
+#include "./cpp-dump/hpp/capture.hpp"
+#include "./cpp-dump/hpp/document/document.hpp"
+#include "./cpp-dump/hpp/document/layout.hpp"
+#include "./cpp-dump/hpp/document/token_table.hpp"
+#include "./cpp-dump/hpp/document/writer.hpp"
 #include "./cpp-dump/hpp/escape_sequence.hpp"
 #include "./cpp-dump/hpp/expand_va_macro.hpp"
 #include "./cpp-dump/hpp/export_command/export_command.hpp"
 #include "./cpp-dump/hpp/export_var/export_var.hpp"
+#include "./cpp-dump/hpp/fd_log.hpp"
 #include "./cpp-dump/hpp/options.hpp"
+#include "./cpp-dump/hpp/sampling.hpp"
 #include "./cpp-dump/hpp/utility.hpp"
 
 #define _p_CPP_DUMP_STRINGIFY(x) #x
@@ -35,12 +50,84 @@
  * If you want to change the output, define an explicit specialization of cpp_dump::write_log().
  * This macro uses cpp_dump::export_var() internally.
  */
-#define cpp_dump(...)                                                                              \
-  cpp_dump::_detail::cpp_dump_macro<                                                               \
-      cpp_dump::_detail::to_size_t(_p_CPP_DUMP_VA_SIZE(__VA_ARGS__)),                             \
-      _p_CPP_DUMP_CONTAINS_VARIADIC_TEMPLATE(__VA_ARGS__)>(                                        \
-      {__FILE__, __LINE__, __func__},                                                              \
-      {_p_CPP_DUMP_EXPAND_VA(_p_CPP_DUMP_STRINGIFY, __VA_ARGS__)},                                 \
+#define cpp_dump(...) _p_CPP_DUMP_CALL(0, __VA_ARGS__)
+
+/**
+ * The levels of cpp_dump_trace(), cpp_dump_debug() and cpp_dump_info().
+ * Define CPP_DUMP_LEVEL before including this header to remove the calls below it at compile time.
+ * The removed calls evaluate, stringify and instantiate nothing.
+ */
+#define CPP_DUMP_LEVEL_TRACE 0
+#define CPP_DUMP_LEVEL_DEBUG 1
+#define CPP_DUMP_LEVEL_INFO 2
+#define CPP_DUMP_LEVEL_OFF 3
+
+#if !defined(CPP_DUMP_LEVEL)
+#define CPP_DUMP_LEVEL CPP_DUMP_LEVEL_TRACE
+#endif
+
+// The arguments are only named in an unevaluated operand so that they are not reported as unused.
+#define _p_CPP_DUMP_DISABLED(...) ((void)sizeof(cpp_dump::_detail::disabled_dump(__VA_ARGS__)))
+
+/**
+ * cpp_dump() with a level, which expands to nothing if the level is below CPP_DUMP_LEVEL.
+ */
+#if CPP_DUMP_LEVEL <= CPP_DUMP_LEVEL_TRACE
+#define cpp_dump_trace(...) cpp_dump(__VA_ARGS__)
+#else
+#define cpp_dump_trace(...) _p_CPP_DUMP_DISABLED(__VA_ARGS__)
+#endif
+
+#if CPP_DUMP_LEVEL <= CPP_DUMP_LEVEL_DEBUG
+#define cpp_dump_debug(...) cpp_dump(__VA_ARGS__)
+#else
+#define cpp_dump_debug(...) _p_CPP_DUMP_DISABLED(__VA_ARGS__)
+#endif
+
+#if CPP_DUMP_LEVEL <= CPP_DUMP_LEVEL_INFO
+#define cpp_dump_info(...) cpp_dump(__VA_ARGS__)
+#else
+#define cpp_dump_info(...) _p_CPP_DUMP_DISABLED(__VA_ARGS__)
+#endif
+
+/**
+ * Print like cpp_dump() only the calls that policy chooses, such as cpp_dump::sampling::first(n),
+ * every(n), per_second(k) and probability(p).
+ * The policy is kept in a static variable of the call site.
+ * The arguments are not evaluated if the call is skipped, and the number of the skipped calls is
+ * printed in the label of the next printed call.
+ */
+#define cpp_dump_sampled(policy, ...)                                                              \
+  do {                                                                                             \
+    static auto _p_cpp_dump_sampler = policy;                                                      \
+    if (std::size_t _p_cpp_dump_suppressed = 0;                                                    \
+        _p_cpp_dump_sampler.sample(_p_cpp_dump_suppressed)) {                                      \
+      _p_CPP_DUMP_CALL(_p_cpp_dump_suppressed, __VA_ARGS__);                                       \
+    }                                                                                              \
+  } while (false)
+
+/**
+ * cpp_dump() with the options of a cpp_dump::dumper.
+ */
+#define cpp_dump_with(dumper, ...)                                                                 \
+  do {                                                                                             \
+    auto _p_cpp_dump_dumper_scope = (dumper).scope();                                              \
+    _p_CPP_DUMP_CALL(0, __VA_ARGS__);                                                              \
+  } while (false)
+
+// The call_site is a static variable of a lambda because cpp_dump() is an expression.
+#define _p_CPP_DUMP_CALL(suppressed, ...)                                                          \
+  cpp_dump::_detail::cpp_dump_macro<_p_CPP_DUMP_CONTAINS_VARIADIC_TEMPLATE(__VA_ARGS__)>(          \
+      []() -> auto & {                                                                             \
+        static cpp_dump::_detail::call_site<                                                       \
+            cpp_dump::_detail::to_size_t(_p_CPP_DUMP_VA_SIZE(__VA_ARGS__))>                        \
+            _p_cpp_dump_site(                                                                      \
+                __FILE__, __LINE__, {_p_CPP_DUMP_EXPAND_VA(_p_CPP_DUMP_STRINGIFY, __VA_ARGS__)}    \
+            );                                                                                     \
+        return _p_cpp_dump_site;                                                                   \
+      }(),                                                                                         \
+      __func__,                                                                                    \
+      suppressed,                                                                                  \
       __VA_ARGS__                                                                                  \
   )
 
@@ -57,14 +144,26 @@ namespace cpp_dump {
 /**
  * cpp_dump() uses this function to print logs.
  * Define an explicit specialization with 'void' to customize this function.
+ * After cpp_dump::start_async_log(), this queues the logs for the background thread, and after
+ * cpp_dump::start_fd_log(), this writes them to the file descriptor.
  */
 template <typename = void>
 void write_log(std::string_view output) {
+  if (auto *logger = _detail::active_async_logger().load(std::memory_order_acquire)) {
+    logger->push({std::string(output), nullptr});
+    return;
+  }
+  if (int fd = _detail::active_log_fd().load(std::memory_order_acquire); fd >= 0) {
+    _detail::write_fd_log(fd, output);
+    return;
+  }
   std::clog << output << std::endl;
 }
 
 namespace _detail {
 
+inline namespace _p_CPP_DUMP_ES_NAMESPACE {
+
 // Helper function to safely convert any integral type to std::size_t for C++23 compatibility
 template<typename T>
 constexpr std::size_t to_size_t(T value) noexcept {
@@ -76,72 +175,71 @@ constexpr std::size_t to_size_t(T value) noexcept {
   }
 }
 
-template <typename T>
-bool _dump_one(
-    std::string &output,
-    const std::string &label,
+inline bool _dump_one(
+    writer &output,
+    const atom &label,
+    std::size_t label_indent,
     bool always_newline_before_expr,
-    std::string_view expr,
-    const T &value
+    std::string_view expr_with_es,
+    const doc_node &value,
+    render_cache &cache,
+    const token_table &tokens
 ) {
-  const std::string initial_indent(get_last_line_length(label), ' ');
-  const std::string second_indent = initial_indent + "  ";
+  const auto initial_indent = make_temp_string(label_indent, ' ');
+  const auto second_indent = concat(initial_indent, "  ");
   const bool fail_on_newline_in_value = !always_newline_before_expr;
 
-  if (output.length() == 0) {
-    output = es::reset() + es::log(label);
+  if (output.empty()) {
+    output.append(label);
   } else {
     if (always_newline_before_expr) {
-      output += es::log(",\n") + initial_indent;
+      output.append(tokens.log_comma_newline);
+      output.append(initial_indent, initial_indent.size());
     } else {
-      output += es::log(", ");
+      output.append(tokens.log_comma);
     }
   }
 
   struct prefix_and_value_str {
-    std::string prefix;
-    std::string value_str;
+    atom prefix;
+    writer value_str;
     bool value_str_has_newline;
     bool over_max_line_width;
   };
   auto make_prefix_and_value_str = [&, fail_on_newline_in_value](
-                                       const std::string &prefix, const std::string &indent
+                                       temp_string prefix_str, std::string_view indent
                                    ) -> prefix_and_value_str {
-    auto last_line_length = get_last_line_length(output + prefix);
-    std::string value_str = export_var(
-        value,
-        indent,
-        last_line_length,
-        0,
-        fail_on_newline_in_value,
-        export_command::default_command
-    );
-    bool value_str_has_newline = has_newline(value_str);
-    bool over_max_line_width =
-        last_line_length + get_first_line_length(value_str) > options::max_line_width;
-    return {prefix, value_str, value_str_has_newline, over_max_line_width};
+    atom prefix(std::move(prefix_str));
+    auto last_line_length =
+        prefix.has_newline ? prefix.last_line_length : output.column() + prefix.length();
+    writer value_str(last_line_length);
+    layout(value, value_str, indent, fail_on_newline_in_value, cache);
+    bool value_str_has_newline = value_str.has_newline();
+    bool over_max_line_width = value_str.first_line_length() > current_options().max_line_width;
+    return {std::move(prefix), std::move(value_str), value_str_has_newline, over_max_line_width};
   };
 
   auto append_output = [&](const prefix_and_value_str &pattern) -> void {
-    output += pattern.prefix + pattern.value_str;
+    output.append(pattern.prefix);
+    output.append(pattern.value_str);
   };
 
-  if (!options::print_expr) {
+  if (!current_options().print_expr) {
     // Patterns:
     // 1=Don't insert a line break before dumping a variable.
     // 2=Insert a line break before dumping a variable.
-    auto pattern1 = make_prefix_and_value_str("", initial_indent);
+    auto pattern1 = make_prefix_and_value_str(make_temp_string(), initial_indent);
     if (!(fail_on_newline_in_value
           && (pattern1.value_str_has_newline || pattern1.over_max_line_width))) {
       append_output(pattern1);
       return true;
     }
 
-    if (get_last_line_length(output) <= initial_indent.length()) {
+    if (output.column() <= initial_indent.length()) {
       return false;
     }
 
-    auto pattern2 = make_prefix_and_value_str("\n" + initial_indent, initial_indent);
+    auto pattern2 = make_prefix_and_value_str(concat("\n", initial_indent), initial_indent);
     if (pattern2.value_str_has_newline || pattern2.over_max_line_width) {
       return false;
     }
@@ -149,8 +247,6 @@ bool _dump_one(
     return true;
   }
 
-  auto expr_with_es = es::expression(expr);
-
   // Patterns:
   // 1=Don't insert a line break before `expr`.
   // 2=Insert a line break before `expr`.
@@ -158,15 +254,16 @@ bool _dump_one(
   // b=Insert a line break between `expr` and " => ".
 
   if (fail_on_newline_in_value) {
-    auto pattern1a = make_prefix_and_value_str(expr_with_es + es::log(" => "), initial_indent);
+    auto pattern1a =
+        make_prefix_and_value_str(concat(expr_with_es, tokens.log_arrow.str), initial_indent);
     if (!(pattern1a.value_str_has_newline || pattern1a.over_max_line_width)) {
       append_output(pattern1a);
       return true;
     }
 
-    if (get_last_line_length(output) <= initial_indent.length()) {
+    if (output.column() <= initial_indent.length()) {
       auto pattern1b = make_prefix_and_value_str(
-          expr_with_es + "\n" + second_indent + es::log("=> "), second_indent
+          concat(expr_with_es, "\n", second_indent, tokens.log_arrow_newline.str), second_indent
       );
       if (pattern1b.value_str_has_newline) {
         return false;
@@ -176,7 +273,7 @@ bool _dump_one(
     }
 
     auto pattern2a = make_prefix_and_value_str(
-        "\n" + initial_indent + expr_with_es + es::log(" => "), initial_indent
+        concat("\n", initial_indent, expr_with_es, tokens.log_arrow.str), initial_indent
     );
     if (!(pattern2a.value_str_has_newline || pattern2a.over_max_line_width)) {
       append_output(pattern2a);
@@ -184,7 +281,10 @@ bool _dump_one(
     }
 
     auto pattern2b = make_prefix_and_value_str(
-        "\n" + initial_indent + expr_with_es + "\n" + second_indent + es::log("=> "), second_indent
+        concat(
+            "\n", initial_indent, expr_with_es, "\n", second_indent, tokens.log_arrow_newline.str
+        ),
+        second_indent
     );
     if (pattern2b.value_str_has_newline) {
       return false;
@@ -193,10 +293,11 @@ bool _dump_one(
     return true;
   }
 
-  auto pattern1a = make_prefix_and_value_str(expr_with_es + es::log(" => "), initial_indent);
+  auto pattern1a =
+      make_prefix_and_value_str(concat(expr_with_es, tokens.log_arrow.str), initial_indent);
   if (pattern1a.over_max_line_width) {
     auto pattern1b = make_prefix_and_value_str(
-        expr_with_es + "\n" + second_indent + es::log("=> "), second_indent
+        concat(expr_with_es, "\n", second_indent, tokens.log_arrow_newline.str), second_indent
     );
     append_output(pattern1b);
     return true;
@@ -207,7 +308,7 @@ bool _dump_one(
   }
 
   auto pattern1b = make_prefix_and_value_str(
-      expr_with_es + "\n" + second_indent + es::log("=> "), second_indent
+      concat(expr_with_es, "\n", second_indent, tokens.log_arrow_newline.str), second_indent
   );
   if (pattern1b.value_str_has_newline) {
     append_output(pattern1a);
@@ -217,25 +318,46 @@ bool _dump_one(
   return true;
 }
 
-template <bool is_va_temp, typename... Args>
+// values is a std::array or a std::pmr::vector of the nodes of the arguments.
+template <typename Values>
 bool _dump(
-    std::string &output,
-    const std::string &label,
+    writer &output,
+    const atom &label,
+    std::size_t label_indent,
     bool always_newline_before_expr,
-    std::initializer_list<std::string_view> exprs,
-    const Args &...args
+    const site_labels &labels,
+    const Values &values,
+    render_cache &cache,
+    const token_table &tokens
 ) {
-  if constexpr (is_va_temp) {
-    std::string_view first_arg_name = *exprs.begin();
-    std::size_t i = 0;
-    auto expr = [&]() -> std::string {
-      return std::string(first_arg_name) + "[" + std::to_string(i++) + "]";
-    };
-    return (_dump_one(output, label, always_newline_before_expr, expr(), args) && ...);
-  } else {
-    auto it = exprs.begin();
-    return (_dump_one(output, label, always_newline_before_expr, *it++, args) && ...);
+  const bool print_expr = current_options().print_expr;
+  for (std::size_t i = 0; i < values.size(); ++i) {
+    bool ok;
+    if (!print_expr) {
+      // The expressions are not printed, and labels may have none, like those of a dumper.
+      ok = _dump_one(
+          output, label, label_indent, always_newline_before_expr, "", *values[i], cache, tokens
+      );
+    } else if (labels.is_va_temp) {
+      auto expr = es::expression(concat(labels.va_temp_name, "[", std::to_string(i), "]"));
+      ok = _dump_one(
+          output, label, label_indent, always_newline_before_expr, expr, *values[i], cache, tokens
+      );
+    } else {
+      ok = _dump_one(
+          output,
+          label,
+          label_indent,
+          always_newline_before_expr,
+          labels.exprs_with_es[i].str,
+          *values[i],
+          cache,
+          tokens
+      );
+    }
+    if (!ok) return false;
   }
+  return true;
 }
 
 // in C++17, std::initializer_list is not a literal type.
@@ -250,16 +372,106 @@ constexpr bool contains_variadic_template(std::array<std::string_view, N> exprs)
   return false;
 }
 
-struct _source_location {
-  std::string_view file_name;
-  std::size_t line;
-  std::string_view function_name;
+// Pass the output of cpp_dump() to write(std::string_view).
+// labels are the label and the expressions of the call site, and export_values(doc) exports the
+// arguments to doc and returns their nodes.
+// suppressed is the number of the calls that cpp_dump_sampled() skipped before this one.
+template <typename Write, typename ExportValues>
+void _render_values(
+    const site_labels &labels,
+    std::size_t suppressed,
+    Write &&write,
+    ExportValues &&export_values
+) {
+  // Every temporary of this call comes from the dump_arena of this thread.
+  dump_scope scope;
+  dump_options_scope resolved_options;
+
+  const atom *label = &labels.label;
+  std::size_t label_indent = labels.label_indent;
+  atom suppressed_label;
+  if (suppressed > 0) {
+    auto raw_label =
+        concat(labels.raw_label, "(", decimal_chars(suppressed).view(), " suppressed) ");
+    suppressed_label = atom(concat(es::reset(), es::log(raw_label)));
+    label = &suppressed_label;
+    label_indent = get_last_line_length(raw_label);
+  }
+  bool exprs_have_newline = current_options().print_expr && labels.exprs_have_newline;
+
+  // Export the arguments only once. The layout is decided for each pattern below.
+  document doc;
+  render_cache cache;
+  const auto values = export_values(doc);
+
+  // First, try dumping with always_newline_before_expr=false
+  // On error, dump with always_newline_before_expr=true
+  writer output;
+  const auto &tokens = doc.tokens();
+  if (exprs_have_newline
+      || !_dump(output, *label, label_indent, false, labels, values, cache, tokens)) {
+    output.clear();
+    _dump(output, *label, label_indent, true, labels, values, cache, tokens);
+  }
+  write(std::string_view(output.str()));
+}
+
+template <typename Write, typename... Args>
+void _render_dump(
+    const site_labels &labels, std::size_t suppressed, Write &&write, const Args &...args
+) {
+  _render_values(labels, suppressed, write, [&](document &doc) {
+    return std::array<const doc_node *, sizeof...(Args)>{
+        &export_var(args, 0, export_command::default_command, doc)...};
+  });
+}
+
+/*
+ * The copies of the arguments of cpp_dump(), formatted later by the background thread of
+ * start_async_log().
+ * The labels are resolved by the thread that called cpp_dump(), so log_label_func is called at the
+ * time of the call, on that thread.
+ */
+template <typename... Captured>
+struct _deferred_dump final : deferred_log {
+ public:
+  _deferred_dump(
+      std::shared_ptr<const site_labels> labels, std::size_t suppressed, Captured &&...captured
+  )
+      : _labels(std::move(labels)), _suppressed(suppressed), _values(std::move(captured)...) {}
+
+  void render(std::string &text) const override {
+    std::apply(
+        [&](const auto &...values) {
+          _render_dump(
+              *_labels,
+              _suppressed,
+              [&](std::string_view output) { text.assign(output); },
+              values...
+          );
+        },
+        _values
+    );
+  }
+
+ private:
+  std::shared_ptr<const site_labels> _labels;
+  std::size_t _suppressed;
+  std::tuple<Captured...> _values;
 };
 
+// function named by the disabled cpp_dump_trace(), cpp_dump_debug() and cpp_dump_info()
+// It is never defined because it is only used in an unevaluated operand.
+template <typename... Args>
+int disabled_dump(const Args &...);
+
 // function called by cpp_dump() macro
-template <std::size_t va_macro_size, bool contains_va_temp, typename... Args>
+template <bool contains_va_temp, std::size_t va_macro_size, typename... Args>
 void cpp_dump_macro(
-    _source_location loc, std::initializer_list<std::string_view> exprs, const Args &...args
+    call_site<va_macro_size> &site,
+    std::string_view function_name,
+    std::size_t suppressed,
+    const Args &...args
 ) {
   constexpr bool is_va_temp = va_macro_size == 1 && contains_va_temp;
   static_assert(
@@ -269,24 +481,157 @@ void cpp_dump_macro(
       "If you are passing variadic template arguments, do not pass any additional arguments."
   );
 
-  // label is the part of "[dump] ".
-  std::string label;
-  if (options::log_label_func) {
-    label = options::log_label_func(loc.file_name, loc.line, loc.function_name);
+  // Every step below uses the options resolved here.
+  dump_options_scope resolved_options;
+
+  // Write a binary record instead of the text after start_binary_log().
+  if (auto *binary_logger = active_binary_logger().load(std::memory_order_acquire)) {
+    write_binary_log(
+        *binary_logger,
+        site.file_name(),
+        site.line(),
+        function_name,
+        is_va_temp,
+        site.exprs(),
+        suppressed,
+        args...
+    );
+    return;
   }
-  bool exprs_have_newline =
-      options::print_expr && std::any_of(exprs.begin(), exprs.end(), has_newline);
 
-  // First, try dumping with always_newline_before_expr=false
-  // On error, dump with always_newline_before_expr=true
-  std::string output;
-  if (exprs_have_newline || !_dump<is_va_temp>(output, label, false, exprs, args...)) {
-    output.clear();
-    _dump<is_va_temp>(output, label, true, exprs, args...);
+  // Copy the arguments and let the background thread format them, if it can.
+  // The background thread formats them with the global options, so the dumps with other options
+  // format them here.
+  if constexpr ((is_capturable<Args> && ...)) {
+    auto *logger = active_async_logger().load(std::memory_order_acquire);
+    if (logger && logger->defers_formatting() && dump_uses_global_options()) {
+      logger->push(
+          {std::string(),
+           std::make_unique<_deferred_dump<decltype(capture(args))...>>(
+               site.shared_labels(function_name, is_va_temp), suppressed, capture(args)...
+           )}
+      );
+      return;
+    }
   }
-  write_log(output);
+
+  _render_dump(
+      site.labels(function_name, is_va_temp),
+      suppressed,
+      [](std::string_view output) { write_log(output); },
+      args...
+  );
 }
 
+}  // namespace _p_CPP_DUMP_ES_NAMESPACE
+
 }  // namespace _detail
 
+inline namespace _p_CPP_DUMP_ES_NAMESPACE {
+
+/**
+ * Print the text of each record of a stream of cpp_dump::start_binary_log().
+ * write(const cpp_dump::types::binary_log_record_t &) is called for each record with the output
+ * that cpp_dump() would have made with the current options, such as max_line_width and es_style.
+ * Return false if the stream is broken or truncated.
+ */
+template <typename Write>
+bool replay_binary_log(std::string_view stream, Write &&write) {
+  _detail::binary_log_reader reader(stream);
+  // The records of a dumper, whose site has no expressions, are printed without them.
+  std::optional<types::options_snapshot_t> without_expr;
+  std::shared_ptr<const _detail::token_table> tokens;
+  while (reader.next()) {
+    const auto &site = reader.current_site();
+    std::optional<_detail::dumper_scope> dumper;
+    if (site.exprs.empty() && !site.is_va_temp) {
+      if (!without_expr) {
+        without_expr = _detail::current_options();
+        without_expr->print_expr = false;
+        tokens = _detail::token_table::current();
+      }
+      dumper.emplace(*without_expr, tokens.get());
+    }
+    _detail::_render_values(
+        _detail::site_labels(
+            site.file_name, site.line, site.function_name, site.exprs, site.is_va_temp
+        ),
+        reader.suppressed(),
+        [&](std::string_view text) {
+          write(types::binary_log_record_t{reader.time(), reader.thread(), text});
+        },
+        [&](_detail::document &doc) { return reader.export_values(doc); }
+    );
+  }
+  return !reader.broken();
+}
+
+/**
+ * A set of options fixed when the dumper is constructed.
+ * The snapshot, which is a copy of cpp_dump::options namespace by default, is stored in the
+ * dumper, and its dumps read it at run time like those of cpp_dump() in an options_scope.
+ * A dumper never changes, so the threads can share one, and its dumps skip copying the variables
+ * in cpp_dump::options namespace and building the colored tokens and the label.
+ */
+struct dumper {
+ public:
+  explicit dumper(types::options_snapshot_t options = types::options_snapshot_t())
+      : _options(std::move(options)), _values_options(_options) {
+    _values_options.print_expr = false;
+    _detail::dumper_scope building(_values_options, nullptr);
+    _tokens = _detail::token_table::build();
+    if (_values_options.log_label_func.cached()) _labels = _make_labels();
+  }
+
+  /**
+   * Print the values like cpp_dump() with print_expr = false, since a function cannot see the
+   * expressions. Use cpp_dump_with() to print the expressions too.
+   * log_label_func is called with an empty file name, line 0 and an empty function name.
+   */
+  template <typename... Args>
+  void operator()(const Args &...args) const {
+    _detail::dumper_scope values_scope(_values_options, _tokens.get());
+    if (auto *binary_logger = _detail::active_binary_logger().load(std::memory_order_acquire)) {
+      _detail::write_binary_log(
+          *binary_logger,
+          "",
+          0,
+          "",
+          false,
+          std::array<std::string_view, 0>{},
+          0,
+          args...
+      );
+      return;
+    }
+    _detail::_render_dump(
+        _labels ? *_labels : *_make_labels(),
+        0,
+        [](std::string_view output) { write_log(output); },
+        args...
+    );
+  }
+
+  /**
+   * Make cpp_dump() and cpp_dump::export_var() on the current thread use the options of this
+   * dumper until the returned guard is destroyed.
+   */
+  _detail::dumper_scope scope() const { return _detail::dumper_scope(_options, _tokens.get()); }
+
+ private:
+  types::options_snapshot_t _options;
+  types::options_snapshot_t _values_options;
+  std::shared_ptr<const _detail::token_table> _tokens;
+  // The label of operator(), or nullptr if log_label_func is uncached.
+  std::shared_ptr<const _detail::site_labels> _labels;
+
+  static std::shared_ptr<const _detail::site_labels> _make_labels() {
+    return std::make_shared<const _detail::site_labels>(
+        "", 0, "", std::array<std::string_view, 0>{}, false
+    );
+  }
+};
+
+}  // namespace _p_CPP_DUMP_ES_NAMESPACE
+
 }  // namespace cpp_dump
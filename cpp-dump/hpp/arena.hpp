@@ -0,0 +1,147 @@
+/*
+ * Copyright (c) 2023 Ryota Sasaki.
+ *
+ * This source code is licensed under the MIT license found in the LICENSE file in the root
+ * directory of this source tree.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <optional>
+#include <string>
+#include <string_view>
+
+// The largest buffer a thread keeps for its dumps. Define it to change the limit.
+#ifndef CPP_DUMP_ARENA_MAX_CAPACITY
+#define CPP_DUMP_ARENA_MAX_CAPACITY (std::size_t{1} << 20)
+#endif
+
+namespace cpp_dump {
+
+namespace _detail {
+
+/*
+ * The memory for the temporaries of one cpp_dump() or export_var() call.
+ * While a dump_scope is alive, resource() hands out memory from a monotonic buffer, which is
+ * released all at once when the outermost scope ends.
+ * The buffer belongs to the thread and is reused by the next call. If a call needs more than
+ * the buffer, the buffer grows when the call ends, so repeating the same call allocates nothing.
+ * The buffer never grows beyond max_capacity, so a single large dump does not pin its peak memory
+ * for the life of the thread; what it needs beyond that is freed when it ends.
+ */
+struct dump_arena {
+ public:
+  dump_arena() = default;
+  dump_arena(const dump_arena &) = delete;
+  dump_arena &operator=(const dump_arena &) = delete;
+
+  // The arena of this thread.
+  static dump_arena &get() {
+    thread_local dump_arena arena;
+    return arena;
+  }
+
+  // The resource for the temporaries. Outside of a dump_scope, this is the default resource.
+  static std::pmr::memory_resource *resource() {
+    auto &arena = get();
+    return arena._monotonic ? &*arena._monotonic : std::pmr::get_default_resource();
+  }
+
+  static constexpr std::size_t max_capacity = CPP_DUMP_ARENA_MAX_CAPACITY;
+
+  std::size_t capacity() const { return _capacity; }
+
+  // Whether a dump_scope is alive on this thread.
+  bool in_scope() const { return _depth > 0; }
+
+  void begin() {
+    if (_depth++ > 0) {
+      return;
+    }
+    _upstream.requested = 0;
+    if (_capacity > 0) {
+      _monotonic.emplace(_buffer.get(), _capacity, &_upstream);
+    } else {
+      _monotonic.emplace(&_upstream);
+    }
+  }
+
+  void end() {
+    if (--_depth > 0) {
+      return;
+    }
+    _monotonic.reset();
+    if (_upstream.requested > 0 && _capacity < max_capacity) {
+      // Make the buffer large enough for this call so that the next one fits.
+      _capacity = std::min(_capacity + _upstream.requested, max_capacity);
+      _buffer = std::make_unique<std::byte[]>(_capacity);
+    }
+  }
+
+ private:
+  // Counts the memory the monotonic buffer needs beyond the buffer of the thread.
+  struct counting_resource : std::pmr::memory_resource {
+   public:
+    std::size_t requested = 0;
+
+   private:
+    void *do_allocate(std::size_t bytes, std::size_t alignment) override {
+      requested += bytes;
+      return std::pmr::get_default_resource()->allocate(bytes, alignment);
+    }
+    void do_deallocate(void *p, std::size_t bytes, std::size_t alignment) override {
+      std::pmr::get_default_resource()->deallocate(p, bytes, alignment);
+    }
+    bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override {
+      return this == &other;
+    }
+  };
+
+  std::unique_ptr<std::byte[]> _buffer;
+  std::size_t _capacity = 0;
+  std::size_t _depth = 0;
+  counting_resource _upstream;
+  std::optional<std::pmr::monotonic_buffer_resource> _monotonic;
+};
+
+/*
+ * RAII guard that makes the temporaries of the current thread come from its dump_arena.
+ * Scopes may nest (e.g. operator<<() of an exported value calls cpp_dump()), and the memory is
+ * released when the outermost one ends, so no temporary may outlive the outermost scope.
+ */
+struct dump_scope {
+ public:
+  dump_scope() { dump_arena::get().begin(); }
+  ~dump_scope() { dump_arena::get().end(); }
+  dump_scope(const dump_scope &) = delete;
+  dump_scope &operator=(const dump_scope &) = delete;
+};
+
+// A string that lives no longer than a dump.
+using temp_string = std::pmr::string;
+
+inline temp_string make_temp_string(std::string_view s = {}) {
+  return temp_string(s, dump_arena::resource());
+}
+
+inline temp_string make_temp_string(std::size_t count, char c) {
+  return temp_string(count, c, dump_arena::resource());
+}
+
+// Concatenate the strings into one temp_string.
+// Unlike operator+(), this never copies a temp_string into the default resource.
+template <typename... Args>
+inline temp_string concat(const Args &...args) {
+  auto retval = make_temp_string();
+  retval.reserve((std::string_view(args).size() + ...));
+  (retval.append(std::string_view(args)), ...);
+  return retval;
+}
+
+}  // namespace _detail
+
+}  // namespace cpp_dump
@@ -0,0 +1,384 @@
+/*
+ * Copyright (c) 2023 Ryota Sasaki.
+ *
+ * This source code is licensed under the MIT license found in the LICENSE file in the root
+ * directory of this source tree.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#if defined(_WIN32)
+#include <io.h>
+#else
+#include <cerrno>
+#include <climits>
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+
+#include "./options.hpp"
+
+namespace cpp_dump {
+
+namespace _detail {
+
+/*
+ * A record whose text is rendered later by the background thread of start_async_log().
+ */
+struct deferred_log {
+ public:
+  virtual ~deferred_log() = default;
+  virtual void render(std::string &text) const = 0;
+};
+
+struct log_record {
+ public:
+  std::string text;
+  // If not null, the text is rendered from this by the background thread.
+  std::unique_ptr<deferred_log> deferred;
+};
+
+/*
+ * A bounded queue of log records that any thread can push to and pop from without a lock.
+ * Each cell has a sequence number that tells whether it is ready to be written or read, so the
+ * producers only contend on the position where they push.
+ * The consumer is the background thread, but a producer also pops when it drops the oldest record.
+ */
+struct log_ring {
+ public:
+  // The capacity is rounded up to a power of two.
+  explicit log_ring(std::size_t capacity) {
+    std::size_t size = 2;
+    while (size < capacity) size *= 2;
+    _cells = std::make_unique<cell[]>(size);
+    _mask = size - 1;
+    for (std::size_t i = 0; i < size; ++i) _cells[i].sequence.store(i, std::memory_order_relaxed);
+  }
+
+  log_ring(const log_ring &) = delete;
+  log_ring &operator=(const log_ring &) = delete;
+
+  std::size_t capacity() const noexcept { return _mask + 1; }
+
+  // Move the record into the queue, or return false if the queue is full.
+  bool try_push(log_record &record) {
+    std::size_t pos = _push_pos.load(std::memory_order_relaxed);
+    while (true) {
+      cell &c = _cells[pos & _mask];
+      std::size_t sequence = c.sequence.load(std::memory_order_acquire);
+      auto diff = static_cast<std::ptrdiff_t>(sequence - pos);
+      if (diff == 0) {
+        if (_push_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+          c.record = std::move(record);
+          c.sequence.store(pos + 1, std::memory_order_release);
+          return true;
+        }
+      } else if (diff < 0) {
+        return false;
+      } else {
+        pos = _push_pos.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  // Move the oldest record out of the queue, or return false if the queue is empty.
+  bool try_pop(log_record &record) {
+    std::size_t pos = _pop_pos.load(std::memory_order_relaxed);
+    while (true) {
+      cell &c = _cells[pos & _mask];
+      std::size_t sequence = c.sequence.load(std::memory_order_acquire);
+      auto diff = static_cast<std::ptrdiff_t>(sequence - (pos + 1));
+      if (diff == 0) {
+        if (_pop_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+          record = std::move(c.record);
+          c.sequence.store(pos + _mask + 1, std::memory_order_release);
+          return true;
+        }
+      } else if (diff < 0) {
+        return false;
+      } else {
+        pos = _pop_pos.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  bool empty() const noexcept {
+    std::size_t pos = _pop_pos.load(std::memory_order_relaxed);
+    return _cells[pos & _mask].sequence.load(std::memory_order_acquire) != pos + 1;
+  }
+
+ private:
+  struct cell {
+    std::atomic<std::size_t> sequence;
+    log_record record;
+  };
+
+  std::unique_ptr<cell[]> _cells;
+  std::size_t _mask;
+  // The positions are on separate cache lines so that the producers and the consumer do not
+  // invalidate each other's line.
+  alignas(64) std::atomic<std::size_t> _push_pos{0};
+  alignas(64) std::atomic<std::size_t> _pop_pos{0};
+};
+
+#if !defined(_WIN32)
+/*
+ * Write the buffers to the file descriptor with writev(), retrying after a partial write or an
+ * interruption. The buffers in iov are advanced past the part written.
+ */
+inline void write_iovecs(int fd, iovec *iov, std::size_t iov_count) {
+  static constexpr std::size_t max_iov = IOV_MAX < 1024 ? IOV_MAX : 1024;
+  std::size_t first = 0;
+  while (first < iov_count) {
+    auto count = static_cast<int>(std::min(iov_count - first, max_iov));
+    ssize_t written = ::writev(fd, iov + first, count);
+    if (written < 0) {
+      if (errno == EINTR) continue;
+      return;
+    }
+    // Skip the buffers written, and the part written of the next one.
+    auto rest = static_cast<std::size_t>(written);
+    while (first < iov_count && rest >= iov[first].iov_len) rest -= iov[first++].iov_len;
+    if (rest > 0) {
+      iov[first].iov_base = static_cast<char *>(iov[first].iov_base) + rest;
+      iov[first].iov_len -= rest;
+    }
+  }
+}
+#endif
+
+/*
+ * Write the buffers to the file descriptor, retrying after a partial write or an interruption.
+ * Each record is followed by a newline, as std::endl does.
+ */
+inline void write_records(int fd, const std::vector<std::string> &records) {
+#if defined(_WIN32)
+  for (const auto &record : records) {
+    ::_write(fd, record.data(), static_cast<unsigned int>(record.size()));
+    ::_write(fd, "\n", 1);
+  }
+#else
+  static char newline = '\n';
+  std::vector<iovec> iov;
+  iov.reserve(records.size() * 2);
+  for (const auto &record : records) {
+    iov.push_back({const_cast<char *>(record.data()), record.size()});
+    iov.push_back({&newline, 1});
+  }
+  write_iovecs(fd, iov.data(), iov.size());
+#endif
+}
+
+/*
+ * Write all of the bytes to the file descriptor, retrying after a partial write or an interruption.
+ */
+inline void write_bytes(int fd, std::string_view bytes) {
+  while (!bytes.empty()) {
+#if defined(_WIN32)
+    int written = ::_write(fd, bytes.data(), static_cast<unsigned int>(bytes.size()));
+    if (written <= 0) return;
+#else
+    ssize_t written = ::write(fd, bytes.data(), bytes.size());
+    if (written < 0) {
+      if (errno == EINTR) continue;
+      return;
+    }
+#endif
+    bytes.remove_prefix(static_cast<std::size_t>(written));
+  }
+}
+
+struct async_logger;
+
+// The logger that write_log() pushes to, or nullptr when the logs are written synchronously.
+inline std::atomic<async_logger *> &active_async_logger() {
+  static std::atomic<async_logger *> logger{nullptr};
+  return logger;
+}
+
+/*
+ * The background thread of start_async_log() and its queue.
+ * cpp_dump() pushes the finished records, or the copies of its arguments if defer_formatting is
+ * set, and returns. The thread pops them in batches, renders the deferred ones, and writes each
+ * batch with one writev().
+ */
+struct async_logger {
+ public:
+  static constexpr std::size_t max_batch_size = 256;
+
+  explicit async_logger(const types::async_log_options_t &opts)
+      : _ring(opts.capacity),
+        _overflow(opts.overflow),
+        _fd(opts.fd),
+        _defer_formatting(opts.defer_formatting) {
+    _thread = std::thread([this] { _run(); });
+  }
+
+  async_logger(const async_logger &) = delete;
+  async_logger &operator=(const async_logger &) = delete;
+
+  // Write the queued records and join the thread.
+  ~async_logger() {
+    async_logger *self = this;
+    active_async_logger().compare_exchange_strong(self, nullptr);
+    _stopping.store(true, std::memory_order_seq_cst);
+    _wake();
+    _thread.join();
+  }
+
+  void push(log_record record) {
+    while (!_ring.try_push(record)) {
+      if (_overflow == types::log_overflow_t::drop_newest) {
+        _dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+      }
+      if (_overflow == types::log_overflow_t::drop_oldest) {
+        log_record oldest;
+        if (_ring.try_pop(oldest)) {
+          _dropped.fetch_add(1, std::memory_order_relaxed);
+          _retired.fetch_add(1, std::memory_order_relaxed);
+        }
+      } else {
+        _wake();
+        std::this_thread::yield();
+      }
+    }
+    _pushed.fetch_add(1, std::memory_order_relaxed);
+    _wake();
+  }
+
+  // Wait until the records pushed so far are written.
+  void flush() {
+    std::size_t pushed = _pushed.load(std::memory_order_relaxed);
+    std::unique_lock<std::mutex> lock(_mutex);
+    _flushed.wait(lock, [&] { return _retired.load(std::memory_order_relaxed) >= pushed; });
+  }
+
+  std::size_t dropped_count() const noexcept { return _dropped.load(std::memory_order_relaxed); }
+
+  bool defers_formatting() const noexcept { return _defer_formatting; }
+
+ private:
+  log_ring _ring;
+  types::log_overflow_t _overflow;
+  int _fd;
+  bool _defer_formatting;
+  std::thread _thread;
+  std::mutex _mutex;
+  std::condition_variable _wakeup;
+  std::condition_variable _flushed;
+  std::atomic<bool> _sleeping{false};
+  std::atomic<bool> _stopping{false};
+  std::atomic<std::size_t> _pushed{0};
+  // The number of the records written or dropped by drop_oldest.
+  std::atomic<std::size_t> _retired{0};
+  std::atomic<std::size_t> _dropped{0};
+
+  // Wake the thread only if it sleeps, so that a push usually takes no lock.
+  void _wake() {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (_sleeping.load(std::memory_order_relaxed)) {
+      std::lock_guard<std::mutex> lock(_mutex);
+      _wakeup.notify_one();
+    }
+  }
+
+  void _run() {
+    std::vector<std::string> batch;
+    batch.reserve(max_batch_size);
+    log_record record;
+    while (true) {
+      while (batch.size() < max_batch_size && _ring.try_pop(record)) {
+        if (record.deferred) {
+          record.deferred->render(record.text);
+          record.deferred.reset();
+        }
+        batch.push_back(std::move(record.text));
+      }
+      if (!batch.empty()) {
+        write_records(_fd, batch);
+        {
+          std::lock_guard<std::mutex> lock(_mutex);
+          _retired.fetch_add(batch.size(), std::memory_order_relaxed);
+        }
+        _flushed.notify_all();
+        batch.clear();
+        continue;
+      }
+
+      std::unique_lock<std::mutex> lock(_mutex);
+      _sleeping.store(true, std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      if (_ring.empty()) {
+        // The records dropped by drop_oldest are retired without the thread.
+        _flushed.notify_all();
+        if (_stopping.load(std::memory_order_seq_cst)) break;
+        // The timeout is a safety net. A push wakes the thread.
+        _wakeup.wait_for(lock, std::chrono::milliseconds(100));
+      }
+      _sleeping.store(false, std::memory_order_relaxed);
+    }
+  }
+};
+
+// The logger lives until the exit, when its destructor writes the queued records.
+inline std::unique_ptr<async_logger> &async_logger_storage() {
+  static std::unique_ptr<async_logger> logger;
+  return logger;
+}
+
+}  // namespace _detail
+
+/**
+ * Make cpp_dump() return without waiting for the output.
+ * The logs are queued and written by a background thread, and the queued logs are written at the
+ * exit. This replaces the output of the default cpp_dump::write_log(), not a specialization.
+ * Call this and stop_async_log() while no other thread calls cpp_dump().
+ */
+inline void start_async_log(const types::async_log_options_t &opts = {}) {
+  auto &storage = _detail::async_logger_storage();
+  _detail::active_async_logger().store(nullptr);
+  storage.reset();
+  storage = std::make_unique<_detail::async_logger>(opts);
+  _detail::active_async_logger().store(storage.get());
+}
+
+/**
+ * Write the queued logs, stop the background thread, and write the logs synchronously again.
+ */
+inline void stop_async_log() {
+  _detail::active_async_logger().store(nullptr);
+  _detail::async_logger_storage().reset();
+}
+
+/**
+ * Wait until the logs queued so far are written.
+ */
+inline void flush_async_log() {
+  if (auto *logger = _detail::active_async_logger().load(std::memory_order_acquire)) {
+    logger->flush();
+  }
+}
+
+/**
+ * The number of the logs dropped because the queue was full.
+ */
+inline std::size_t async_log_dropped_count() {
+  auto *logger = _detail::active_async_logger().load(std::memory_order_acquire);
+  return logger ? logger->dropped_count() : 0;
+}
+
+}  // namespace cpp_dump
@@ -0,0 +1,1345 @@
+/*
+ * Copyright (c) 2023 Ryota Sasaki.
+ *
+ * This source code is licensed under the MIT license found in the LICENSE file in the root
+ * directory of this source tree.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include "./arena.hpp"
+#include "./async_log.hpp"
+#include "./document/document.hpp"
+#include "./escape_sequence.hpp"
+#include "./export_command/export_command.hpp"
+#include "./export_var/export_var.hpp"
+#include "./integer_format.hpp"
+#include "./key_groups.hpp"
+#include "./options.hpp"
+#include "./type_check.hpp"
+
+namespace cpp_dump {
+
+namespace types {
+
+/**
+ * A record of a stream of cpp_dump::start_binary_log() passed to cpp_dump::replay_binary_log().
+ */
+struct binary_log_record_t {
+  // The time when cpp_dump() was called.
+  std::chrono::system_clock::time_point time;
+  // The number of the thread that called cpp_dump(), counted from 1 in the order of the first call.
+  std::size_t thread;
+  // The output of cpp_dump() with the options at the time of the replay.
+  std::string_view text;
+};
+
+}  // namespace types
+
+namespace _detail {
+
+/*
+ * The stream of start_binary_log() is a header followed by messages.
+ *   header:  "cpp-dump" version byte_order number_sizes
+ *   site:    's' id file_name line function_name is_va_temp expr_count exprs...
+ *   record:  'r' site_id time thread suppressed value_count values...
+ * The time is a std::int64_t of the nanoseconds since the epoch, the byte order is the value 1 as
+ * a std::uint32_t, and the other integers are LEB128 varints. A string is its size followed by
+ * its characters. A call site is written once, before the first record of it.
+ * The site of a dumper has no expressions, since it cannot see them, so its records may have
+ * any number of values and are replayed with print_expr = false.
+ *
+ * A value is a tag followed by its payload, which mirrors what export_var() would make of it:
+ * the integers are written as varints and the other numbers as they are in the memory, and the
+ * containers, the maps, the sets and the tuples are written as their items after the skip and the
+ * depth limit are applied.
+ * The others, such as user-defined types and enums, are written as the nodes of their document,
+ * whose texts have the markers of binary_es_role in place of the escape sequences.
+ * The replay exports the numbers and the strings again and colors the markers, so the escape
+ * sequences and the line breaks of every value follow the options at the time of the replay.
+ * The documents written with CPP_DUMP_DISABLE_ES have no markers and are replayed without colors.
+ * The stream is read on the same platform it was written on.
+ */
+inline constexpr std::string_view binary_log_magic = "cpp-dump";
+inline constexpr unsigned char binary_log_version = 3;
+
+// The arithmetic types. A number is written with its index in this list.
+using _binary_number_types = std::tuple<
+    bool,
+    char,
+    signed char,
+    unsigned char,
+    wchar_t,
+    char16_t,
+    char32_t,
+    short,
+    unsigned short,
+    int,
+    unsigned int,
+    long,
+    unsigned long,
+    long long,
+    unsigned long long,
+    float,
+    double,
+    long double
+#if defined(__cpp_char8_t)
+    ,
+    char8_t
+#endif
+    >;
+
+inline constexpr std::size_t _binary_number_type_count = std::tuple_size_v<_binary_number_types>;
+
+template <typename T, std::size_t I = 0>
+constexpr unsigned char _binary_number_code() {
+  if constexpr (std::is_same_v<std::tuple_element_t<I, _binary_number_types>, T>) {
+    return static_cast<unsigned char>(I);
+  } else {
+    return _binary_number_code<T, I + 1>();
+  }
+}
+
+enum class binary_tag : unsigned char {
+  number,         // code bytes
+  numbers,        // shift_indent code segments... (a container of numbers)
+  string,         // string
+  empty,          // bracket
+  omitted,        // bracket (beyond max_depth)
+  group,          // bracket shift_indent items... end
+  optional,       // value
+  nullopt,        //
+  variant,        // value
+  null_pointer,   //
+  address,        // std::uintptr_t
+  deref,          // value
+  deref_omitted,  // (beyond max_depth)
+  document,       // node
+};
+
+enum class binary_bracket : unsigned char { square, curly, paren };
+
+enum class binary_item : unsigned char {
+  end,
+  ellipsis,
+  value,             // value
+  key_value,         // key value
+  key_count_values,  // key count values (multimaps)
+  elem_count,        // elem count (multisets)
+};
+
+// The styles of the groups of the documents.
+enum class binary_style : unsigned char { square, curly, tuple, object };
+
+/*
+ * The roles of the escape sequences in the documents of a stream of start_binary_log().
+ * A role is written as ESC SOH and its number, followed by its text and es::reset().
+ * The brackets have a role for each of the first binary_bracket_roles depths.
+ */
+enum class binary_es_role : unsigned char {
+  log = 1,
+  expression,
+  reserved,
+  number,
+  character,
+  escaped_char,
+  op,
+  identifier,
+  member,
+  unsupported,
+  class_op,
+  member_op,
+  number_op,
+  bracket,
+};
+
+inline constexpr std::size_t binary_bracket_roles = 16;
+
+inline constexpr std::string_view binary_es_marker = "\x1b\x01";
+
+inline std::string _binary_es_marker(std::size_t role) {
+  std::string marker(binary_es_marker);
+  marker.push_back(static_cast<char>(role));
+  return marker;
+}
+
+// es_value with the marker of each role.
+inline const types::es_value_t &binary_es_markers() {
+  static const types::es_value_t markers = [] {
+    auto role = [](binary_es_role r) { return _binary_es_marker(static_cast<std::size_t>(r)); };
+    types::es_value_t m;
+    m.log = role(binary_es_role::log);
+    m.expression = role(binary_es_role::expression);
+    m.reserved = role(binary_es_role::reserved);
+    m.number = role(binary_es_role::number);
+    m.character = role(binary_es_role::character);
+    m.escaped_char = role(binary_es_role::escaped_char);
+    m.op = role(binary_es_role::op);
+    m.identifier = role(binary_es_role::identifier);
+    m.member = role(binary_es_role::member);
+    m.unsupported = role(binary_es_role::unsupported);
+    m.class_op = role(binary_es_role::class_op);
+    m.member_op = role(binary_es_role::member_op);
+    m.number_op = role(binary_es_role::number_op);
+    m.bracket_by_depth.clear();
+    for (std::size_t d = 0; d < binary_bracket_roles; ++d) {
+      m.bracket_by_depth.push_back(
+          _binary_es_marker(static_cast<std::size_t>(binary_es_role::bracket) + d)
+      );
+    }
+    return m;
+  }();
+  return markers;
+}
+
+template <typename>
+inline constexpr bool _is_std_variant = false;
+template <typename... Args>
+inline constexpr bool _is_std_variant<std::variant<Args...>> = true;
+
+/*
+ * Write the integers and the strings of a stream of start_binary_log().
+ */
+struct binary_writer {
+ public:
+  explicit binary_writer(std::string &out) : _out(out) {}
+
+  binary_writer(const binary_writer &) = delete;
+  binary_writer &operator=(const binary_writer &) = delete;
+
+  void byte(unsigned char c) { _out.push_back(static_cast<char>(c)); }
+
+  template <typename Enum>
+  void tag(Enum e) {
+    byte(static_cast<unsigned char>(e));
+  }
+
+  void varint(std::uint64_t n) {
+    while (n >= 0x80) {
+      byte(static_cast<unsigned char>(n | 0x80));
+      n >>= 7;
+    }
+    byte(static_cast<unsigned char>(n));
+  }
+
+  template <typename T>
+  void raw(const T &value) {
+    _out.append(reinterpret_cast<const char *>(&value), sizeof(T));
+  }
+
+  void string(std::string_view s) {
+    varint(s.size());
+    _out.append(s);
+  }
+
+  // The integers wider than a byte are written as varints, zigzag-encoded if signed, and the
+  // others as they are in the memory.
+  template <typename T>
+  void number(T n) {
+    if constexpr (std::is_integral_v<T> && sizeof(T) > 1 && std::is_signed_v<T>) {
+      auto v = static_cast<std::int64_t>(n);
+      varint((static_cast<std::uint64_t>(v) << 1) ^ static_cast<std::uint64_t>(v >> 63));
+    } else if constexpr (std::is_integral_v<T> && sizeof(T) > 1) {
+      varint(static_cast<std::uint64_t>(n));
+    } else {
+      raw(n);
+    }
+  }
+
+ protected:
+  std::string &_out;
+};
+
+// The number of the calling thread in a stream of start_binary_log().
+inline std::size_t binary_log_thread_number() {
+  static std::atomic<std::size_t> count{0};
+  thread_local std::size_t number = ++count;
+  return number;
+}
+
+/*
+ * The destination of start_binary_log().
+ * A call site is looked up in a table of the thread first, so the lock is only taken to append
+ * the record to the buffer, which is written when it is full or flushed.
+ */
+struct binary_logger {
+ public:
+  static constexpr std::size_t buffer_size = 64 * 1024;
+
+  explicit binary_logger(int fd) : _fd(fd), _session(_next_session()) {
+    _buffer.reserve(buffer_size * 2);
+    binary_writer header(_buffer);
+    _buffer.append(binary_log_magic);
+    header.byte(binary_log_version);
+    header.raw(std::uint32_t{1});
+    header.byte(static_cast<unsigned char>(_binary_number_type_count));
+    _write_number_sizes(header, std::make_index_sequence<_binary_number_type_count>());
+  }
+
+  binary_logger(const binary_logger &) = delete;
+  binary_logger &operator=(const binary_logger &) = delete;
+
+  ~binary_logger() { flush(); }
+
+  // Append a record of a call site. record is made by write_binary_log().
+  // exprs are the expression_count expressions of the call site.
+  void write(
+      std::string_view file_name,
+      std::size_t line,
+      std::string_view function_name,
+      bool is_va_temp,
+      const std::string_view *exprs,
+      std::size_t expr_count,
+      std::string_view record
+  ) {
+    std::size_t site = _site_id(file_name, line, function_name, is_va_temp, exprs, expr_count);
+    std::lock_guard<std::mutex> lock(_mutex);
+    binary_writer head(_buffer);
+    head.byte('r');
+    head.varint(site);
+    _buffer.append(record);
+    if (_buffer.size() >= buffer_size) _flush_locked();
+  }
+
+  // Write the buffered records.
+  void flush() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _flush_locked();
+  }
+
+ private:
+  struct site_key {
+    const char *file_name;
+    std::size_t line;
+    const char *function_name;
+    const char *first_expr;
+    std::size_t expr_count;
+
+    bool operator==(const site_key &other) const {
+      return file_name == other.file_name && line == other.line
+             && function_name == other.function_name && first_expr == other.first_expr
+             && expr_count == other.expr_count;
+    }
+  };
+
+  struct site_key_hash {
+    std::size_t operator()(const site_key &key) const {
+      auto h = std::hash<const void *>()(key.file_name);
+      h = h * 31 + key.line;
+      h = h * 31 + std::hash<const void *>()(key.function_name);
+      h = h * 31 + std::hash<const void *>()(key.first_expr);
+      return h * 31 + key.expr_count;
+    }
+  };
+
+  using site_table = std::unordered_map<site_key, std::size_t, site_key_hash>;
+
+  int _fd;
+  std::size_t _session;
+  std::mutex _mutex;
+  std::string _buffer;
+  site_table _sites;
+
+  static std::size_t _next_session() {
+    static std::atomic<std::size_t> count{0};
+    return ++count;
+  }
+
+  template <std::size_t... Is>
+  static void _write_number_sizes(binary_writer &header, std::index_sequence<Is...>) {
+    (header.byte(
+         static_cast<unsigned char>(sizeof(std::tuple_element_t<Is, _binary_number_types>))
+     ),
+     ...);
+  }
+
+  // The file, the function and the expressions are string literals, so their addresses tell the
+  // call sites apart.
+  std::size_t _site_id(
+      std::string_view file_name,
+      std::size_t line,
+      std::string_view function_name,
+      bool is_va_temp,
+      const std::string_view *exprs,
+      std::size_t expr_count
+  ) {
+    site_key key{
+        file_name.data(),
+        line,
+        function_name.data(),
+        expr_count > 0 ? exprs[0].data() : nullptr,
+        expr_count};
+
+    thread_local std::size_t cached_session = 0;
+    thread_local site_table cached_sites;
+    if (cached_session != _session) {
+      cached_sites.clear();
+      cached_session = _session;
+    }
+    if (auto it = cached_sites.find(key); it != cached_sites.end()) return it->second;
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto [it, inserted] = _sites.try_emplace(key, _sites.size());
+    if (inserted) {
+      binary_writer site(_buffer);
+      site.byte('s');
+      site.varint(it->second);
+      site.string(file_name);
+      site.varint(line);
+      site.string(function_name);
+      site.byte(is_va_temp);
+      site.varint(expr_count);
+      for (std::size_t i = 0; i < expr_count; ++i) site.string(exprs[i]);
+    }
+    cached_sites.emplace(key, it->second);
+    return it->second;
+  }
+
+  void _flush_locked() {
+    write_bytes(_fd, _buffer);
+    _buffer.clear();
+  }
+};
+
+// The logger that cpp_dump() writes to, or nullptr when it writes the text.
+inline std::atomic<binary_logger *> &active_binary_logger() {
+  static std::atomic<binary_logger *> logger{nullptr};
+  return logger;
+}
+
+// The logger lives until the exit, when its destructor writes the buffered records.
+inline std::unique_ptr<binary_logger> &binary_logger_storage() {
+  static std::unique_ptr<binary_logger> logger;
+  return logger;
+}
+
+
+inline namespace _p_CPP_DUMP_ES_NAMESPACE {
+
+/*
+ * The options that binary_encoder exports the documents with: the options of the dump with the
+ * markers of binary_es_role in place of the escape sequences, and the tokens for them.
+ */
+struct binary_marked_options {
+ public:
+  types::options_snapshot_t options;
+  std::shared_ptr<const token_table> tokens;
+
+  // Return those for the current options. Each thread keeps the last ones, which are reused while
+  // the dumps use the same global options.
+  static const binary_marked_options &current() {
+    thread_local std::optional<binary_marked_options> marked;
+    constexpr std::size_t unchecked = static_cast<std::size_t>(-1);
+    thread_local std::size_t checked_generation = unchecked;
+
+    const auto &o = current_options();
+    const bool is_global = is_global_options(o);
+    if (marked && is_global && checked_generation == global_options_generation()) {
+      return *marked;
+    }
+    auto options = o;
+    options.es_value = binary_es_markers();
+    // The markers are written even if the dump has no escape sequences.
+    if (options.es_style == types::es_style_t::no_es) options.es_style = types::es_style_t::original;
+    // The tokens depend only on these since the markers never change.
+    bool same_tokens = marked && marked->options.es_style == options.es_style
+                       && marked->options.detailed_class_es == options.detailed_class_es
+                       && marked->options.detailed_member_es == options.detailed_member_es
+                       && marked->options.detailed_number_es == options.detailed_number_es;
+    if (marked) {
+      marked->options = std::move(options);
+    } else {
+      marked.emplace(binary_marked_options{std::move(options), nullptr});
+    }
+    if (!same_tokens) {
+      dumper_scope building(marked->options, nullptr);
+      marked->tokens = token_table::build();
+    }
+    checked_generation = is_global ? global_options_generation() : unchecked;
+    return *marked;
+  }
+};
+
+/*
+ * Encode the arguments of cpp_dump() into a record of start_binary_log().
+ */
+struct binary_encoder : binary_writer {
+ public:
+  using binary_writer::binary_writer;
+
+  // This mirrors export_var().
+  template <typename T>
+  void value(const T &value, std::size_t current_depth, const export_command &command) {
+    if constexpr (is_value_with_command<T> || is_exportable_object<T> || is_exportable_enum<T>) {
+      _document(value, current_depth, command);
+    } else if constexpr (is_arithmetic<T>) {
+      using number_t = std::conditional_t<is_vector_bool_reference<T>, bool, remove_cvref<T>>;
+      tag(binary_tag::number);
+      byte(_binary_number_code<number_t>());
+      number(static_cast<number_t>(value));
+    } else if constexpr (is_string<T>) {
+      tag(binary_tag::string);
+      string(std::string_view(value));
+    } else if constexpr (is_map<T>) {
+      _map(value, current_depth, command);
+    } else if constexpr (is_set<T>) {
+      _set(value, current_depth, command);
+    } else if constexpr (is_container<T>) {
+      _container(value, current_depth, command);
+    } else if constexpr (is_tuple<T>) {
+      _tuple(value, current_depth, command, std::make_index_sequence<std::tuple_size_v<T>>());
+    } else if constexpr (is_pointer<T>) {
+      _pointer(value, current_depth, command);
+    } else if constexpr (is_optional<T>) {
+      if constexpr (std::is_same_v<remove_cvref<T>, std::nullopt_t>) {
+        tag(binary_tag::nullopt);
+      } else if (value == std::nullopt) {
+        tag(binary_tag::nullopt);
+      } else {
+        tag(binary_tag::optional);
+        this->value(value.value(), current_depth, command);
+      }
+    } else if constexpr (_is_std_variant<remove_cvref<T>>) {
+      tag(binary_tag::variant);
+      std::visit([&](const auto &v) { this->value(v, current_depth, command); }, value);
+    } else {
+      _document(value, current_depth, command);
+    }
+  }
+
+ private:
+  // The document for the values written as their nodes. Most records need none.
+  std::optional<dump_scope> _scope;
+  std::optional<document> _doc;
+  const types::options_snapshot_t *_marked = nullptr;
+  std::shared_ptr<const token_table> _marked_tokens;
+
+  void _bracket(binary_tag t, binary_bracket b) {
+    tag(t);
+    tag(b);
+  }
+
+  // Replace the byte reserved at the start of a segment with the count of its numbers.
+  void _patch_count(std::size_t pos, std::uint64_t count) {
+    char count_bytes[10];
+    std::size_t size = 0;
+    for (; count >= 0x80; count >>= 7) {
+      count_bytes[size++] = static_cast<char>(count | 0x80);
+    }
+    count_bytes[size++] = static_cast<char>(count);
+    _out.replace(pos, 1, count_bytes, size);
+  }
+
+  template <typename T>
+  void _container(const T &container, std::size_t current_depth, const export_command &command) {
+    if (is_empty_iterable(container)) {
+      _bracket(binary_tag::empty, binary_bracket::square);
+      return;
+    }
+    if (current_depth >= current_options().max_depth) {
+      _bracket(binary_tag::omitted, binary_bracket::square);
+      return;
+    }
+
+    using elem_t = iterable_elem_type<T>;
+    const auto &next_command = command.next();
+    auto skipped_container = command.create_skip_container(container);
+
+    // The numbers are written without the tags, in segments separated by the ellipses:
+    // each segment is the count followed by the numbers, and then 1 if an ellipsis follows or 0
+    // if it is the last.
+    if constexpr (std::is_arithmetic_v<elem_t>) {
+      tag(binary_tag::numbers);
+      byte(shift_indent_of_elems<T>());
+      byte(_binary_number_code<elem_t>());
+      std::size_t count_pos = _out.size();
+      std::uint64_t count = 0;
+      byte(0);
+      for (auto &&[is_ellipsis, it, _index] : skipped_container) {
+        [[maybe_unused]] const auto &_index_unused = _index;  // for g++-7 compiler support
+        if (is_ellipsis) {
+          _patch_count(count_pos, count);
+          byte(1);
+          count_pos = _out.size();
+          count = 0;
+          byte(0);
+          continue;
+        }
+        number(static_cast<elem_t>(*it));
+        ++count;
+      }
+      _patch_count(count_pos, count);
+      byte(0);
+    } else {
+      _bracket(binary_tag::group, binary_bracket::square);
+      byte(shift_indent_of_elems<T>());
+      for (auto &&[is_ellipsis, it, _index] : skipped_container) {
+        [[maybe_unused]] const auto &_index_unused = _index;  // for g++-7 compiler support
+        if (is_ellipsis) {
+          tag(binary_item::ellipsis);
+          continue;
+        }
+        tag(binary_item::value);
+        value(*it, current_depth + 1, next_command);
+      }
+      tag(binary_item::end);
+    }
+  }
+
+  template <typename T>
+  void _map(const T &map, std::size_t current_depth, const export_command &command) {
+    if (map.empty()) {
+      _bracket(binary_tag::empty, binary_bracket::curly);
+      return;
+    }
+    if (current_depth >= current_options().max_depth) {
+      _bracket(binary_tag::omitted, binary_bracket::curly);
+      return;
+    }
+
+    std::size_t next_depth = current_depth + 1;
+    const auto &key_command = command.next_for_map_key();
+    const auto &value_command = command.next_for_map_value();
+    auto map_wrapper = ([&]() {
+      if constexpr (is_multimap<T>) {
+        return key_groups(map);
+      } else {
+        return _export_map::_map_dummy_wrapper(map);
+      }
+    })();
+    auto skipped_map = command.create_skip_container(map_wrapper);
+
+    _bracket(binary_tag::group, binary_bracket::curly);
+    byte(shift_indent_of_map<T>());
+    for (const auto &[is_ellipsis, it, _index] : skipped_map) {
+      [[maybe_unused]] const auto &_index_unused = _index;  // for g++-7 compiler support
+      const auto &[key, mapped] = *it;
+      if (is_ellipsis) {
+        tag(binary_item::ellipsis);
+        continue;
+      }
+      if constexpr (is_multimap<T>) {
+        tag(binary_item::key_count_values);
+        value(key, next_depth, key_command);
+        varint(it.count());
+        value(
+            _export_map::_multimap_value_wrapper(it.group_begin(), it.group_end()),
+            next_depth,
+            value_command
+        );
+      } else {
+        tag(binary_item::key_value);
+        value(key, next_depth, key_command);
+        value(mapped, next_depth, value_command);
+      }
+    }
+    tag(binary_item::end);
+  }
+
+  template <typename T>
+  void _set(const T &set, std::size_t current_depth, const export_command &command) {
+    if (set.empty()) {
+      _bracket(binary_tag::empty, binary_bracket::curly);
+      return;
+    }
+    if (current_depth >= current_options().max_depth) {
+      _bracket(binary_tag::omitted, binary_bracket::curly);
+      return;
+    }
+
+    const auto &next_command = command.next();
+    auto set_wrapper = ([&]() {
+      if constexpr (is_multiset<T>) {
+        return key_groups(set);
+      } else {
+        return _export_set::_set_dummy_wrapper(set);
+      }
+    })();
+    auto skipped_set = command.create_skip_container(set_wrapper);
+
+    _bracket(binary_tag::group, binary_bracket::curly);
+    byte(shift_indent_of_elems<T>());
+    for (const auto &[is_ellipsis, it, _index] : skipped_set) {
+      [[maybe_unused]] const auto &_index_unused = _index;  // for g++-7 compiler support
+      if (is_ellipsis) {
+        tag(binary_item::ellipsis);
+        continue;
+      }
+      if constexpr (is_multiset<T>) {
+        tag(binary_item::elem_count);
+        value(*it, current_depth + 1, next_command);
+        varint(it.count());
+      } else {
+        tag(binary_item::value);
+        value(*it, current_depth + 1, next_command);
+      }
+    }
+    tag(binary_item::end);
+  }
+
+  template <typename T, std::size_t... Is>
+  void _tuple(
+      const T &tuple,
+      std::size_t current_depth,
+      const export_command &command,
+      std::index_sequence<Is...>
+  ) {
+    if constexpr (sizeof...(Is) == 0) {
+      _bracket(binary_tag::empty, binary_bracket::paren);
+    } else {
+      if (current_depth >= current_options().max_depth) {
+        _bracket(binary_tag::omitted, binary_bracket::paren);
+        return;
+      }
+      _bracket(binary_tag::group, binary_bracket::paren);
+      byte(0);
+      ((tag(binary_item::value),
+        value(
+            _export_tuple::get<Is>(tuple, priority_tag_high{}), current_depth + 1, command
+        )),
+       ...);
+      tag(binary_item::end);
+    }
+  }
+
+  template <typename T>
+  void _pointer(const T &pointer, std::size_t current_depth, const export_command &command) {
+    if (pointer == nullptr) {
+      tag(binary_tag::null_pointer);
+      return;
+    }
+    if constexpr (is_null_pointer<T> || !is_exportable<remove_pointer<T>>) {
+      if constexpr (std::is_function_v<remove_pointer<T>>) {
+        _document(pointer, current_depth, command);
+      } else {
+        tag(binary_tag::address);
+        raw(reinterpret_cast<std::uintptr_t>(static_cast<const void *>(pointer)));
+      }
+    } else {
+      if (current_depth >= command.addr_depth()) {
+        const void *address;
+        if constexpr (is_smart_pointer<T>) {
+          address = static_cast<const void *>(pointer.get());
+        } else {
+          address = static_cast<const void *>(pointer);
+        }
+        tag(binary_tag::address);
+        raw(reinterpret_cast<std::uintptr_t>(address));
+        return;
+      }
+      if (current_depth >= current_options().max_depth) {
+        tag(binary_tag::deref_omitted);
+        return;
+      }
+      tag(binary_tag::deref);
+      value(*pointer, current_depth + 1, command);
+    }
+  }
+
+  template <typename... Args>
+  void _pointer(
+      const std::weak_ptr<Args...> &wk_ptr, std::size_t current_depth, const export_command &command
+  ) {
+    _pointer(wk_ptr.lock(), current_depth, command);
+  }
+
+  template <typename T>
+  void _document(const T &value, std::size_t current_depth, const export_command &command) {
+    if (!_marked) {
+      // The record keeps the tokens even if a nested dump replaces those of this thread.
+      const auto &marked = binary_marked_options::current();
+      _marked_tokens = marked.tokens;
+      _marked = &marked.options;
+    }
+    dumper_scope marking(*_marked, _marked_tokens.get());
+    if (!_doc) {
+      _scope.emplace();
+      _doc.emplace();
+    }
+    tag(binary_tag::document);
+    _node(export_var(value, current_depth, command, *_doc));
+  }
+
+  void _node(const doc_node &node) {
+    tag(node.kind);
+    string(node.text->str);
+    if (node.kind == doc_node::kind_t::prefix) {
+      _node(*node.child);
+    } else if (node.kind == doc_node::kind_t::group) {
+      const auto &by_depth = _doc->tokens().by_depth;
+      std::size_t depth = 0;
+      binary_style style = binary_style::square;
+      for (; depth < by_depth.size(); ++depth) {
+        const auto &t = by_depth[depth];
+        if (node.style == &t.square) break;
+        if (node.style == &t.curly) {
+          style = binary_style::curly;
+          break;
+        }
+        if (node.style == &t.tuple) {
+          style = binary_style::tuple;
+          break;
+        }
+        if (node.style == &t.object) {
+          style = binary_style::object;
+          break;
+        }
+      }
+      tag(style);
+      varint(depth);
+      byte(node.has_flat);
+      // 1 starts an item, 2 continues it, and 0 ends the group.
+      for (auto part = node.first_part; part; part = part->next_part) {
+        byte(part->starts_item ? 1 : 2);
+        _node(*part);
+      }
+      byte(0);
+    }
+  }
+};
+
+/*
+ * Encode a call of cpp_dump() and append it to the logger.
+ * exprs is a std::array of the expressions.
+ */
+template <typename Exprs, typename... Args>
+void write_binary_log(
+    binary_logger &logger,
+    std::string_view file_name,
+    std::size_t line,
+    std::string_view function_name,
+    bool is_va_temp,
+    const Exprs &exprs,
+    std::size_t suppressed,
+    const Args &...args
+) {
+  auto time = std::chrono::system_clock::now();
+
+  // A nested cpp_dump() finds the buffer of the thread empty and uses a new one.
+  thread_local std::string spare;
+  std::string record = std::move(spare);
+  record.clear();
+  {
+    binary_encoder encoder(record);
+    auto nanoseconds =
+        std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch());
+    encoder.raw(static_cast<std::int64_t>(nanoseconds.count()));
+    encoder.varint(binary_log_thread_number());
+    encoder.varint(suppressed);
+    encoder.varint(sizeof...(Args));
+    (encoder.value(args, 0, export_command::default_command), ...);
+  }
+  logger.write(file_name, line, function_name, is_va_temp, exprs.data(), exprs.size(), record);
+  spare = std::move(record);
+}
+
+/*
+ * Read a stream of start_binary_log() and make the documents of its values.
+ */
+struct binary_log_reader {
+ public:
+  struct site {
+    std::string_view file_name;
+    std::size_t line;
+    std::string_view function_name;
+    bool is_va_temp;
+    std::vector<std::string_view> exprs;
+  };
+
+  explicit binary_log_reader(std::string_view stream) : _stream(stream) {
+    if (_stream.substr(0, binary_log_magic.size()) != binary_log_magic) {
+      _broken = true;
+      return;
+    }
+    _pos = binary_log_magic.size();
+    _broken = _byte() != binary_log_version || _raw<std::uint32_t>() != 1
+              || _byte() != _binary_number_type_count
+              || !_check_number_sizes(std::make_index_sequence<_binary_number_type_count>());
+  }
+
+  bool broken() const { return _broken; }
+
+  // Move to the next record. Return false at the end of the stream or if it is broken.
+  bool next() {
+    while (!_broken && _pos < _stream.size()) {
+      auto message = _byte();
+      if (message == 's') {
+        _read_site();
+      } else if (message == 'r') {
+        auto id = _varint();
+        if (id >= _sites.size()) break;
+        _site = &_sites[id];
+        _time = std::chrono::system_clock::time_point(
+            std::chrono::duration_cast<std::chrono::system_clock::duration>(
+                std::chrono::nanoseconds(_raw<std::int64_t>())
+            )
+        );
+        _thread = _varint();
+        _suppressed = _varint();
+        _value_count = _varint();
+        if (!_site->is_va_temp && !_site->exprs.empty() && _value_count != _site->exprs.size()) {
+          break;
+        }
+        // Every value takes a byte or more.
+        if (_broken || _stream.size() - _pos < _value_count) {
+          _broken = true;
+          return false;
+        }
+        return true;
+      } else {
+        break;
+      }
+    }
+    if (_pos < _stream.size()) _broken = true;
+    return false;
+  }
+
+  const site &current_site() const { return *_site; }
+  std::chrono::system_clock::time_point time() const { return _time; }
+  std::size_t thread() const { return _thread; }
+  std::size_t suppressed() const { return _suppressed; }
+
+  // Make the nodes of the values of the current record.
+  std::pmr::vector<const doc_node *> export_values(document &doc) {
+    std::pmr::vector<const doc_node *> values(dump_arena::resource());
+    values.reserve(_value_count);
+    for (std::size_t i = 0; i < _value_count && !_broken; ++i) values.push_back(&_value(0, doc));
+    return values;
+  }
+
+  // The deepest nesting of the values that is read. A deeper stream is broken.
+  static constexpr std::size_t max_nesting = 256;
+
+ private:
+  std::string_view _stream;
+  std::size_t _pos = 0;
+  bool _broken = false;
+  std::vector<site> _sites;
+  const site *_site = nullptr;
+  std::chrono::system_clock::time_point _time;
+  std::size_t _thread = 0;
+  std::size_t _suppressed = 0;
+  std::size_t _value_count = 0;
+  std::size_t _nesting = 0;
+
+  // Counts the nesting of _value() and _node() so that a broken stream cannot exhaust the stack.
+  struct nesting_guard {
+   public:
+    explicit nesting_guard(std::size_t &nesting) : _nesting(nesting) { ++_nesting; }
+    ~nesting_guard() { --_nesting; }
+    nesting_guard(const nesting_guard &) = delete;
+    nesting_guard &operator=(const nesting_guard &) = delete;
+
+    bool too_deep() const { return _nesting > max_nesting; }
+
+   private:
+    std::size_t &_nesting;
+  };
+
+  template <std::size_t... Is>
+  bool _check_number_sizes(std::index_sequence<Is...>) {
+    return ((_byte() == sizeof(std::tuple_element_t<Is, _binary_number_types>)) && ...);
+  }
+
+  bool _read(void *dest, std::size_t size) {
+    if (_broken || _stream.size() - _pos < size) {
+      _broken = true;
+      return false;
+    }
+    std::memcpy(dest, _stream.data() + _pos, size);
+    _pos += size;
+    return true;
+  }
+
+  unsigned char _byte() {
+    unsigned char c = 0;
+    _read(&c, 1);
+    return c;
+  }
+
+  template <typename T>
+  T _raw() {
+    T value{};
+    _read(&value, sizeof(T));
+    return value;
+  }
+
+  std::uint64_t _varint64() {
+    std::uint64_t n = 0;
+    for (unsigned int shift = 0; shift < 64; shift += 7) {
+      auto c = _byte();
+      n |= static_cast<std::uint64_t>(c & 0x7f) << shift;
+      if (!(c & 0x80)) return n;
+    }
+    _broken = true;
+    return 0;
+  }
+
+  std::size_t _varint() { return static_cast<std::size_t>(_varint64()); }
+
+  // This reverses binary_encoder::number().
+  template <typename T>
+  T _number_value() {
+    if constexpr (std::is_same_v<T, bool>) {
+      // A broken stream may have a byte that is not a bool.
+      return _byte() != 0;
+    } else if constexpr (std::is_integral_v<T> && sizeof(T) > 1 && std::is_signed_v<T>) {
+      auto u = _varint64();
+      return static_cast<T>(static_cast<std::int64_t>((u >> 1) ^ (~(u & 1) + 1)));
+    } else if constexpr (std::is_integral_v<T> && sizeof(T) > 1) {
+      return static_cast<T>(_varint64());
+    } else {
+      return _raw<T>();
+    }
+  }
+
+  std::string_view _string() {
+    auto size = _varint();
+    if (_broken || _stream.size() - _pos < size) {
+      _broken = true;
+      return {};
+    }
+    auto s = _stream.substr(_pos, size);
+    _pos += size;
+    return s;
+  }
+
+  void _read_site() {
+    auto id = _varint();
+    if (id != _sites.size()) {
+      _broken = true;
+      return;
+    }
+    site s;
+    s.file_name = _string();
+    s.line = _varint();
+    s.function_name = _string();
+    s.is_va_temp = _byte() != 0;
+    auto expr_count = _varint();
+    if (_stream.size() - _pos < expr_count) {
+      _broken = true;
+      return;
+    }
+    for (std::size_t i = 0; i < expr_count; ++i) s.exprs.push_back(_string());
+    // The variadic template arguments have one expression.
+    if (s.is_va_temp && s.exprs.size() != 1) {
+      _broken = true;
+      return;
+    }
+    _sites.push_back(std::move(s));
+  }
+
+  // The value that replaces what cannot be read.
+  const doc_node &_broken_value(document &doc) {
+    _broken = true;
+    return doc.text(make_temp_string());
+  }
+
+  template <typename T>
+  const doc_node &_number_as(std::size_t current_depth, document &doc) {
+    return export_var(_number_value<T>(), current_depth, export_command::default_command, doc);
+  }
+
+  template <std::size_t... Is>
+  const doc_node &_number(
+      unsigned char code, std::size_t current_depth, document &doc, std::index_sequence<Is...>
+  ) {
+    const doc_node *node = nullptr;
+    static_cast<void>(
+        ((code == Is
+          && (node = &_number_as<std::tuple_element_t<Is, _binary_number_types>>(
+                  current_depth, doc
+              )))
+         || ...)
+    );
+    return node ? *node : _broken_value(doc);
+  }
+
+  const doc_node &_number(unsigned char code, std::size_t current_depth, document &doc) {
+    return _number(
+        code, current_depth, doc, std::make_index_sequence<_binary_number_type_count>()
+    );
+  }
+
+  const doc_node &_bracket_token(std::size_t current_depth, bool omitted, document &doc) {
+    const auto &t = doc.tokens().depth(current_depth);
+    switch (static_cast<binary_bracket>(_byte())) {
+      case binary_bracket::square:
+        return doc.token(omitted ? t.omitted_square : t.empty_square);
+      case binary_bracket::curly:
+        return doc.token(omitted ? t.omitted_curly : t.empty_curly);
+      case binary_bracket::paren:
+        return doc.token(omitted ? t.omitted_paren : t.empty_paren);
+      default:
+        return _broken_value(doc);
+    }
+  }
+
+  // Replace the markers of binary_es_role in a text of a document with the escape sequences of
+  // the options.
+  static temp_string _colored(std::string_view text) {
+    auto output = make_temp_string();
+    std::size_t pos = 0;
+    while (true) {
+      auto marker = text.find(binary_es_marker, pos);
+      if (marker == std::string_view::npos || text.size() - marker <= binary_es_marker.size()) {
+        output.append(text.substr(pos));
+        return output;
+      }
+      output.append(text.substr(pos, marker - pos));
+      auto role = static_cast<unsigned char>(text[marker + binary_es_marker.size()]);
+      auto begin = marker + binary_es_marker.size() + 1;
+      auto end = std::min(text.find(es::_reset_es, begin), text.size());
+      output += _colored(role, text.substr(begin, end - begin));
+      pos = std::min(end + es::_reset_es.size(), text.size());
+    }
+  }
+
+  static temp_string _colored(unsigned char role, std::string_view s) {
+    auto bracket = static_cast<unsigned char>(binary_es_role::bracket);
+    if (role >= bracket) return es::bracket(s, static_cast<std::size_t>(role - bracket));
+    switch (static_cast<binary_es_role>(role)) {
+      case binary_es_role::log:
+        return es::log(s);
+      case binary_es_role::expression:
+        return es::expression(s);
+      case binary_es_role::reserved:
+        return es::reserved(s);
+      case binary_es_role::number:
+        return es::number(s);
+      case binary_es_role::character:
+        return es::character(s);
+      case binary_es_role::escaped_char:
+        return es::escaped_char(s);
+      case binary_es_role::op:
+        return es::op(s);
+      case binary_es_role::identifier:
+        return es::identifier(s);
+      case binary_es_role::member:
+        return es::member(s);
+      case binary_es_role::unsupported:
+        return es::unsupported(s);
+      case binary_es_role::class_op:
+        return es::class_op(s);
+      case binary_es_role::member_op:
+        return es::member_op(s);
+      case binary_es_role::number_op:
+        return es::number_op(s);
+      default:
+        return make_temp_string(s);
+    }
+  }
+
+  // " (count)" of the multimaps and the multisets
+  static temp_string _multiplicity(std::size_t count) {
+    return es::member(concat(" (", decimal_chars(count).view(), ")"));
+  }
+
+  const doc_node &_numbers(std::size_t current_depth, document &doc) {
+    bool shift_indent = _byte() != 0;
+    auto code = _byte();
+    auto &group = doc.bracket_group("[", current_depth, shift_indent);
+    while (!_broken) {
+      auto count = _varint();
+      for (std::size_t i = 0; i < count && !_broken; ++i) {
+        group.add_item({&_number(code, current_depth + 1, doc)});
+      }
+      if (_byte() == 0) break;
+      group.add_item({&doc.token(doc.tokens().ellipsis)});
+    }
+    return group;
+  }
+
+  const doc_node &_group(std::size_t current_depth, document &doc) {
+    auto bracket = static_cast<binary_bracket>(_byte());
+    bool shift_indent = _byte() != 0;
+    auto &group = bracket == binary_bracket::paren
+                      ? doc.tuple_group(current_depth)
+                      : doc.bracket_group(
+                            bracket == binary_bracket::square ? "[" : "{",
+                            current_depth,
+                            shift_indent
+                        );
+    std::size_t next_depth = current_depth + 1;
+    while (!_broken) {
+      switch (static_cast<binary_item>(_byte())) {
+        case binary_item::end:
+          return group;
+        case binary_item::ellipsis:
+          group.add_item({&doc.token(doc.tokens().ellipsis)});
+          break;
+        case binary_item::value:
+          group.add_item({&_value(next_depth, doc)});
+          break;
+        case binary_item::key_value: {
+          const auto &key = _value(next_depth, doc);
+          group.add_item({&key, &doc.token(doc.tokens().colon), &_value(next_depth, doc)});
+          break;
+        }
+        case binary_item::key_count_values: {
+          const auto &key = _value(next_depth, doc);
+          auto count = _varint();
+          group.add_item(
+              {&key,
+               &doc.text(concat(_multiplicity(count), es::op(": "))),
+               &_value(next_depth, doc)}
+          );
+          break;
+        }
+        case binary_item::elem_count: {
+          const auto &elem = _value(next_depth, doc);
+          group.add_item({&elem, &doc.text(_multiplicity(_varint()))});
+          break;
+        }
+        default:
+          _broken = true;
+      }
+    }
+    return group;
+  }
+
+  const doc_node &_value(std::size_t current_depth, document &doc) {
+    nesting_guard guard(_nesting);
+    if (_broken || guard.too_deep()) return _broken_value(doc);
+    switch (static_cast<binary_tag>(_byte())) {
+      case binary_tag::number:
+        return _number(_byte(), current_depth, doc);
+      case binary_tag::numbers:
+        return _numbers(current_depth, doc);
+      case binary_tag::string:
+        return export_string(_string(), current_depth, export_command::default_command, doc);
+      case binary_tag::empty:
+        return _bracket_token(current_depth, false, doc);
+      case binary_tag::omitted:
+        return _bracket_token(current_depth, true, doc);
+      case binary_tag::group:
+        return _group(current_depth, doc);
+      case binary_tag::optional: {
+        const auto &value = _value(current_depth, doc);
+        return doc.prefix(_export_other::_es_optional_question("?"), value);
+      }
+      case binary_tag::nullopt:
+        return doc.text(es::class_name("std::nullopt"));
+      case binary_tag::variant: {
+        const auto &value = _value(current_depth, doc);
+        return doc.prefix(_export_other::_es_variant_bar("|"), value);
+      }
+      case binary_tag::null_pointer:
+        return doc.token(doc.tokens().nullptr_);
+      case binary_tag::address: {
+        auto address = reinterpret_cast<const void *>(_raw<std::uintptr_t>());
+        return doc.text(_export_pointer::_es_raw_address(address_chars(address).view()));
+      }
+      case binary_tag::deref: {
+        const auto &value = _value(current_depth + 1, doc);
+        return doc.prefix(_export_pointer::_es_ptr_asterisk("*"), value);
+      }
+      case binary_tag::deref_omitted:
+        return doc.prefix(
+            _export_pointer::_es_ptr_asterisk("*"), doc.token(doc.tokens().ellipsis)
+        );
+      case binary_tag::document:
+        return _node(doc);
+      default:
+        return _broken_value(doc);
+    }
+  }
+
+  const doc_node &_node(document &doc) {
+    nesting_guard guard(_nesting);
+    if (guard.too_deep()) return _broken_value(doc);
+    auto kind = static_cast<doc_node::kind_t>(_byte());
+    auto text = _string();
+    if (_broken) return _broken_value(doc);
+    switch (kind) {
+      case doc_node::kind_t::text:
+        return doc.text(_colored(text));
+      case doc_node::kind_t::prefix: {
+        const auto &child = _node(doc);
+        return doc.prefix(_colored(text), child);
+      }
+      case doc_node::kind_t::group:
+        break;
+      default:
+        return _broken_value(doc);
+    }
+
+    auto style = static_cast<binary_style>(_byte());
+    auto depth = _varint();
+    bool has_flat = _byte() != 0;
+    doc_node *group;
+    if (style == binary_style::square) {
+      group = &doc.bracket_group("[", depth, false);
+    } else if (style == binary_style::curly) {
+      group = &doc.bracket_group("{", depth, false);
+    } else if (style == binary_style::tuple) {
+      group = &doc.tuple_group(depth);
+    } else {
+      group = &doc.object_group(_colored(text), depth);
+    }
+    group->has_flat = has_flat;
+    while (!_broken) {
+      auto part = _byte();
+      if (part == 0) break;
+      group->add_part(&_node(doc), part == 1);
+    }
+    return *group;
+  }
+};
+
+}  // namespace _p_CPP_DUMP_ES_NAMESPACE
+
+}  // namespace _detail
+
+/**
+ * Make cpp_dump() write binary records to the file descriptor instead of the text.
+ * The records are buffered and written when the buffer is full, at flush_binary_log(), at
+ * stop_binary_log(), and at the exit. cpp_dump::replay_binary_log() and the cpp-dump-replay
+ * command in tools/ print the text from them.
+ * Call this and stop_binary_log() while no other thread calls cpp_dump().
+ */
+inline void start_binary_log(int fd) {
+  auto &storage = _detail::binary_logger_storage();
+  _detail::active_binary_logger().store(nullptr);
+  storage.reset();
+  storage = std::make_unique<_detail::binary_logger>(fd);
+  _detail::active_binary_logger().store(storage.get());
+}
+
+/**
+ * Write the buffered records and make cpp_dump() print the text again.
+ */
+inline void stop_binary_log() {
+  _detail::active_binary_logger().store(nullptr);
+  _detail::binary_logger_storage().reset();
+}
+
+/**
+ * Write the records buffered so far.
+ */
+inline void flush_binary_log() {
+  if (auto *logger = _detail::active_binary_logger().load(std::memory_order_acquire)) {
+    logger->flush();
+  }
+}
+
+}  // namespace cpp_dump
@@ -0,0 +1,266 @@
+/*
+ * Copyright (c) 2023 Ryota Sasaki.
+ *
+ * This source code is licensed under the MIT license found in the LICENSE file in the root
+ * directory of this source tree.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "./arena.hpp"
+#include "./document/token_table.hpp"
+#include "./document/writer.hpp"
+#include "./escape_sequence.hpp"
+#include "./options.hpp"
+#include "./utility.hpp"
+
+namespace cpp_dump {
+
+namespace _detail {
+
+inline namespace _p_CPP_DUMP_ES_NAMESPACE {
+
+/*
+ * The label and the expressions of a call site of cpp_dump() with the escape sequences applied.
+ * They are built with the options of the time, and a call_site keeps them for each
+ * log_label_func and colors it is used with.
+ */
+struct site_labels {
+ public:
+  template <typename Exprs>
+  site_labels(
+      std::string_view file_name,
+      std::size_t line,
+      std::string_view function_name,
+      const Exprs &exprs,
+      bool va_temp
+  )
+      : is_va_temp(va_temp),
+        _label_func_id(current_options().log_label_func.id()),
+        _es_style(current_options().es_style),
+        _log_es(current_options().es_value.log),
+        _expression_es(current_options().es_value.expression) {
+    if (const auto &log_label_func = current_options().log_label_func) {
+      raw_label = log_label_func(file_name, line, function_name);
+    }
+    label = _persistent_atom(concat(es::reset(), es::log(raw_label)));
+    label_indent = get_last_line_length(raw_label);
+    exprs_have_newline = std::any_of(exprs.begin(), exprs.end(), has_newline);
+    if (is_va_temp) {
+      va_temp_name = *exprs.begin();
+    } else {
+      for (auto expr : exprs) exprs_with_es.push_back(_persistent_atom(es::expression(expr)));
+    }
+  }
+
+  // Whether the options that these depend on are unchanged.
+  bool is_up_to_date() const {
+    const auto &o = current_options();
+    return _label_func_id == o.log_label_func.id() && _es_style == o.es_style
+           && (!use_es()
+               || (_log_es == o.es_value.log && _expression_es == o.es_value.expression));
+  }
+
+  // The label is the part of "[dump] ", and label is es::reset() + es::log(raw_label).
+  std::string raw_label;
+  atom label;
+  // The length of the last line of the label.
+  std::size_t label_indent;
+  // es::expression() of each expression, or empty if is_va_temp.
+  std::vector<atom> exprs_with_es;
+  bool exprs_have_newline;
+  // The expression of the variadic template arguments, which are printed as name[i].
+  bool is_va_temp;
+  std::string_view va_temp_name;
+
+ private:
+  std::size_t _label_func_id;
+  types::es_style_t _es_style;
+  std::string _log_es;
+  std::string _expression_es;
+};
+
+/*
+ * The labels that a call site keeps, one for each set of the options they depend on.
+ * When the table is full, the oldest labels are replaced. The dumps hold the labels they use, so
+ * the replaced ones are freed when the last dump that uses them ends.
+ */
+struct site_label_table {
+ public:
+  static constexpr std::size_t size = 4;
+
+  std::mutex mutex;
+  std::array<std::shared_ptr<const site_labels>, size> entries;
+  std::size_t next = 0;
+
+  // The labels for the current options, or nullptr. Lock the mutex first.
+  std::shared_ptr<const site_labels> find() const {
+    for (const auto &entry : entries) {
+      if (entry && entry->is_up_to_date()) return entry;
+    }
+    return nullptr;
+  }
+};
+
+/*
+ * The labels that a thread used last for the call sites, so that the dumps with the global options
+ * find them without the lock of the site or comparing the options.
+ * A call site takes the entry of its address, and an entry is valid while the label function and
+ * the global options are those it was made with.
+ */
+struct site_label_cache {
+ public:
+  static constexpr std::size_t size = 64;
+  static constexpr std::size_t unchecked = static_cast<std::size_t>(-1);
+
+  struct entry {
+    const void *site = nullptr;
+    std::size_t label_func_id = 0;
+    // The global_options_generation() of the options, or unchecked for the other options.
+    std::size_t generation = unchecked;
+    std::shared_ptr<const site_labels> labels;
+  };
+
+  static site_label_cache &get() {
+    thread_local site_label_cache cache;
+    return cache;
+  }
+
+  entry &find(const void *site) {
+    auto address = reinterpret_cast<std::uintptr_t>(site);
+    return _entries[(address >> 4) % size];
+  }
+
+  // Replace the labels of the entry. A dump running on this thread may be using the old ones, so
+  // they are kept until a dump starts outside of any other.
+  void replace(entry &e, entry fresh) {
+    if (dump_arena::get().in_scope()) {
+      if (e.labels) _retired.push_back(std::move(e.labels));
+    } else {
+      _retired.clear();
+    }
+    e = std::move(fresh);
+  }
+
+ private:
+  std::array<entry, size> _entries;
+  std::vector<std::shared_ptr<const site_labels>> _retired;
+};
+
+/*
+ * The static descriptor of a call site of cpp_dump(), created by the macro.
+ * It is initialized at compile time and never destroyed, so the records of start_async_log() can
+ * refer to it until they are written.
+ */
+template <std::size_t N>
+struct call_site {
+ public:
+  constexpr call_site(
+      std::string_view file_name, std::size_t line, std::array<std::string_view, N> exprs
+  )
+      : _file_name(file_name), _line(line), _exprs(exprs) {}
+
+  std::string_view file_name() const { return _file_name; }
+  std::size_t line() const { return _line; }
+  const std::array<std::string_view, N> &exprs() const { return _exprs; }
+
+  // Return the labels for the current options, building them if the call site has none.
+  // The function name is not a constant of the call site because __func__ is not a literal.
+  // The labels live until the next dump of this thread that starts outside of any other.
+  const site_labels &labels(std::string_view function_name, bool is_va_temp) {
+    return *_cached_labels(function_name, is_va_temp);
+  }
+
+  // labels() for a dump that ends after the next one, such as a deferred dump of start_async_log().
+  std::shared_ptr<const site_labels> shared_labels(
+      std::string_view function_name, bool is_va_temp
+  ) {
+    return _cached_labels(function_name, is_va_temp);
+  }
+
+ private:
+  std::string_view _file_name;
+  std::size_t _line;
+  std::array<std::string_view, N> _exprs;
+  // This is allocated on the first call and never freed, like the call site.
+  std::atomic<site_label_table *> _table_ptr{nullptr};
+
+  // The fast path of the dumps with the global options only reads the cache of this thread.
+  const std::shared_ptr<const site_labels> &_cached_labels(
+      std::string_view function_name, bool is_va_temp
+  ) {
+    const auto &o = current_options();
+    auto &cache = site_label_cache::get();
+    auto &entry = cache.find(this);
+    const bool cached = o.log_label_func.cached();
+    const bool is_global = is_global_options(o);
+    if (cached && is_global && entry.site == this && entry.label_func_id == o.log_label_func.id()
+        && entry.generation == global_options_generation()) {
+      return entry.labels;
+    }
+    cache.replace(
+        entry,
+        {this,
+         o.log_label_func.id(),
+         cached && is_global ? global_options_generation() : site_label_cache::unchecked,
+         _shared_labels(function_name, is_va_temp)}
+    );
+    return entry.labels;
+  }
+
+  // Find the labels in the table of the site, or build them.
+  std::shared_ptr<const site_labels> _shared_labels(
+      std::string_view function_name, bool is_va_temp
+  ) {
+    auto build = [&] {
+      return std::make_shared<const site_labels>(
+          _file_name, _line, function_name, _exprs, is_va_temp
+      );
+    };
+    if (!current_options().log_label_func.cached()) return build();
+
+    auto &table = _table();
+    {
+      std::lock_guard<std::mutex> lock(table.mutex);
+      if (auto found = table.find()) return found;
+    }
+    // The label function is called without the lock, since it may call cpp_dump().
+    auto fresh = build();
+    std::shared_ptr<const site_labels> replaced;
+    std::lock_guard<std::mutex> lock(table.mutex);
+    if (auto found = table.find()) return found;
+    auto &entry = table.entries[table.next];
+    table.next = (table.next + 1) % site_label_table::size;
+    replaced = std::move(entry);
+    entry = fresh;
+    return fresh;
+  }
+
+  site_label_table &_table() {
+    auto *table = _table_ptr.load(std::memory_order_acquire);
+    if (table) return *table;
+    auto fresh = std::make_unique<site_label_table>();
+    if (_table_ptr.compare_exchange_strong(table, fresh.get(), std::memory_order_acq_rel)) {
+      return *fresh.release();
+    }
+    // Another thread has allocated it. table is the one.
+    return *table;
+  }
+};
+
+}  // namespace _p_CPP_DUMP_ES_NAMESPACE
+
+}  // namespace _detail
+
+}  // namespace cpp_dump
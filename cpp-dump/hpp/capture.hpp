@@ -0,0 +1,108 @@
+/*
+ * Copyright (c) 2023 Ryota Sasaki.
+ *
+ * This source code is licensed under the MIT license found in the LICENSE file in the root
+ * directory of this source tree.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <deque>
+#include <forward_list>
+#include <iterator>
+#include <list>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+#include "./options.hpp"
+#include "./type_check.hpp"
+
+namespace cpp_dump {
+
+namespace _detail {
+
+inline namespace _p_CPP_DUMP_ES_NAMESPACE {
+
+template <typename>
+inline constexpr bool _is_std_sequence = false;
+template <typename... Args>
+inline constexpr bool _is_std_sequence<std::vector<Args...>> = true;
+template <typename... Args>
+inline constexpr bool _is_std_sequence<std::deque<Args...>> = true;
+template <typename... Args>
+inline constexpr bool _is_std_sequence<std::list<Args...>> = true;
+template <typename... Args>
+inline constexpr bool _is_std_sequence<std::forward_list<Args...>> = true;
+template <typename T, std::size_t N>
+inline constexpr bool _is_std_sequence<std::array<T, N>> = true;
+
+template <typename T>
+inline constexpr bool _is_std_string =
+    std::is_same_v<T, std::string> || std::is_same_v<T, std::string_view>
+    || (std::is_array_v<T> && std::is_same_v<std::remove_cv_t<std::remove_extent_t<T>>, char>);
+
+template <typename T>
+constexpr bool _is_capturable() {
+  using RawT = remove_cvref<T>;
+  if constexpr (std::is_arithmetic_v<RawT> || std::is_enum_v<RawT> || _is_std_string<RawT>) {
+    return true;
+  } else if constexpr (_is_std_sequence<RawT>) {
+    return _is_capturable<iterable_elem_type<RawT>>();
+  } else {
+    return false;
+  }
+}
+
+/*
+ * Whether cpp_dump() can copy the value and export the copy later on another thread with the same
+ * output: numbers, enums, strings, and the standard sequence containers of them.
+ * The others, such as pointers and user-defined types, may refer to what changes later.
+ */
+template <typename T>
+inline constexpr bool is_capturable = _is_capturable<T>();
+
+/*
+ * Copy a value that is_capturable.
+ * A string is stored by value, and a container becomes a std::vector of at most
+ * max_iteration_count + 1 elements, which is exported the same as the original.
+ * The numbers in a vector, a deque or an array are copied with one assign(), which is a memcpy()
+ * for a vector or an array.
+ */
+template <typename T>
+inline auto capture(const T &value) {
+  if constexpr (std::is_arithmetic_v<T> || std::is_enum_v<T>) {
+    return value;
+  } else if constexpr (_is_std_string<T>) {
+    return std::string(std::string_view(value));
+  } else {
+    using elem_t = iterable_elem_type<T>;
+    using captured_elem_t = decltype(capture(std::declval<const elem_t &>()));
+    std::vector<captured_elem_t> captured;
+    std::size_t max_size = current_options().max_iteration_count;
+    if (max_size < max_size + 1) ++max_size;
+
+    using category = typename std::iterator_traits<typename T::const_iterator>::iterator_category;
+    if constexpr (std::is_same_v<elem_t, captured_elem_t>
+                  && std::is_base_of_v<std::random_access_iterator_tag, category>) {
+      auto size = std::min<std::size_t>(value.size(), max_size);
+      captured.assign(value.begin(), value.begin() + static_cast<std::ptrdiff_t>(size));
+    } else {
+      for (const elem_t &elem : value) {
+        if (captured.size() == max_size) break;
+        captured.push_back(capture(elem));
+      }
+    }
+    return captured;
+  }
+}
+
+}  // namespace _p_CPP_DUMP_ES_NAMESPACE
+
+}  // namespace _detail
+
+}  // namespace cpp_dump
@@ -0,0 +1,53 @@
+/*
+ * Copyright (c) 2023 Ryota Sasaki.
+ *
+ * This source code is licensed under the MIT license found in the LICENSE file in the root
+ * directory of this source tree.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <string_view>
+
+namespace cpp_dump {
+
+/**
+ * A fixed-size char buffer that cpp_dump::export_to() can write to.
+ * The output that does not fit in the buffer is discarded, and truncated() becomes true.
+ * The buffer is not null-terminated.
+ */
+struct char_span {
+ public:
+  char_span(char *data, std::size_t capacity) : _data(data), _capacity(capacity) {}
+
+  template <std::size_t N>
+  explicit char_span(char (&data)[N]) : _data(data), _capacity(N) {}
+
+  void append(const char *s, std::size_t n) {
+    std::size_t copied = std::min(n, _capacity - _size);
+    std::copy_n(s, copied, _data + _size);
+    _size += copied;
+    _truncated = _truncated || copied < n;
+  }
+
+  const char *data() const { return _data; }
+  std::size_t size() const { return _size; }
+  std::size_t capacity() const { return _capacity; }
+  bool truncated() const { return _truncated; }
+  std::string_view view() const { return {_data, _size}; }
+
+  void clear() {
+    _size = 0;
+    _truncated = false;
+  }
+
+ private:
+  char *_data;
+  std::size_t _capacity;
+  std::size_t _size = 0;
+  bool _truncated = false;
+};
+
+}  // namespace cpp_dump
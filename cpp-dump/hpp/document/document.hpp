@@ -0,0 +1,186 @@
+/*
+ * Copyright (c) 2023 Ryota Sasaki.
+ *
+ * This source code is licensed under the MIT license found in the LICENSE file in the root
+ * directory of this source tree.
+ */
+
+#pragma once
+
+#include <initializer_list>
+#include <memory>
+#include <memory_resource>
+#include <new>
+#include <string_view>
+#include <vector>
+
+#include "../arena.hpp"
+#include "./token_table.hpp"
+#include "./writer.hpp"
+
+namespace cpp_dump {
+
+namespace _detail {
+
+inline namespace _p_CPP_DUMP_ES_NAMESPACE {
+
+/*
+ * A node of the width-independent representation of a value.
+ * export_var() builds the nodes once per value, and layout() decides where to break lines.
+ */
+struct doc_node {
+ public:
+  enum class kind_t { text, prefix, group };
+
+  // text:   `text` as it is.
+  // prefix: `text` followed by `child`.
+  // group:  `text` followed by the items laid out in `style`.
+  //         An item consists of parts printed one after another.
+  kind_t kind;
+  // False if the node can never be printed on one line.
+  bool has_flat;
+  // The index of the node in the document.
+  std::size_t id;
+  // Either `own_text` or a token of the token_table of the document.
+  const atom *text{&own_text};
+  atom own_text;
+  const doc_node *child{nullptr};
+  const group_style *style{nullptr};
+  const doc_node *first_part{nullptr};
+
+  // The parts of a group are linked to each other so that adding an item allocates nothing.
+  // These are set when the node is added to a group.
+  mutable const doc_node *next_part{nullptr};
+  mutable bool starts_item{false};
+
+  doc_node(kind_t kind_, std::size_t id_, atom own_text_)
+      : kind(kind_), has_flat(true), id(id_), own_text(std::move(own_text_)) {}
+
+  // `text` may point to `own_text`, so the nodes are never copied.
+  doc_node(const doc_node &) = delete;
+  doc_node &operator=(const doc_node &) = delete;
+
+  void add_item(std::initializer_list<const doc_node *> parts) {
+    bool is_first_part = true;
+    for (auto part : parts) {
+      add_part(part, is_first_part);
+      is_first_part = false;
+    }
+  }
+
+  // Start a new item with `part`, or append `part` to the last item.
+  void add_part(const doc_node *part, bool new_item) {
+    has_flat = has_flat && part->has_flat;
+    part->starts_item = new_item;
+    if (_last_part) {
+      _last_part->next_part = part;
+    } else {
+      first_part = part;
+    }
+    _last_part = part;
+  }
+
+ private:
+  const doc_node *_last_part{nullptr};
+};
+
+/*
+ * Owner of the nodes built while exporting the arguments of one cpp_dump() or export_var() call.
+ * The nodes are allocated from dump_arena::resource().
+ */
+struct document {
+ public:
+  document()
+      : _resource(dump_arena::resource()), _tokens(token_table::current()), _blocks(_resource) {}
+  ~document() {
+    for (std::size_t i = 0; i < _size; ++i) {
+      _blocks[i / _block_size][i % _block_size].~doc_node();
+    }
+    for (auto block : _blocks) {
+      _resource->deallocate(block, sizeof(doc_node) * _block_size, alignof(doc_node));
+    }
+  }
+  document(document &&) = delete;
+  document &operator=(document &&) = delete;
+  document(const document &) = delete;
+  document &operator=(const document &) = delete;
+
+  std::size_t size() const { return _size; }
+
+  // The tokens for the options at the time the document was made.
+  const token_table &tokens() const { return *_tokens; }
+
+  const doc_node &text(temp_string s) {
+    auto &node = _new_node(doc_node::kind_t::text, atom(std::move(s)));
+    node.has_flat = !node.own_text.has_newline;
+    return node;
+  }
+
+  // A text node that refers to a token of tokens() instead of copying it.
+  const doc_node &token(const atom &t) {
+    auto &node = _new_node(doc_node::kind_t::text);
+    node.text = &t;
+    node.has_flat = !t.has_newline;
+    return node;
+  }
+
+  const doc_node &prefix(temp_string s, const doc_node &child) {
+    auto &node = _new_node(doc_node::kind_t::prefix, atom(std::move(s)));
+    node.has_flat = child.has_flat;
+    node.child = &child;
+    return node;
+  }
+
+  // `[ a, b ]` or `{ a, b }` (Container, Set and Map categories)
+  doc_node &bracket_group(std::string_view open, std::size_t current_depth, bool force_break) {
+    auto &node = _new_node(doc_node::kind_t::group);
+    node.has_flat = !force_break;
+    auto &t = _tokens->depth(current_depth);
+    node.style = open == "[" ? &t.square : &t.curly;
+    return node;
+  }
+
+  // `( a, b )` (Tuple category)
+  doc_node &tuple_group(std::size_t current_depth) {
+    auto &node = _new_node(doc_node::kind_t::group);
+    node.has_flat = true;
+    node.style = &_tokens->depth(current_depth).tuple;
+    return node;
+  }
+
+  // `class_name{ member= a, member= b }` (User-defined category and the like)
+  doc_node &object_group(std::string_view class_name, std::size_t current_depth) {
+    auto &node = _new_node(doc_node::kind_t::group, atom(make_temp_string(class_name)));
+    node.has_flat = true;
+    node.style = &_tokens->depth(current_depth).object;
+    return node;
+  }
+
+ private:
+  static constexpr std::size_t _block_size = 64;
+
+  std::pmr::memory_resource *_resource;
+  // The nodes refer to the tokens, so the document keeps the table alive even if the options
+  // change and the table of this thread is rebuilt.
+  std::shared_ptr<const token_table> _tokens;
+  // The nodes are never moved, so they can refer to each other.
+  std::pmr::vector<doc_node *> _blocks;
+  std::size_t _size = 0;
+
+  doc_node &_new_node(doc_node::kind_t kind, atom text = atom()) {
+    if (_size % _block_size == 0) {
+      _blocks.push_back(static_cast<doc_node *>(
+          _resource->allocate(sizeof(doc_node) * _block_size, alignof(doc_node))
+      ));
+    }
+    auto node = new (&_blocks.back()[_size % _block_size]) doc_node(kind, _size, std::move(text));
+    ++_size;
+    return *node;
+  }
+};
+
+}  // namespace _p_CPP_DUMP_ES_NAMESPACE
+
+}  // namespace _detail
+
+}  // namespace cpp_dump
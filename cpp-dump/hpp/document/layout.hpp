@@ -0,0 +1,184 @@
+/*
+ * Copyright (c) 2023 Ryota Sasaki.
+ *
+ * This source code is licensed under the MIT license found in the LICENSE file in the root
+ * directory of this source tree.
+ */
+
+#pragma once
+
+#include <limits>
+#include <memory_resource>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "../arena.hpp"
+#include "../options.hpp"
+#include "./document.hpp"
+#include "./writer.hpp"
+
+namespace cpp_dump {
+
+namespace _detail {
+
+inline namespace _p_CPP_DUMP_ES_NAMESPACE {
+
+/*
+ * The lengths of the nodes printed on one line, computed during one cpp_dump() or export_var()
+ * call.
+ * cpp_dump() lays out the same nodes for several patterns, and every group checks whether it
+ * fits on one line before its parent is printed, so most lengths are requested more than once.
+ * A node already identifies the object, its type, depth and export_command, and the one-line
+ * form does not depend on anything else, so the node is the key.
+ */
+struct render_cache {
+ public:
+  std::size_t hits() const { return _hits; }
+  std::size_t misses() const { return _misses; }
+
+  // The length of the node printed on one line. The node must have the one-line form.
+  std::size_t flat_length(const doc_node &node) {
+    if (node.kind == doc_node::kind_t::text) {
+      return node.text->length();
+    }
+
+    if (node.id < _flat_length.size() && _flat_length[node.id] != _npos) {
+      ++_hits;
+      return _flat_length[node.id];
+    }
+    ++_misses;
+
+    std::size_t length = node.text->length();
+    if (node.kind == doc_node::kind_t::prefix) {
+      length += flat_length(*node.child);
+    } else {
+      length += node.style->flat_open.length() + node.style->flat_close.length();
+      for (auto part = node.first_part; part; part = part->next_part) {
+        if (part->starts_item && part != node.first_part) {
+          length += node.style->flat_sep.length();
+        }
+        length += flat_length(*part);
+      }
+    }
+
+    if (_flat_length.size() <= node.id) {
+      _flat_length.resize(node.id + 1, _npos);
+    }
+    _flat_length[node.id] = length;
+    return length;
+  }
+
+ private:
+  static constexpr std::size_t _npos = std::numeric_limits<std::size_t>::max();
+
+  std::pmr::vector<std::size_t> _flat_length{dump_arena::resource()};
+  std::size_t _hits = 0;
+  std::size_t _misses = 0;
+};
+
+// helper for layout()
+// Write the node printed on one line.
+template <typename Sink>
+inline void _layout_flat(const doc_node &node, basic_writer<Sink> &output) {
+  output.append(*node.text);
+  switch (node.kind) {
+    case doc_node::kind_t::text:
+      return;
+    case doc_node::kind_t::prefix:
+      _layout_flat(*node.child, output);
+      return;
+    default:
+      break;
+  }
+
+  output.append(node.style->flat_open);
+  for (auto part = node.first_part; part; part = part->next_part) {
+    if (part->starts_item && part != node.first_part) {
+      output.append(node.style->flat_sep);
+    }
+    _layout_flat(*part, output);
+  }
+  output.append(node.style->flat_close);
+}
+
+/*
+ * Write the string representation of the node to `output`.
+ * If `fail_on_newline` is true, this writes a newline when the node cannot be printed on one
+ * line.
+ */
+template <typename Sink>
+inline void layout(
+    const doc_node &node,
+    basic_writer<Sink> &output,
+    std::string_view indent,
+    bool fail_on_newline,
+    render_cache &cache
+) {
+  switch (node.kind) {
+    case doc_node::kind_t::text:
+      output.append(*node.text);
+      return;
+    case doc_node::kind_t::prefix:
+      output.append(*node.text);
+      layout(*node.child, output, indent, fail_on_newline, cache);
+      return;
+    default:
+      break;
+  }
+
+  // Try printing on one line.
+  if (node.has_flat
+      && output.column() + cache.flat_length(node) <= current_options().max_line_width) {
+    _layout_flat(node, output);
+    return;
+  }
+
+  // Print on multiple lines.
+
+  if (fail_on_newline) {
+    output.newline("");
+    return;
+  }
+
+  const auto &style = *node.style;
+  auto new_indent = concat(indent, "  ");
+  output.append(*node.text);
+  output.append(style.broken_open);
+  for (auto part = node.first_part; part; part = part->next_part) {
+    if (part->starts_item) {
+      if (part != node.first_part) {
+        output.append(style.broken_sep);
+      }
+      if (style.newline_before_item) {
+        output.newline(new_indent);
+      } else {
+        output.append(new_indent, new_indent.size());
+      }
+    }
+    layout(*part, output, new_indent, false, cache);
+  }
+  output.newline(indent);
+  output.append(style.broken_close);
+}
+
+/*
+ * Return the string representation of the node.
+ */
+inline std::string layout(
+    const doc_node &node,
+    std::string_view indent,
+    std::size_t last_line_length,
+    bool fail_on_newline,
+    render_cache &cache
+) {
+  writer output(last_line_length);
+  layout(node, output, indent, fail_on_newline, cache);
+  return std::string(output.str());
+}
+
+}  // namespace _p_CPP_DUMP_ES_NAMESPACE
+
+}  // namespace _detail
+
+}  // namespace cpp_dump
@@ -0,0 +1,253 @@
+/*
+ * Copyright (c) 2023 Ryota Sasaki.
+ *
+ * This source code is licensed under the MIT license found in the LICENSE file in the root
+ * directory of this source tree.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <memory>
+#include <memory_resource>
+#include <string>
+#include <vector>
+
+#include "../escape_sequence.hpp"
+#include "../options.hpp"
+#include "./writer.hpp"
+
+namespace cpp_dump {
+
+namespace _detail {
+
+inline namespace _p_CPP_DUMP_ES_NAMESPACE {
+
+/*
+ * The brackets and separators of a group.
+ * A group is printed as `flat_open item flat_sep item ... flat_close` on one line, and as
+ * `broken_open [\n]indent item broken_sep [\n]indent item ... \n broken_close` otherwise.
+ */
+struct group_style {
+ public:
+  atom flat_open;
+  atom flat_sep;
+  atom flat_close;
+  atom broken_open;
+  atom broken_sep;
+  atom broken_close;
+  bool newline_before_item{true};
+};
+
+/*
+ * The tokens colored by es_value.bracket_by_depth.
+ */
+struct depth_tokens {
+ public:
+  group_style square;  // [ a, b ]
+  group_style curly;   // { a, b }
+  group_style tuple;   // ( a, b )
+  group_style object;  // class_name{ member= a, member= b }
+
+  atom empty_square;    // [ ]
+  atom empty_curly;     // { }
+  atom empty_paren;     // ( )
+  atom omitted_square;  // [ ... ]
+  atom omitted_curly;   // { ... }
+  atom omitted_paren;   // ( ... )
+};
+
+/*
+ * The fixed tokens with the escape sequences already applied and the lengths already measured.
+ * Exporters refer to these instead of coloring the same tokens for every element.
+ * A table is built from the options it was built with and never changes, so the nodes of a
+ * document can point to its atoms.
+ */
+struct token_table {
+ public:
+  // Incremented every time a table is rebuilt because the options have changed.
+  std::size_t epoch;
+
+  atom ellipsis;  // ...
+  atom colon;     // `: ` after an index or a key
+  atom equal;     // `= ` after a member name
+  atom nullptr_;  // nullptr
+  // Indexed by export_command::bool_style_t, then by the value.
+  std::array<std::array<atom, 2>, 4> bools;
+
+  atom log_comma;          // `, ` between the arguments of cpp_dump()
+  atom log_comma_newline;  // `,\n` between the arguments of cpp_dump()
+  atom log_arrow;          // ` => ` after an expression
+  atom log_arrow_newline;  // `=> ` at the start of a line
+
+  // Use depth() to look these up.
+  std::vector<depth_tokens> by_depth;
+
+  const depth_tokens &depth(std::size_t current_depth) const {
+    return by_depth[current_depth % by_depth.size()];
+  }
+
+  // Return the table for the current options, rebuilding it if they have changed since the last
+  // call on this thread.
+  static std::shared_ptr<const token_table> current();
+
+  // Build a new table for the current options, which the threads can share since it never changes.
+  static std::shared_ptr<const token_table> build();
+
+ private:
+  types::es_style_t _es_style;
+  types::es_value_t _es_value;
+  bool _detailed_class_es;
+  bool _detailed_member_es;
+  bool _detailed_number_es;
+
+  bool _is_up_to_date() const;
+  void _build(std::size_t new_epoch);
+};
+
+inline bool token_table::_is_up_to_date() const {
+  const auto &o = current_options();
+  return _es_style == o.es_style && _detailed_class_es == o.detailed_class_es
+         && _detailed_member_es == o.detailed_member_es
+         && _detailed_number_es == o.detailed_number_es && _is_equal(_es_value, o.es_value);
+}
+
+// helper for token_table::_build()
+// The table outlives the dump that builds it, so its strings must not come from the dump_arena.
+inline atom _persistent_atom(const temp_string &s) {
+  return atom(temp_string(s, std::pmr::get_default_resource()));
+}
+
+inline void token_table::_build(std::size_t new_epoch) {
+  const auto &o = current_options();
+  epoch = new_epoch;
+  _es_style = o.es_style;
+  _es_value = o.es_value;
+  _detailed_class_es = o.detailed_class_es;
+  _detailed_member_es = o.detailed_member_es;
+  _detailed_number_es = o.detailed_number_es;
+
+  ellipsis = _persistent_atom(es::op("..."));
+  colon = _persistent_atom(es::op(": "));
+  equal = _persistent_atom(es::op("= "));
+  nullptr_ = _persistent_atom(es::reserved("nullptr"));
+  bools = {{
+      {_persistent_atom(es::reserved("false")), _persistent_atom(es::reserved("true"))},
+      {_persistent_atom(es::reserved("false")), _persistent_atom(es::reserved("true "))},
+      {_persistent_atom(es::reserved("false")), _persistent_atom(es::reserved(" true"))},
+      {_persistent_atom(es::number("0")), _persistent_atom(es::number("1"))},
+  }};
+
+  log_comma = _persistent_atom(es::log(", "));
+  log_comma_newline = _persistent_atom(es::log(",\n"));
+  log_arrow = _persistent_atom(es::log(" => "));
+  log_arrow_newline = _persistent_atom(es::log("=> "));
+
+  // es::bracket() repeats the colors of bracket_by_depth, so this many depths cover all of them.
+  by_depth.resize(std::max<std::size_t>(o.es_value.bracket_by_depth.size(), 1));
+  for (std::size_t d = 0; d < by_depth.size(); ++d) {
+    auto &t = by_depth[d];
+    for (auto style : {&t.square, &t.curly}) {
+      std::string open = style == &t.square ? "[" : "{";
+      std::string close = style == &t.square ? "]" : "}";
+      style->flat_open = _persistent_atom(es::bracket(open + " ", d));
+      style->flat_sep = _persistent_atom(es::op(", "));
+      style->flat_close = _persistent_atom(es::bracket(" " + close, d));
+      style->broken_open = _persistent_atom(es::bracket(open, d));
+      style->broken_sep = _persistent_atom(es::op(","));
+      style->broken_close = _persistent_atom(es::bracket(close, d));
+    }
+
+    t.tuple.flat_open = _persistent_atom(es::bracket("( ", d));
+    t.tuple.flat_sep = _persistent_atom(es::op(", "));
+    t.tuple.flat_close = _persistent_atom(es::bracket(" )", d));
+    t.tuple.broken_open = _persistent_atom(es::bracket("(\n", d));
+    t.tuple.broken_sep = _persistent_atom(es::op(",\n"));
+    t.tuple.broken_close = _persistent_atom(es::bracket(")", d));
+    t.tuple.newline_before_item = false;
+
+    t.object.flat_open = _persistent_atom(es::bracket("{ ", d));
+    t.object.flat_sep = _persistent_atom(es::op(", "));
+    t.object.flat_close = _persistent_atom(es::bracket(" }", d));
+    t.object.broken_open = t.object.flat_open;
+    t.object.broken_sep = t.object.flat_sep;
+    t.object.broken_close = _persistent_atom(es::bracket("}", d));
+
+    t.empty_square = _persistent_atom(es::bracket("[ ]", d));
+    t.empty_curly = _persistent_atom(es::bracket("{ }", d));
+    t.empty_paren = _persistent_atom(es::bracket("( )", d));
+    t.omitted_square =
+        _persistent_atom(es::bracket("[ ", d) + es::op("...") + es::bracket(" ]", d));
+    t.omitted_curly =
+        _persistent_atom(es::bracket("{ ", d) + es::op("...") + es::bracket(" }", d));
+    t.omitted_paren =
+        _persistent_atom(es::bracket("( ", d) + es::op("...") + es::bracket(" )", d));
+  }
+}
+
+// The table of the dumper running on this thread, or nullptr.
+inline thread_local const token_table *dumper_tokens = nullptr;
+
+inline std::shared_ptr<const token_table> token_table::current() {
+  // A dumper builds its table in advance and outlives its dumps, so this does not own it.
+  if (dumper_tokens) {
+    return std::shared_ptr<const token_table>(std::shared_ptr<const token_table>(), dumper_tokens);
+  }
+
+  // Each thread has its own table so that rebuilding it never races with another dump.
+  // A document keeps the table it started with, so rebuilding never invalidates its nodes.
+  thread_local std::shared_ptr<const token_table> table;
+  thread_local std::size_t last_epoch = 0;
+  // The global_options_generation() when the table was last checked against the global options,
+  // so that the dumps with unchanged global options do not compare es_value.
+  constexpr std::size_t unchecked = static_cast<std::size_t>(-1);
+  thread_local std::size_t checked_generation = unchecked;
+
+  const bool is_global = is_global_options(current_options());
+  if (!table || !is_global || checked_generation != global_options_generation()) {
+    if (!table || !table->_is_up_to_date()) {
+      auto new_table = std::make_shared<token_table>();
+      new_table->_build(++last_epoch);
+      table = std::move(new_table);
+    }
+    checked_generation = is_global ? global_options_generation() : unchecked;
+  }
+  return table;
+}
+
+inline std::shared_ptr<const token_table> token_table::build() {
+  auto table = std::make_shared<token_table>();
+  table->_build(0);
+  return table;
+}
+
+/*
+ * RAII guard that makes the dumps of this thread use the options and the tokens of a dumper,
+ * or those that binary_encoder exports the documents with.
+ * Unlike dump_options_scope, this replaces the options of the dump running on this thread.
+ */
+struct dumper_scope {
+ public:
+  dumper_scope(const types::options_snapshot_t &options, const token_table *tokens)
+      : _outer_options(dump_options), _outer_tokens(dumper_tokens) {
+    dump_options = &options;
+    dumper_tokens = tokens;
+  }
+  ~dumper_scope() {
+    dump_options = _outer_options;
+    dumper_tokens = _outer_tokens;
+  }
+  dumper_scope(const dumper_scope &) = delete;
+  dumper_scope &operator=(const dumper_scope &) = delete;
+
+ private:
+  const types::options_snapshot_t *_outer_options;
+  const token_table *_outer_tokens;
+};
+
+}  // namespace _p_CPP_DUMP_ES_NAMESPACE
+
+}  // namespace _detail
+
+}  // namespace cpp_dump
@@ -0,0 +1,147 @@
+/*
+ * Copyright (c) 2023 Ryota Sasaki.
+ *
+ * This source code is licensed under the MIT license found in the LICENSE file in the root
+ * directory of this source tree.
+ */
+
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <utility>
+
+#include "../arena.hpp"
+#include "../utility.hpp"
+
+namespace cpp_dump {
+
+namespace _detail {
+
+inline namespace _p_CPP_DUMP_ES_NAMESPACE {
+
+/*
+ * A string measured once when it is made.
+ * The lengths are the visible lengths, which exclude escape sequences.
+ */
+struct atom {
+ public:
+  temp_string str;
+  bool has_newline;
+  // The length of the first line (the whole string if it has no newline).
+  std::size_t first_line_length;
+  // The length of the last line (the whole string if it has no newline).
+  std::size_t last_line_length;
+
+  atom() : has_newline(false), first_line_length(0), last_line_length(0) {}
+
+  explicit atom(temp_string s) : str(std::move(s)) {
+    auto metrics = measure_text(str);
+    has_newline = metrics.has_newline;
+    first_line_length = metrics.first_line_length;
+    last_line_length = metrics.last_line_length;
+  }
+
+  // The length of the string with no newline.
+  std::size_t length() const { return first_line_length; }
+};
+
+/*
+ * An output that keeps track of the column where the next character is written,
+ * so that exporters never need to scan what they have already written.
+ * Sink is temp_string, which the writer owns, or a reference to a type that has
+ * append(const char *, std::size_t).
+ */
+template <typename Sink>
+struct basic_writer {
+ public:
+  explicit basic_writer(std::size_t column = 0)
+      : _sink(make_temp_string()), _column(column), _has_newline(false), _first_line_length(0) {}
+
+  explicit basic_writer(Sink sink, std::size_t column)
+      : _sink(sink), _column(column), _has_newline(false), _first_line_length(0) {}
+
+  void append(const atom &a) {
+    _append(a.str, a.has_newline, a.first_line_length, a.last_line_length);
+  }
+
+  // Append a string with no newline whose length is `length`.
+  void append(std::string_view s, std::size_t length) {
+    _sink.append(s.data(), s.size());
+    _column += length;
+  }
+
+  // Append a string that is not measured yet.
+  void append(std::string_view s) {
+    auto metrics = measure_text(s);
+    _append(s, metrics.has_newline, metrics.first_line_length, metrics.last_line_length);
+  }
+
+  // Append the output of `w`, which must have started at the column of this writer.
+  void append(const basic_writer<temp_string> &w) {
+    _sink.append(w.str().data(), w.str().size());
+    if (w.has_newline()) {
+      _on_newline(w.first_line_length());
+    }
+    _column = w.column();
+  }
+
+  // Start a new line with `indent`.
+  void newline(std::string_view indent) {
+    _sink.append("\n", 1);
+    _sink.append(indent.data(), indent.size());
+    _on_newline(_column);
+    _column = indent.size();
+  }
+
+  void clear() {
+    _sink.clear();
+    _column = 0;
+    _has_newline = false;
+    _first_line_length = 0;
+  }
+
+  const Sink &str() const { return _sink; }
+  Sink release() { return std::move(_sink); }
+  bool empty() const { return _sink.empty(); }
+  std::size_t column() const { return _column; }
+  bool has_newline() const { return _has_newline; }
+  // The column where the first line ends (the current column if no newline was written).
+  std::size_t first_line_length() const { return _has_newline ? _first_line_length : _column; }
+
+ private:
+  Sink _sink;
+  std::size_t _column;
+  bool _has_newline;
+  std::size_t _first_line_length;
+
+  void _append(
+      std::string_view s,
+      bool newline,
+      std::size_t first_line_length,
+      std::size_t last_line_length
+  ) {
+    if (!newline) {
+      append(s, first_line_length);
+      return;
+    }
+    _sink.append(s.data(), s.size());
+    _on_newline(_column + first_line_length);
+    _column = last_line_length;
+  }
+
+  void _on_newline(std::size_t first_line_length) {
+    if (!_has_newline) {
+      _has_newline = true;
+      _first_line_length = first_line_length;
+    }
+  }
+};
+
+using writer = basic_writer<temp_string>;
+
+}  // namespace _p_CPP_DUMP_ES_NAMESPACE
+
+}  // namespace _detail
+
+}  // namespace cpp_dump
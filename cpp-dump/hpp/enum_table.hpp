@@ -0,0 +1,123 @@
+/*
+ * Copyright (c) 2023 Ryota Sasaki.
+ *
+ * This source code is licensed under the MIT license found in the LICENSE file in the root
+ * directory of this source tree.
+ */
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+namespace cpp_dump {
+
+namespace _detail {
+
+/*
+ * The names of the enumerators of T, built at compile time by CPP_DUMP_DEFINE_EXPORT_ENUM() and
+ * CPP_DUMP_DEFINE_EXPORT_ENUM_GENERIC().
+ * If the values span at most twice as many integers as there are enumerators, a value is looked up
+ * with a single index into a dense array. Otherwise, it is looked up by binary search.
+ * If a value is given twice, the first name is used.
+ */
+template <typename T, std::size_t N>
+struct enum_table {
+ public:
+  constexpr explicit enum_table(const std::pair<T, std::string_view> (&entries)[N]) {
+    // Sort the entries by value with a stable insertion sort, so the first of the same values
+    // comes first.
+    for (std::size_t i = 0; i < N; ++i) {
+      std::size_t j = i;
+      for (; j > 0 && _key(entries[i].first) < _key(_entries[j - 1].value); --j) {
+        _entries[j] = _entries[j - 1];
+      }
+      _entries[j] = {entries[i].first, entries[i].second};
+    }
+    // Remove the values given twice.
+    for (std::size_t i = 0; i < N; ++i) {
+      if (_size == 0 || _key(_entries[i].value) != _key(_entries[_size - 1].value)) {
+        _entries[_size++] = _entries[i];
+      }
+    }
+
+    _min = _unsigned_key(_entries[0].value);
+    std::uint64_t span = _unsigned_key(_entries[_size - 1].value) - _min;
+    _dense = span < _dense_capacity;
+    if (_dense) {
+      for (std::size_t i = 0; i < _size; ++i) {
+        _dense_index[_unsigned_key(_entries[i].value) - _min] = static_cast<index_t>(i + 1);
+      }
+    }
+  }
+
+  // Return the name of the value, or an empty string if the value has no name.
+  constexpr std::string_view find(T value) const {
+    if (_dense) {
+      std::uint64_t offset = _unsigned_key(value) - _min;
+      if (offset >= _dense_capacity || _dense_index[offset] == 0) {
+        return {};
+      }
+      return _entries[_dense_index[offset] - 1].name;
+    }
+
+    std::size_t first = 0;
+    std::size_t last = _size;
+    while (first < last) {
+      std::size_t middle = first + (last - first) / 2;
+      if (_key(_entries[middle].value) < _key(value)) {
+        first = middle + 1;
+      } else {
+        last = middle;
+      }
+    }
+    if (first < _size && _key(_entries[first].value) == _key(value)) {
+      return _entries[first].name;
+    }
+    return {};
+  }
+
+  // Whether find() indexes a dense array.
+  constexpr bool dense() const { return _dense; }
+
+ private:
+  using underlying_t = std::underlying_type_t<T>;
+  using index_t = std::conditional_t<
+      (N < 0xff),
+      std::uint8_t,
+      std::conditional_t<(N < 0xffff), std::uint16_t, std::uint32_t>>;
+  static constexpr std::size_t _dense_capacity = N * 2;
+
+  // std::pair cannot be assigned in a constant expression until C++20.
+  struct entry {
+    T value;
+    std::string_view name;
+  };
+
+  std::array<entry, N> _entries{};
+  std::size_t _size = 0;
+  bool _dense = false;
+  std::uint64_t _min = 0;
+  // The index in _entries plus one, or 0 for the values with no name.
+  std::array<index_t, _dense_capacity> _dense_index{};
+
+  static constexpr underlying_t _key(T value) { return static_cast<underlying_t>(value); }
+
+  // The offsets from the minimum do not overflow in std::uint64_t, even for signed values.
+  static constexpr std::uint64_t _unsigned_key(T value) {
+    return static_cast<std::uint64_t>(static_cast<std::int64_t>(_key(value)));
+  }
+};
+
+template <typename T, std::size_t N>
+constexpr enum_table<T, N> make_enum_table(const std::pair<T, std::string_view> (&entries)[N]) {
+  return enum_table<T, N>(entries);
+}
+
+}  // namespace _detail
+
+}  // namespace cpp_dump
@@ -13,75 +13,106 @@
 #include <string_view>
 #include <vector>
 
+#include "./arena.hpp"
 #include "./options.hpp"
 
+/*
+ * The inline namespace of the code that depends on CPP_DUMP_DISABLE_ES, which is every header
+ * that includes this one. The translation units with and without the macro get their own copies
+ * of that code, so they can be linked into one program.
+ * The options, write_log() and the destinations of the logs are outside of it and shared by both.
+ */
+#if defined(CPP_DUMP_DISABLE_ES)
+#define _p_CPP_DUMP_ES_NAMESPACE _without_es
+#define _p_CPP_DUMP_ES_NAMESPACE_NAME "_without_es"
+#else
+#define _p_CPP_DUMP_ES_NAMESPACE _with_es
+#define _p_CPP_DUMP_ES_NAMESPACE_NAME "_with_es"
+#endif
+
 namespace cpp_dump {
 
 namespace _detail {
 
-inline bool use_es() { return options::es_style != types::es_style_t::no_es; }
+inline namespace _p_CPP_DUMP_ES_NAMESPACE {
+
+#if defined(CPP_DUMP_DISABLE_ES)
+// The escape sequences are disabled at compile time.
+// Every branch on this is a constant, so the code for the escape sequences is removed.
+inline constexpr bool use_es() { return false; }
+#else
+inline bool use_es() { return current_options().es_style != types::es_style_t::no_es; }
+#endif
 
 namespace es {
 
 inline constexpr std::string_view _reset_es = "\x1b[0m";
 
-inline std::string reset() { return use_es() ? std::string(_reset_es) : std::string(); }
+inline temp_string reset() { return make_temp_string(use_es() ? _reset_es : ""); }
 
-inline std::string apply(std::string_view es, std::string_view s) {
+inline temp_string apply(std::string_view es, std::string_view s) {
   if (use_es()) {
-    std::string retval(es);
+    auto retval = make_temp_string(es);
     retval.append(s).append(_reset_es);
     return retval;
   }
-  return std::string(s);
+  return make_temp_string(s);
 }
 
-inline std::string log(std::string_view s) { return es::apply(options::es_value.log, s); }
-inline std::string expression(std::string_view s) {
-  return es::apply(options::es_value.expression, s);
+inline temp_string log(std::string_view s) { return es::apply(current_options().es_value.log, s); }
+inline temp_string expression(std::string_view s) {
+  return es::apply(current_options().es_value.expression, s);
+}
+inline temp_string reserved(std::string_view s) {
+  return es::apply(current_options().es_value.reserved, s);
+}
+inline temp_string number(std::string_view s) {
+  return es::apply(current_options().es_value.number, s);
 }
-inline std::string reserved(std::string_view s) { return es::apply(options::es_value.reserved, s); }
-inline std::string number(std::string_view s) { return es::apply(options::es_value.number, s); }
-inline std::string character(std::string_view s) {
-  return es::apply(options::es_value.character, s);
+inline temp_string character(std::string_view s) {
+  return es::apply(current_options().es_value.character, s);
 }
-inline std::string escaped_char(std::string_view s) {
-  return es::apply(options::es_value.escaped_char, s);
+inline temp_string escaped_char(std::string_view s) {
+  return es::apply(current_options().es_value.escaped_char, s);
 }
-inline std::string op(std::string_view s) { return es::apply(options::es_value.op, s); }
-inline std::string identifier(std::string_view s) {
-  return es::apply(options::es_value.identifier, s);
+inline temp_string op(std::string_view s) { return es::apply(current_options().es_value.op, s); }
+inline temp_string identifier(std::string_view s) {
+  return es::apply(current_options().es_value.identifier, s);
 }
-inline std::string member(std::string_view s) { return es::apply(options::es_value.member, s); }
-inline std::string unsupported(std::string_view s) {
-  return es::apply(options::es_value.unsupported, s);
+inline temp_string member(std::string_view s) {
+  return es::apply(current_options().es_value.member, s);
 }
-inline std::string class_op(std::string_view s) { return es::apply(options::es_value.class_op, s); }
-inline std::string member_op(std::string_view s) {
-  return es::apply(options::es_value.member_op, s);
+inline temp_string unsupported(std::string_view s) {
+  return es::apply(current_options().es_value.unsupported, s);
 }
-inline std::string number_op(std::string_view s) {
-  return es::apply(options::es_value.number_op, s);
+inline temp_string class_op(std::string_view s) {
+  return es::apply(current_options().es_value.class_op, s);
+}
+inline temp_string member_op(std::string_view s) {
+  return es::apply(current_options().es_value.member_op, s);
+}
+inline temp_string number_op(std::string_view s) {
+  return es::apply(current_options().es_value.number_op, s);
 }
 
-inline std::string bracket(std::string_view s, std::size_t d) {
-  auto size = options::es_value.bracket_by_depth.size();
+inline temp_string bracket(std::string_view s, std::size_t d) {
+  auto size = current_options().es_value.bracket_by_depth.size();
   if (size == 0) {
-    return std::string(s);
+    return make_temp_string(s);
   }
-  return es::apply(options::es_value.bracket_by_depth[d % size], s);
+  return es::apply(current_options().es_value.bracket_by_depth[d % size], s);
 }
 
-inline std::string type_name(std::string_view s) {
+inline temp_string type_name(std::string_view s) {
   if (!use_es()) {
-    return std::string(s);
+    return make_temp_string(s);
   }
 
   auto is_operator = [](char c) {
     return !(std::isalnum(static_cast<unsigned char>(c)) || c == '_');
   };
 
-  std::string output;
+  auto output = make_temp_string();
   auto begin = s.begin();
   decltype(begin) end;
   while ((end = std::find_if(begin, s.end(), is_operator)) != s.end()) {
@@ -101,19 +132,19 @@ inline std::string type_name(std::string_view s) {
   return output;
 }
 
-inline std::string class_name(std::string_view s) {
+inline temp_string class_name(std::string_view s) {
   if (!use_es()) {
-    return std::string(s);
+    return make_temp_string(s);
   }
-  if (!options::detailed_class_es) {
+  if (!current_options().detailed_class_es) {
     return es::identifier(s);
   }
   return es::type_name(s);
 }
 
-inline std::string enumerator(std::string_view s) {
+inline temp_string enumerator(std::string_view s) {
   if (!use_es()) {
-    return std::string(s);
+    return make_temp_string(s);
   }
 
   auto is_operator = [](char c) {
@@ -143,11 +174,11 @@ inline std::string enumerator(std::string_view s) {
          + es::member({&*op_end, static_cast<std::size_t>(len_member2 >= 0 ? len_member2 : 0)});
 }
 
-inline std::string class_member(std::string_view s) {
+inline temp_string class_member(std::string_view s) {
   if (!use_es()) {
-    return std::string(s);
+    return make_temp_string(s);
   }
-  if (!options::detailed_member_es) {
+  if (!current_options().detailed_member_es) {
     return es::member(s);
   }
 
@@ -155,7 +186,7 @@ inline std::string class_member(std::string_view s) {
     return !(std::isalnum(static_cast<unsigned char>(c)) || c == '_');
   };
 
-  std::string output;
+  auto output = make_temp_string();
   auto begin = s.begin();
   decltype(begin) end;
   while ((end = std::find_if(begin, s.end(), is_operator)) != s.end()) {
@@ -175,11 +206,11 @@ inline std::string class_member(std::string_view s) {
   return output;
 }
 
-inline std::string signed_number(std::string_view s) {
+inline temp_string signed_number(std::string_view s) {
   if (!use_es()) {
-    return std::string(s);
+    return make_temp_string(s);
   }
-  if (!options::detailed_number_es) {
+  if (!current_options().detailed_number_es) {
     return es::number(s);
   }
 
@@ -187,7 +218,7 @@ inline std::string signed_number(std::string_view s) {
     return !(std::isalnum(static_cast<unsigned char>(c)) || c == '.');
   };
 
-  std::string output;
+  auto output = make_temp_string();
   auto begin = s.begin();
   decltype(begin) end;
   while ((end = std::find_if(begin, s.end(), is_operator)) != s.end()) {
@@ -209,17 +240,20 @@ inline std::string signed_number(std::string_view s) {
   return output;
 }
 
-inline std::string escaped_str(std::string_view s) {
+inline temp_string escaped_str(std::string_view s) {
   if (!use_es()) {
-    return std::string(s);
+    return make_temp_string(s);
   }
 
-  auto is_backslash = [](char c) { return c == '\\'; };
-
-  std::string output;
+  auto output = make_temp_string();
   auto begin = s.begin();
   decltype(begin) end;
-  while ((end = std::find_if(begin, s.end(), is_backslash)) != s.end()) {
+  // string_view::find() is memchr(), which is vectorized.
+  auto find_backslash = [&](decltype(begin) from) {
+    auto pos = s.find('\\', static_cast<std::size_t>(from - s.begin()));
+    return pos == std::string_view::npos ? s.end() : s.begin() + pos;
+  };
+  while ((end = find_backslash(begin)) != s.end()) {
     if (begin != end) {
       auto len_char1 = end - begin;
       output += es::character({&*begin, static_cast<std::size_t>(len_char1 >= 0 ? len_char1 : 0)});
@@ -251,6 +285,8 @@ inline std::string escaped_str(std::string_view s) {
 
 }  // namespace es
 
+}  // namespace _p_CPP_DUMP_ES_NAMESPACE
+
 }  // namespace _detail
 
 }  // namespace cpp_dump
@@ -7,35 +7,39 @@
 
 #pragma once
 
-#include <cstdio>
-#include <functional>
+#include <array>
+#include <cstddef>
+#include <cstdint>
 #include <limits>
-#include <memory>
+#include <new>
 #include <optional>
+#include <type_traits>
 #include <utility>
 #include <vector>
 
+#include "../arena.hpp"
 #include "../options.hpp"
 #include "../type_check.hpp"
+#include "./format_spec.hpp"
 #include "./skip_container.hpp"
 
 namespace cpp_dump {
 
 namespace _detail {
 
-const std::function<std::size_t(std::size_t, const std::function<std::size_t()> &)>
-    _default_skip_size_func(
-        [](std::size_t index, const std::function<std::size_t()> &) -> std::size_t {
-          if (index >= options::max_iteration_count) {
-            return std::numeric_limits<std::size_t>::max();
-          }
-          return 0;
-        }
-    );
+inline namespace _p_CPP_DUMP_ES_NAMESPACE {
+
+struct command_tree;
 
 template <typename T>
 struct value_with_command;
 
+/*
+ * The manipulators that apply to a value at a depth, which the exporters receive.
+ * This points to a node of the command_tree of the value and to the global props resolved for the
+ * node when the tree was built, so next() and the others only copy pointers and never modify the
+ * tree. A tree never changes after it is built, so the threads can share it.
+ */
 struct export_command {
  public:
   struct int_style_t {
@@ -53,12 +57,13 @@ struct export_command {
   struct global_props_t {
     std::optional<int_style_t> int_style;
     bool_style_t bool_style{bool_style_t::normal};
-    const char *format{nullptr};
+    std::optional<format_spec> format;
     std::size_t addr_depth{std::numeric_limits<std::size_t>::max()};
     bool escape_str{false};
     bool char_as_hex{false};
     bool show_index{false};
 
+    global_props_t() = default;
     explicit global_props_t(
         int base, int digits, int chunk, bool space_fill, bool make_unsigned_or_no_space_for_minus
     ) {
@@ -86,19 +91,20 @@ struct export_command {
       };
     }
     explicit global_props_t(bool_style_t bool_style_) : bool_style(bool_style_) {}
-    explicit global_props_t(const char *format_) : format(format_) {}
+    explicit global_props_t(const char *format_) {
+      if (format_ != nullptr) {
+        format.emplace(format_);
+      }
+    }
     explicit global_props_t(std::size_t addr_depth_) : addr_depth(addr_depth_) {}
     explicit global_props_t(stresc) : escape_str(true) {}
     explicit global_props_t(charhex) : char_as_hex(true) {}
     explicit global_props_t(index) : show_index(true) {}
 
-    global_props_t(global_props_t &&) = default;
-    global_props_t &operator=(global_props_t &&) = default;
-
     void update(const global_props_t &g) {
       if (g.int_style) int_style = g.int_style;
       if (g.bool_style != bool_style_t::normal) bool_style = g.bool_style;
-      if (g.format != nullptr) format = g.format;
+      if (g.format) format = g.format;
       if (g.escape_str) escape_str = g.escape_str;
       if (g.char_as_hex) char_as_hex = g.char_as_hex;
       if (g.show_index) show_index = g.show_index;
@@ -107,7 +113,7 @@ struct export_command {
     void merge(const global_props_t &g) {
       if (!int_style) int_style = g.int_style;
       if (bool_style == bool_style_t::normal) bool_style = g.bool_style;
-      if (format == nullptr) format = g.format;
+      if (!format) format = g.format;
       if (!escape_str) escape_str = g.escape_str;
       if (!char_as_hex) char_as_hex = g.char_as_hex;
       if (!show_index) show_index = g.show_index;
@@ -118,357 +124,454 @@ struct export_command {
 
   export_command() = default;
 
-  explicit export_command(
-      int base, int digits, int chunk, bool space_fill, bool make_unsigned_or_no_space_for_minus
-  )
-      : _global_props(std::make_shared<global_props_t>(
-          base, digits, chunk, space_fill, make_unsigned_or_no_space_for_minus
-      )) {}
+  explicit export_command(const command_tree &tree);
 
-  explicit export_command(const char *format_)
-      : _global_props(std::make_shared<global_props_t>(format_)) {}
+  export_command next() const;
 
-  explicit export_command(bool_style_t bool_style)
-      : _global_props(std::make_shared<global_props_t>(bool_style)) {}
+  export_command next_for_map_key() const;
 
-  explicit export_command(std::size_t addr_depth)
-      : _global_props(std::make_shared<global_props_t>(addr_depth)) {}
+  export_command next_for_map_value() const;
 
-  explicit export_command(stresc) : _global_props(std::make_shared<global_props_t>(stresc{})) {}
+  template <typename T>
+  skip_container<T> create_skip_container(const T &container) const;
 
-  explicit export_command(charhex) : _global_props(std::make_shared<global_props_t>(charhex{})) {}
+  std::optional<int_style_t> int_style() const { return _props->int_style; }
 
-  explicit export_command(index) : _global_props(std::make_shared<global_props_t>(index{})) {}
+  bool_style_t bool_style() const { return _props->bool_style; }
 
-  explicit export_command(const std::shared_ptr<global_props_t> &g) : _global_props(g) {}
+  template <typename T>
+  auto format(T value) const -> std::enable_if_t<is_arithmetic<T>, temp_string> {
+    if (!_props->format) {
+      return make_temp_string();
+    }
+    return _props->format->format(value);
+  }
 
-  explicit export_command(
-      std::function<std::size_t(std::size_t, const std::function<std::size_t()> &)> &&skip_size_func
-  )
-      : _skip_size_func(std::move(skip_size_func)) {}
+  std::size_t addr_depth() const { return _props->addr_depth; }
 
-  explicit export_command(
-      const std::function<std::size_t(std::size_t, const std::function<std::size_t()> &)>
-          &skip_size_func
-  )
-      : _skip_size_func(skip_size_func) {}
+  bool escape_str() const { return _props->escape_str; }
 
-  export_command(export_command &&) = default;
-  export_command &operator=(export_command &&) = default;
+  bool char_as_hex() const { return _props->char_as_hex; }
 
-  const export_command &next() const {
-    if (_child) {
-      if (_global_props && !_child->_global_props) {
-        _child->_global_props = _global_props;
-      }
-    } else {
-      if (!_global_props) {
-        return default_command;
-      }
-      _child = std::make_unique<export_command>(_global_props);
-    }
-    return *_child;
-  }
+  bool show_index() const { return _props->show_index; }
 
-  const export_command &next_for_map_key() const {
-    if (!(_skip_size_func && _map_key_child)) {
-      return next();
-    }
+  // The props of the commands without global props.
+  static const global_props_t no_props;
 
-    if (_global_props) {
-      if (_map_key_child->_global_props) {
-        _map_key_child->_global_props->merge(*_global_props);
-      } else {
-        _map_key_child->_global_props = _global_props;
-      }
-    }
+ private:
+  // nullptr for the commands without manipulators.
+  const command_tree *_tree = nullptr;
+  const global_props_t *_props = &no_props;
+  std::uint16_t _node = 0;
 
-    return *_map_key_child;
-  }
+  export_command _map_child(std::uint16_t node) const;
+};
 
-  const export_command &next_for_map_value() const {
-    if (!(_skip_size_func && _map_value_child)) {
-      return next();
-    }
+inline const export_command::global_props_t export_command::no_props{};
 
-    if (_global_props) {
-      if (_map_value_child->_global_props) {
-        _map_value_child->_global_props->merge(*_global_props);
-      } else {
-        _map_value_child->_global_props = _global_props;
-      }
-    }
+inline const export_command export_command::default_command{};
 
-    return *_map_value_child;
+/*
+ * A vector that holds its first N elements in place and the rest on the heap.
+ */
+template <typename T, std::size_t N>
+struct small_vector {
+ public:
+  small_vector() = default;
+  small_vector(const small_vector &other) { _copy(other); }
+  small_vector(small_vector &&other) noexcept { _move(std::move(other)); }
+  small_vector &operator=(const small_vector &other) {
+    if (this != &other) {
+      clear();
+      _copy(other);
+    }
+    return *this;
+  }
+  small_vector &operator=(small_vector &&other) noexcept {
+    if (this != &other) {
+      clear();
+      _move(std::move(other));
+    }
+    return *this;
   }
+  ~small_vector() { clear(); }
 
-  template <typename T>
-  skip_container<T> create_skip_container(const T &container) const {
-    if (_skip_size_func) {
-      return skip_container<T>(container, _skip_size_func);
+  std::size_t size() const { return _size; }
+
+  T &operator[](std::size_t i) { return i < N ? _slots[i].value : _overflow[i - N]; }
+  const T &operator[](std::size_t i) const { return i < N ? _slots[i].value : _overflow[i - N]; }
+
+  void push_back(const T &value) {
+    if (_size < N) {
+      new (&_slots[_size].value) T(value);
+    } else {
+      _overflow.push_back(value);
     }
-    return skip_container<T>(container, _default_skip_size_func);
+    ++_size;
   }
 
-  std::optional<int_style_t> int_style() const {
-    return _global_props ? _global_props->int_style : std::nullopt;
+  void clear() {
+    for (std::size_t i = 0; i < _size && i < N; ++i) _slots[i].value.~T();
+    _overflow.clear();
+    _size = 0;
   }
 
-  bool_style_t bool_style() const {
-    return _global_props ? _global_props->bool_style : bool_style_t::normal;
+ private:
+  // The slots beyond the size are left uninitialized.
+  union slot {
+    slot() {}
+    ~slot() {}
+    T value;
+  };
+
+  std::array<slot, N> _slots;
+  std::size_t _size = 0;
+  std::vector<T> _overflow;
+
+  void _copy(const small_vector &other) {
+    for (std::size_t i = 0; i < other._size; ++i) push_back(other[i]);
   }
 
-  template <typename T>
-  auto format(T value) const -> std::enable_if_t<is_arithmetic<T>, std::string> {
-    if (!_global_props || _global_props->format == nullptr) {
-      return "";
-    }
-    int length = std::snprintf(nullptr, 0, _global_props->format, value);
-    if (length < 0) {
-      return "";
+  // The elements beyond N are moved with the heap buffer.
+  void _move(small_vector &&other) noexcept {
+    for (std::size_t i = 0; i < other._size && i < N; ++i) {
+      new (&_slots[i].value) T(std::move(other._slots[i].value));
     }
-    std::vector<char> buffer(length + 1);
-    std::snprintf(buffer.data(), buffer.size(), _global_props->format, value);
-    return {buffer.data(), static_cast<std::size_t>(length >= 0 ? length : 0)};
+    _overflow = std::move(other._overflow);
+    _size = other._size;
+    other.clear();
   }
+};
+
+/*
+ * The manipulators composed by | and <<.
+ * A node has the skip policy for a depth, the child for the next depth, and the children for map
+ * keys and values. The root and the map key/value children can also have global props.
+ * The first max_nodes nodes and max_props props are held in place, so composing the usual
+ * manipulators never allocates. Larger trees keep the rest on the heap.
+ * Composing returns a new tree, and the props that apply at each node are resolved when the tree
+ * is built, so a tree is never modified once built.
+ * The operators take the left tree by value and move it through a chain such as
+ * cp::front() | cp::hex(), so a chain builds one tree instead of copying it at each step.
+ */
+struct command_tree {
+ public:
+  using global_props_t = export_command::global_props_t;
+
+  using index_t = std::uint16_t;
+
+  static constexpr index_t npos = 0xffff;
+  static constexpr std::size_t max_nodes = 16;
+  static constexpr std::size_t max_props = 4;
+
+  struct node {
+    skip_policy skip;
+    index_t child = npos;
+    index_t map_key_child = npos;
+    index_t map_value_child = npos;
+    index_t props = npos;
+    // The props that apply at this node, or npos for export_command::no_props.
+    index_t resolved_props = npos;
+  };
+
+  command_tree() { _add_node(skip_policy{}); }
 
-  std::size_t addr_depth() const {
-    return _global_props ? _global_props->addr_depth : std::numeric_limits<std::size_t>::max();
+  explicit command_tree(const global_props_t &g) : command_tree() {
+    _node(0).props = _add_props(g);
+    _resolve_props();
   }
 
-  bool escape_str() const { return _global_props && _global_props->escape_str; }
+  explicit command_tree(
+      int base, int digits, int chunk, bool space_fill, bool make_unsigned_or_no_space_for_minus
+  )
+      : command_tree(
+          global_props_t(base, digits, chunk, space_fill, make_unsigned_or_no_space_for_minus)
+      ) {}
 
-  bool char_as_hex() const { return _global_props && _global_props->char_as_hex; }
+  explicit command_tree(const char *format_) : command_tree(global_props_t(format_)) {}
 
-  bool show_index() const { return _global_props && _global_props->show_index; }
+  explicit command_tree(export_command::bool_style_t bool_style)
+      : command_tree(global_props_t(bool_style)) {}
 
-  // The below is for supporting lvalue of export_command -----------------------------------------
+  explicit command_tree(std::size_t addr_depth) : command_tree(global_props_t(addr_depth)) {}
 
-  export_command(const export_command &c)
-      : _global_props(c._global_props), _skip_size_func(c._skip_size_func) {
-    if (c._child) {
-      _child = std::make_unique<export_command>(*c._child);
-    }
-    if (c._map_key_child) {
-      _map_key_child = std::make_unique<export_command>(*c._map_key_child);
-    }
-    if (c._map_value_child) {
-      _map_value_child = std::make_unique<export_command>(*c._map_value_child);
-    }
+  explicit command_tree(export_command::stresc tag) : command_tree(global_props_t(tag)) {}
+
+  explicit command_tree(export_command::charhex tag) : command_tree(global_props_t(tag)) {}
+
+  explicit command_tree(export_command::index tag) : command_tree(global_props_t(tag)) {}
+
+  explicit command_tree(const skip_policy &skip) : command_tree() { _node(0).skip = skip; }
+
+  const node &get_node(index_t i) const { return _node(i); }
+
+  const global_props_t &get_resolved_props(index_t i) const {
+    auto resolved = _node(i).resolved_props;
+    return resolved == npos ? export_command::no_props : _resolved(resolved);
   }
 
-  export_command &operator=(const export_command &c) {
-    _global_props = c._global_props;
-    _skip_size_func = c._skip_size_func;
-    if (c._child) {
-      _child = std::make_unique<export_command>(*c._child);
-    }
-    if (c._map_key_child) {
-      _child = std::make_unique<export_command>(*c._map_key_child);
+  friend command_tree operator<<(command_tree lhs, const command_tree &rhs);
+  friend command_tree operator|(command_tree lhs, const command_tree &rhs);
+  friend command_tree _map_k(const command_tree &command);
+  friend command_tree _map_v(const command_tree &command);
+  friend command_tree _map_kv(const command_tree &key, const command_tree &value);
+  template <typename T>
+  friend value_with_command<T> operator|(value_with_command<T> &&vc, const command_tree &command);
+
+ private:
+  small_vector<node, max_nodes> _nodes;
+  small_vector<global_props_t, max_props> _props;
+  // Only the nodes with props have their own resolved props.
+  small_vector<global_props_t, max_props> _resolved_props;
+
+  node &_node(index_t i) { return _nodes[i]; }
+  const node &_node(index_t i) const { return _nodes[i]; }
+  global_props_t &_global_props(index_t i) { return _props[i]; }
+  const global_props_t &_global_props(index_t i) const { return _props[i]; }
+  const global_props_t &_resolved(index_t i) const { return _resolved_props[i]; }
+
+  index_t _add_node(const skip_policy &skip) {
+    _nodes.push_back(node{skip});
+    return static_cast<index_t>(_nodes.size() - 1);
+  }
+
+  index_t _add_props(const global_props_t &g) {
+    _props.push_back(g);
+    return static_cast<index_t>(_props.size() - 1);
+  }
+
+  // Copy the node i of the command and its descendants, and return the index of the copy.
+  index_t _copy_subtree(const command_tree &command, index_t i, bool with_props) {
+    if (i == npos) {
+      return npos;
     }
-    if (c._map_value_child) {
-      _child = std::make_unique<export_command>(*c._map_value_child);
+    // The nodes may move while the subtree is copied, so this copies the source node.
+    const node src = command._node(i);
+    auto dest = _add_node(src.skip);
+    if (with_props && src.props != npos) {
+      auto props = _add_props(command._global_props(src.props));
+      _node(dest).props = props;
     }
-    return *this;
+    auto child = _copy_subtree(command, src.child, false);
+    _node(dest).child = child;
+    auto map_key_child = _copy_subtree(command, src.map_key_child, true);
+    _node(dest).map_key_child = map_key_child;
+    auto map_value_child = _copy_subtree(command, src.map_value_child, true);
+    _node(dest).map_value_child = map_value_child;
+    return dest;
   }
 
-  // The above is for supporting lvalue of export_command -----------------------------------------
+  void _update_and_append(const command_tree &command) {
+    _update_global_props(command);
+    _append_child(0, command);
+    _resolve_props();
+  }
 
-  friend export_command operator<<(export_command &&, export_command &&);
-  friend export_command operator<<(export_command &&, const export_command &);
-  friend export_command operator<<(const export_command &, export_command &&);
-  friend export_command operator<<(const export_command &, const export_command &);
-  friend export_command _map_k(export_command &&command);
-  friend export_command _map_v(export_command &&command);
-  friend export_command _map_kv(export_command &&key, export_command &&value);
+  void _update_global_props(const command_tree &command) {
+    auto props = command._node(0).props;
+    if (props != npos) {
+      const auto &g = command._global_props(props);
+      if (_node(0).props != npos) {
+        _global_props(_node(0).props).update(g);
+      } else {
+        auto new_props = _add_props(g);
+        _node(0).props = new_props;
+      }
+    }
+  }
 
- private:
-  std::shared_ptr<global_props_t> _global_props;
-  std::function<std::size_t(std::size_t, const std::function<std::size_t()> &)> _skip_size_func;
-
-  // if export_command is used as rvalue, unique_ptr is enough.
-  // Also, using shared_ptr might cause circular reference.
-  mutable std::unique_ptr<export_command> _child;
-  std::unique_ptr<export_command> _map_key_child;
-  std::unique_ptr<export_command> _map_value_child;
-
-  void update_and_append(export_command &&command) {
-    update_global_props(std::move(command._global_props));
-    append_child(std::move(command));
+  // The root uses its props, the child for the next depth uses the props of its parent, and the
+  // children for map keys and values use their props merged with the props of their parent.
+  void _resolve_props() {
+    _resolved_props.clear();
+    _resolve_props(0, npos, true);
   }
 
-  void update_global_props(std::shared_ptr<global_props_t> &&g) {
-    if (g) {
-      if (_global_props) {
-        _global_props->update(*g);
-        g.reset();
-      } else {
-        _global_props.swap(g);
+  void _resolve_props(index_t i, index_t inherited, bool has_own_props) {
+    if (i == npos) {
+      return;
+    }
+    node &n = _node(i);
+    n.resolved_props = inherited;
+    if (has_own_props && n.props != npos) {
+      auto g = _global_props(n.props);
+      if (inherited != npos) {
+        g.merge(_resolved(inherited));
       }
+      _resolved_props.push_back(g);
+      n.resolved_props = static_cast<index_t>(_resolved_props.size() - 1);
     }
-    // Here, g == nullptr
+    _resolve_props(n.child, n.resolved_props, false);
+    _resolve_props(n.map_key_child, n.resolved_props, true);
+    _resolve_props(n.map_value_child, n.resolved_props, true);
   }
 
-  void append_child(export_command &&command) {
-    // export_command has (either skip_size_func or {map_key_child || map_value_child})( || g).
+  void _append_child(index_t i, const command_tree &command) {
+    // command has (either skip or {map_key_child || map_value_child})( || props).
+    const node &root = command._node(0);
 
-    // in the case of skip_size_func
-    if (command._skip_size_func) {
-      if (_skip_size_func) {
+    // in the case of skip
+    if (root.skip) {
+      if (_node(i).skip) {
         // append
-        if (_child) {
-          _child->append_child(std::move(command));
+        if (_node(i).child != npos) {
+          _append_child(_node(i).child, command);
         } else {
-          _child = std::make_unique<export_command>(std::move(command));
+          _node(i).child = _copy_subtree(command, 0, false);
         }
         return;
       }
 
       // update this node
-      _skip_size_func = std::move(command._skip_size_func);
-      if (command._map_key_child) _map_key_child = std::move(command._map_key_child);
-      if (command._map_value_child) _map_value_child = std::move(command._map_value_child);
+      _node(i).skip = root.skip;
+      if (root.map_key_child != npos) {
+        _node(i).map_key_child = _copy_subtree(command, root.map_key_child, true);
+      }
+      if (root.map_value_child != npos) {
+        _node(i).map_value_child = _copy_subtree(command, root.map_value_child, true);
+      }
       return;
     }
 
-    if (!(command._map_key_child || command._map_value_child)) {
+    if (root.map_key_child == npos && root.map_value_child == npos) {
       return;
     }
 
     // in the case of {map_key_child || map_value_child}
-    // jump to the node whose child has no skip_size_func.
-    if (_child && _child->_skip_size_func) {
-      _child->append_child(std::move(command));
+    // jump to the node whose child has no skip.
+    if (_node(i).child != npos && _node(_node(i).child).skip) {
+      _append_child(_node(i).child, command);
       return;
     }
 
-    if (command._map_key_child) {
-      _map_key_child = std::move(command._map_key_child);
+    if (root.map_key_child != npos) {
+      _node(i).map_key_child = _copy_subtree(command, root.map_key_child, true);
     }
-    if (command._map_value_child) {
-      _map_value_child = std::move(command._map_value_child);
+    if (root.map_value_child != npos) {
+      _node(i).map_value_child = _copy_subtree(command, root.map_value_child, true);
     }
   }
 };
 
-inline const export_command export_command::default_command(_default_skip_size_func);
-
-template <typename T>
-struct value_with_command {
- public:
-  const T &value;
-  const export_command command;
-
-  explicit value_with_command(const T &v, export_command &&c) : value(v), command(std::move(c)) {}
-  value_with_command() = delete;
-};
-
-inline export_command operator<<(export_command &&lhs, export_command &&rhs) {
-  lhs.update_and_append(std::move(rhs));
-  return std::move(lhs);
-}
-
-template <typename T>
-inline value_with_command<T> operator<<(export_command &&command, const T &value) {
-  return value_with_command<T>(value, std::move(command));
-}
-
-// The below is for supporting lvalue of export_command -------------------------------------------
-
-inline export_command operator<<(export_command &&lhs, const export_command &rhs) {
-  lhs.update_and_append(export_command(rhs));
-  return std::move(lhs);
-}
-
-inline export_command operator<<(const export_command &lhs, export_command &&rhs) {
-  export_command retval(lhs);
-  retval.update_and_append(std::move(rhs));
-  return retval;
-}
-
-inline export_command operator<<(const export_command &lhs, const export_command &rhs) {
-  export_command retval(lhs);
-  retval.update_and_append(export_command(rhs));
-  return retval;
+inline export_command::export_command(const command_tree &tree)
+    : _tree(&tree), _props(&tree.get_resolved_props(0)) {}
+
+inline export_command export_command::next() const {
+  // The child for the next depth has the same props.
+  export_command next_command;
+  next_command._props = _props;
+  if (_tree) {
+    auto child = _tree->get_node(_node).child;
+    if (child != command_tree::npos) {
+      next_command._tree = _tree;
+      next_command._node = child;
+    }
+  }
+  return next_command;
 }
 
-template <typename T>
-inline value_with_command<T> operator<<(const export_command &command, const T &value) {
-  return value_with_command<T>(value, export_command(command));
+inline export_command export_command::next_for_map_key() const {
+  if (!_tree) {
+    return next();
+  }
+  const auto &node = _tree->get_node(_node);
+  if (!(node.skip && node.map_key_child != command_tree::npos)) {
+    return next();
+  }
+  return _map_child(node.map_key_child);
 }
 
-// The above is for supporting lvalue of export_command -------------------------------------------
-
-inline export_command operator|(export_command &&lhs, export_command &&rhs) {
-  return std::move(lhs) << std::move(rhs);
+inline export_command export_command::next_for_map_value() const {
+  if (!_tree) {
+    return next();
+  }
+  const auto &node = _tree->get_node(_node);
+  if (!(node.skip && node.map_value_child != command_tree::npos)) {
+    return next();
+  }
+  return _map_child(node.map_value_child);
 }
 
-template <typename T>
-inline value_with_command<T> operator|(const T &value, export_command &&command) {
-  return value_with_command<T>(value, std::move(command));
+inline export_command export_command::_map_child(std::uint16_t node) const {
+  export_command child;
+  child._tree = _tree;
+  child._props = &_tree->get_resolved_props(node);
+  child._node = node;
+  return child;
 }
 
 template <typename T>
-inline value_with_command<T> operator|(value_with_command<T> &&vc, export_command &&command) {
-  return value_with_command<T>(
-      vc.value, const_cast<export_command &&>(vc.command) << std::move(command)
+inline skip_container<T> export_command::create_skip_container(const T &container) const {
+  if (_tree && _tree->get_node(_node).skip) {
+    return skip_container<T>(container, _tree->get_node(_node).skip);
+  }
+  return skip_container<T>(
+      container, skip_policy{skip_policy::kind_t::front, current_options().max_iteration_count}
   );
 }
 
-// The below is for supporting lvalue of export_command -------------------------------------------
-
-inline export_command operator|(const export_command &lhs, export_command &&rhs) {
-  return lhs << std::move(rhs);
-}
+template <typename T>
+struct value_with_command {
+ public:
+  const T &value;
+  command_tree command;
 
-inline export_command operator|(export_command &&lhs, const export_command &rhs) {
-  return std::move(lhs) << rhs;
-}
+  explicit value_with_command(const T &v, command_tree c) : value(v), command(std::move(c)) {}
+  value_with_command() = delete;
+};
 
-inline export_command operator|(const export_command &lhs, const export_command &rhs) {
-  return lhs << rhs;
+inline command_tree operator<<(command_tree lhs, const command_tree &rhs) {
+  lhs._update_and_append(rhs);
+  return lhs;
 }
 
 template <typename T>
-inline value_with_command<T> operator|(const T &value, const export_command &command) {
-  return value_with_command<T>(value, export_command(command));
+inline value_with_command<T> operator<<(command_tree command, const T &value) {
+  return value_with_command<T>(value, std::move(command));
 }
 
-template <typename T>
-inline value_with_command<T> operator|(value_with_command<T> &&vc, const export_command &command) {
-  return value_with_command<T>(vc.value, const_cast<export_command &&>(vc.command) << command);
+inline command_tree operator|(command_tree lhs, const command_tree &rhs) {
+  lhs._update_and_append(rhs);
+  return lhs;
 }
 
 template <typename T>
-inline value_with_command<T> operator|(const value_with_command<T> &vc, export_command &&command) {
-  return value_with_command<T>(vc.value, vc.command << std::move(command));
+inline value_with_command<T> operator|(const T &value, command_tree command) {
+  return value_with_command<T>(value, std::move(command));
 }
 
 template <typename T>
 inline value_with_command<T> operator|(
-    const value_with_command<T> &vc, const export_command &command
+    const value_with_command<T> &vc, const command_tree &command
 ) {
   return value_with_command<T>(vc.value, vc.command << command);
 }
 
-// The above is for supporting lvalue of export_command -------------------------------------------
+template <typename T>
+inline value_with_command<T> operator|(value_with_command<T> &&vc, const command_tree &command) {
+  vc.command._update_and_append(command);
+  return value_with_command<T>(vc.value, std::move(vc.command));
+}
 
-inline export_command _map_k(export_command &&c) {
-  export_command new_command;
-  new_command._map_key_child = std::make_unique<export_command>(std::move(c));
+inline command_tree _map_k(const command_tree &command) {
+  command_tree new_command;
+  new_command._node(0).map_key_child = new_command._copy_subtree(command, 0, true);
+  new_command._resolve_props();
   return new_command;
 }
 
-inline export_command _map_v(export_command &&c) {
-  export_command new_command;
-  new_command._map_value_child = std::make_unique<export_command>(std::move(c));
+inline command_tree _map_v(const command_tree &command) {
+  command_tree new_command;
+  new_command._node(0).map_value_child = new_command._copy_subtree(command, 0, true);
+  new_command._resolve_props();
   return new_command;
 }
 
-inline export_command _map_kv(export_command &&key, export_command &&value) {
-  export_command new_command;
-  new_command._map_key_child = std::make_unique<export_command>(std::move(key));
-  new_command._map_value_child = std::make_unique<export_command>(std::move(value));
+inline command_tree _map_kv(const command_tree &key, const command_tree &value) {
+  command_tree new_command;
+  new_command._node(0).map_key_child = new_command._copy_subtree(key, 0, true);
+  new_command._node(0).map_value_child = new_command._copy_subtree(value, 0, true);
+  new_command._resolve_props();
   return new_command;
 }
 
@@ -480,8 +583,12 @@ inline constexpr bool _is_value_with_command<value_with_command<T>> = true;
 template <typename T>
 inline constexpr bool is_value_with_command = _is_value_with_command<remove_cvref<T>>;
 
+}  // namespace _p_CPP_DUMP_ES_NAMESPACE
+
 }  // namespace _detail
 
+inline namespace _p_CPP_DUMP_ES_NAMESPACE {
+
 /**
  * Manipulator for the display style of integers.
  * See README for details.
@@ -493,7 +600,7 @@ inline auto int_style(
     bool space_fill = false,
     bool make_unsigned_or_no_space_for_minus = false
 ) {
-  return _detail::export_command(
+  return _detail::command_tree(
       base, digits, chunk, space_fill, make_unsigned_or_no_space_for_minus
   );
 }
@@ -566,7 +673,7 @@ inline auto uhex(int digits = -1, int chunk = 0, bool space_fill = false) {
  * Manipulator for the display style of numbers.
  * See README for details.
  */
-inline auto format(const char *f) { return _detail::export_command(f); }
+inline auto format(const char *f) { return _detail::command_tree(f); }
 
 /**
  * Manipulator for the display style of bool.
@@ -574,7 +681,7 @@ inline auto format(const char *f) { return _detail::export_command(f); }
  */
 inline auto bw(bool left = false) {
   using bool_style_t = _detail::export_command::bool_style_t;
-  return _detail::export_command(left ? bool_style_t::true_left : bool_style_t::true_right);
+  return _detail::command_tree(left ? bool_style_t::true_left : bool_style_t::true_right);
 }
 
 /**
@@ -583,125 +690,91 @@ inline auto bw(bool left = false) {
  */
 inline auto boolnum() {
   using bool_style_t = _detail::export_command::bool_style_t;
-  return _detail::export_command(bool_style_t::number);
+  return _detail::command_tree(bool_style_t::number);
 }
 
 /**
  * Manipulator for the display style of char.
  * See README for details.
  */
-inline auto stresc() { return _detail::export_command(_detail::export_command::stresc{}); }
+inline auto stresc() { return _detail::command_tree(_detail::export_command::stresc{}); }
 
 /**
  * Manipulator for the display style of char.
  * See README for details.
  */
-inline auto charhex() { return _detail::export_command(_detail::export_command::charhex{}); }
+inline auto charhex() { return _detail::command_tree(_detail::export_command::charhex{}); }
 
 /**
  * Manipulator for the display style of pointers.
  * See README for details.
  */
-inline auto addr(std::size_t depth = 0) { return _detail::export_command(depth); }
+inline auto addr(std::size_t depth = 0) { return _detail::command_tree(depth); }
 
 /**
  * Manipulator for the display style of containers.
  * See README for details.
  */
-inline auto index() { return _detail::export_command(_detail::export_command::index{}); }
+inline auto index() { return _detail::command_tree(_detail::export_command::index{}); }
 
 /**
  * Manipulator for the display style of iterables.
  * See README for details.
  */
-inline auto front(std::size_t iteration_count = options::max_iteration_count) {
-  return _detail::export_command(
-      [=](std::size_t index, const std::function<std::size_t()> &) -> std::size_t {
-        if (index >= iteration_count) {
-          return std::numeric_limits<std::size_t>::max();  // skip to the end
-        }
-        return 0;  // increment normally
-      }
-  );
+inline auto front(std::size_t iteration_count = _detail::current_options().max_iteration_count) {
+  using kind_t = _detail::skip_policy::kind_t;
+  return _detail::command_tree(_detail::skip_policy{kind_t::front, iteration_count});
 }
 
 /**
  * Manipulator for the display style of iterables.
  * See README for details.
  */
-inline auto back(std::size_t iteration_count = options::max_iteration_count) {
-  return _detail::export_command(
-      [=](std::size_t index, const std::function<std::size_t()> &cont_size) -> std::size_t {
-        std::size_t size = cont_size();
-        std::size_t first = size >= iteration_count ? size - iteration_count : 0;
-
-        if (index < first) {
-          return first - index;  // skip to the first
-        }
-        return 0;  // increment normally
-      }
-  );
+inline auto back(std::size_t iteration_count = _detail::current_options().max_iteration_count) {
+  using kind_t = _detail::skip_policy::kind_t;
+  return _detail::command_tree(_detail::skip_policy{kind_t::back, iteration_count});
 }
 
 /**
  * Manipulator for the display style of iterables.
  * See README for details.
  */
-inline auto both_ends(std::size_t half_iteration_count = options::max_iteration_count / 2) {
-  return _detail::export_command(
-      [=](std::size_t index, const std::function<std::size_t()> &cont_size) -> std::size_t {
-        std::size_t size = cont_size();
-        std::size_t latter_half_first =
-            size >= half_iteration_count ? size - half_iteration_count : 0;
-
-        if (index >= half_iteration_count && index < latter_half_first) {
-          return latter_half_first - index;  // skip to the latter_half_first
-        }
-        return 0;  // increment normally
-      }
-  );
+inline auto both_ends(
+    std::size_t half_iteration_count = _detail::current_options().max_iteration_count / 2
+) {
+  using kind_t = _detail::skip_policy::kind_t;
+  return _detail::command_tree(_detail::skip_policy{kind_t::both_ends, half_iteration_count});
 }
 
 /**
  * Manipulator for the display style of iterables.
  * See README for details.
  */
-inline auto middle(std::size_t iteration_count = options::max_iteration_count) {
-  return _detail::export_command(
-      [=](std::size_t index, const std::function<std::size_t()> &cont_size) -> std::size_t {
-        std::size_t size = cont_size();
-        std::size_t first = size >= iteration_count ? (size - iteration_count) / 2 : 0;
-        std::size_t last = first + iteration_count;
-
-        if (index < first) {
-          return first - index;  // skip to the first
-        }
-        if (index >= last) {
-          return std::numeric_limits<std::size_t>::max();  // skip to the end
-        }
-        return 0;  // increment normally
-      }
-  );
+inline auto middle(std::size_t iteration_count = _detail::current_options().max_iteration_count) {
+  using kind_t = _detail::skip_policy::kind_t;
+  return _detail::command_tree(_detail::skip_policy{kind_t::middle, iteration_count});
 }
 
 /**
  * Manipulator for applying manipulators to map keys.
  * See README for details.
  */
-inline auto map_k(_detail::export_command &&c) { return _detail::_map_k(std::move(c)); }
+inline auto map_k(const _detail::command_tree &c) { return _detail::_map_k(c); }
 
 /**
  * Manipulator for applying manipulators to map values.
  * See README for details.
  */
-inline auto map_v(_detail::export_command &&c) { return _detail::_map_v(std::move(c)); }
+inline auto map_v(const _detail::command_tree &c) { return _detail::_map_v(c); }
 
 /**
  * Manipulator for applying manipulators to map keys and values.
  * See README for details.
  */
-inline auto map_kv(_detail::export_command &&k, _detail::export_command &&v) {
-  return _detail::_map_kv(std::move(k), std::move(v));
+inline auto map_kv(const _detail::command_tree &k, const _detail::command_tree &v) {
+  return _detail::_map_kv(k, v);
 }
 
+}  // namespace _p_CPP_DUMP_ES_NAMESPACE
+
 }  // namespace cpp_dump
@@ -0,0 +1,313 @@
+/*
+ * Copyright (c) 2023 Ryota Sasaki.
+ *
+ * This source code is licensed under the MIT license found in the LICENSE file in the root
+ * directory of this source tree.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+#include "../arena.hpp"
+
+namespace cpp_dump {
+
+namespace _detail {
+
+/*
+ * The format string of cpp_dump::format(), parsed once when the manipulator is created.
+ * A format string that has one d, i, u, o, x, X, f, F, e, or E conversion with flags (except #),
+ * a width, a precision, and a length modifier is rendered by std::to_chars() into a stack buffer.
+ * Any other format string, or a length modifier that does not match the type of the value, is
+ * passed to snprintf() as before.
+ */
+struct format_spec {
+ public:
+  explicit format_spec(const char *source) : _source(source) { _compiled = _parse(); }
+
+  const char *source() const { return _source; }
+
+  // Whether the format string is rendered without snprintf() (for the matching types).
+  bool compiled() const { return _compiled; }
+
+  template <typename T>
+  temp_string format(T value) const {
+    if (_compiled) {
+      if constexpr (std::is_integral_v<T>) {
+        if (_is_integer_conversion()) {
+          return _format_integer(value);
+        }
+      } else if constexpr (std::is_floating_point_v<T>) {
+        if (!_is_integer_conversion()) {
+          return _format_floating(value);
+        }
+      }
+    }
+    return _snprintf(value);
+  }
+
+ private:
+  enum class length_t { none, hh, h, l, ll, j, z, t, L };
+
+  const char *_source;
+  bool _compiled = false;
+  std::string_view _prefix;
+  std::string_view _suffix;
+  bool _left = false;
+  bool _plus = false;
+  bool _space = false;
+  bool _zero = false;
+  std::size_t _width = 0;
+  int _precision = -1;
+  length_t _length = length_t::none;
+  char _conversion = '\0';
+
+  // The widths above this are passed to snprintf().
+  static constexpr std::size_t _max_width = 4096;
+  // The fixed notation of a double with a large precision does not fit in the stack buffer, and
+  // is passed to snprintf().
+  static constexpr std::size_t _buffer_size = 512;
+
+  bool _parse() {
+    if (_source == nullptr) {
+      return false;
+    }
+    std::string_view s(_source);
+    auto percent = s.find('%');
+    if (percent == std::string_view::npos) {
+      return false;
+    }
+    _prefix = s.substr(0, percent);
+
+    std::size_t pos = percent + 1;
+    auto peek = [&] { return pos < s.size() ? s[pos] : '\0'; };
+    auto read_number = [&]() -> std::size_t {
+      std::size_t number = 0;
+      while (std::isdigit(static_cast<unsigned char>(peek())) && number <= _max_width) {
+        number = number * 10 + static_cast<std::size_t>(s[pos++] - '0');
+      }
+      return number;
+    };
+
+    for (;; ++pos) {
+      char c = peek();
+      if (c == '-') {
+        _left = true;
+      } else if (c == '+') {
+        _plus = true;
+      } else if (c == ' ') {
+        _space = true;
+      } else if (c == '0') {
+        _zero = true;
+      } else {
+        break;
+      }
+    }
+    _width = read_number();
+    if (peek() == '.') {
+      ++pos;
+      _precision = static_cast<int>(std::min(read_number(), _max_width + 1));
+    }
+    if (_width > _max_width || _precision > static_cast<int>(_max_width)) {
+      return false;
+    }
+
+    constexpr std::pair<std::string_view, length_t> length_modifiers[] = {
+        {"hh", length_t::hh},
+        {"ll", length_t::ll},
+        {"h", length_t::h},
+        {"l", length_t::l},
+        {"j", length_t::j},
+        {"z", length_t::z},
+        {"t", length_t::t},
+        {"L", length_t::L},
+    };
+    for (auto [modifier, length] : length_modifiers) {
+      if (s.substr(pos, modifier.size()) == modifier) {
+        _length = length;
+        pos += modifier.size();
+        break;
+      }
+    }
+
+    // '#', '*', the other conversions, and a second conversion (including %%) reach here.
+    _conversion = peek();
+    if (std::string_view("diuoxXfFeE").find(_conversion) == std::string_view::npos
+        || _conversion == '\0') {
+      return false;
+    }
+    _suffix = s.substr(pos + 1);
+    return _suffix.find('%') == std::string_view::npos;
+  }
+
+  bool _is_integer_conversion() const {
+    return std::string_view("diuoxX").find(_conversion) != std::string_view::npos;
+  }
+
+  // Pad the sign and the body as printf() does.
+  temp_string
+  _pad(std::string_view sign, std::size_t zeros, std::string_view body, bool zero_pad) const {
+    std::size_t length = sign.size() + zeros + body.size();
+    std::size_t fill = _width > length ? _width - length : 0;
+    auto output = make_temp_string();
+    output.reserve(_prefix.size() + length + fill + _suffix.size());
+    output.append(_prefix);
+    if (!_left && !zero_pad) {
+      output.append(fill, ' ');
+    }
+    output.append(sign);
+    if (!_left && zero_pad) {
+      output.append(fill, '0');
+    }
+    output.append(zeros, '0');
+    output.append(body);
+    if (_left) {
+      output.append(fill, ' ');
+    }
+    output.append(_suffix);
+    return output;
+  }
+
+  // helper for _format_integer()
+  // Convert the value as printf() converts the argument for the length modifier.
+  template <typename SignedT, typename T>
+  temp_string _format_integer_as(T value) const {
+    // printf() reads the promoted argument, so the sizes must match.
+    if constexpr (sizeof(decltype(+value)) != sizeof(decltype(+std::declval<SignedT>()))) {
+      return _snprintf(value);
+    } else {
+      using UnsignedT = std::make_unsigned_t<SignedT>;
+      const bool is_signed = _conversion == 'd' || _conversion == 'i';
+      const auto converted = static_cast<SignedT>(value);
+      const bool negative = is_signed && converted < 0;
+      // Negate in UnsignedT so that the minimum value does not overflow.
+      const auto abs = static_cast<UnsignedT>(
+          negative ? UnsignedT{0} - static_cast<UnsignedT>(converted)
+                   : static_cast<UnsignedT>(converted)
+      );
+
+      char buffer[sizeof(UnsignedT) * 8];
+      char *last = buffer;
+      // The precision is the minimum number of digits, and zero with a precision of 0 has none.
+      if (!(_precision == 0 && abs == 0)) {
+        int base = _conversion == 'o' ? 8 : _conversion == 'x' || _conversion == 'X' ? 16 : 10;
+        last = std::to_chars(buffer, buffer + sizeof(buffer), abs, base).ptr;
+      }
+      if (_conversion == 'X') {
+        std::transform(buffer, last, buffer, [](char c) {
+          return static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
+        });
+      }
+      std::string_view digits(buffer, static_cast<std::size_t>(last - buffer));
+
+      std::string_view sign = "";
+      if (negative) {
+        sign = "-";
+      } else if (is_signed && _plus) {
+        sign = "+";
+      } else if (is_signed && _space) {
+        sign = " ";
+      }
+      std::size_t zeros = _precision > static_cast<int>(digits.size())
+                              ? static_cast<std::size_t>(_precision) - digits.size()
+                              : 0;
+      return _pad(sign, zeros, digits, _zero && _precision < 0);
+    }
+  }
+
+  template <typename T>
+  temp_string _format_integer(T value) const {
+    switch (_length) {
+      case length_t::none:
+        return _format_integer_as<int>(value);
+      case length_t::hh:
+        return _format_integer_as<signed char>(value);
+      case length_t::h:
+        return _format_integer_as<short>(value);
+      case length_t::l:
+        return _format_integer_as<long>(value);
+      case length_t::ll:
+        return _format_integer_as<long long>(value);
+      case length_t::j:
+        return _format_integer_as<std::intmax_t>(value);
+      case length_t::z:
+        return _format_integer_as<std::make_signed_t<std::size_t>>(value);
+      case length_t::t:
+        return _format_integer_as<std::ptrdiff_t>(value);
+      default:
+        return _snprintf(value);
+    }
+  }
+
+  template <typename T>
+  temp_string _format_floating(T value) const {
+    // printf() reads a double for no length modifier (and l), and a long double for L.
+    const bool is_long_double = std::is_same_v<T, long double>;
+    if (is_long_double != (_length == length_t::L)
+        || !(_length == length_t::none || _length == length_t::l || _length == length_t::L)) {
+      return _snprintf(value);
+    }
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+    using FloatT = std::conditional_t<std::is_same_v<T, long double>, long double, double>;
+    char buffer[_buffer_size];
+    auto format = _conversion == 'f' || _conversion == 'F' ? std::chars_format::fixed
+                                                           : std::chars_format::scientific;
+    auto result = std::to_chars(
+        buffer,
+        buffer + sizeof(buffer),
+        static_cast<FloatT>(value),
+        format,
+        _precision < 0 ? 6 : _precision
+    );
+    if (result.ec != std::errc()) {
+      return _snprintf(value);
+    }
+    if (_conversion == 'F' || _conversion == 'E') {
+      std::transform(buffer, result.ptr, buffer, [](char c) {
+        return static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
+      });
+    }
+    std::string_view body(buffer, static_cast<std::size_t>(result.ptr - buffer));
+
+    std::string_view sign = _plus ? "+" : _space ? " " : "";
+    if (body.front() == '-') {
+      sign = "-";
+      body.remove_prefix(1);
+    }
+    // printf() pads inf and nan with spaces even with the 0 flag.
+    return _pad(sign, 0, body, _zero && std::isfinite(value));
+#else
+    return _snprintf(value);
+#endif
+  }
+
+  template <typename T>
+  temp_string _snprintf(T value) const {
+    // Most outputs fit in the stack buffer, so snprintf() usually runs once.
+    char buffer[128];
+    int length = std::snprintf(buffer, sizeof(buffer), _source, value);
+    if (length < 0) {
+      return make_temp_string();
+    }
+    if (static_cast<std::size_t>(length) < sizeof(buffer)) {
+      return make_temp_string({buffer, static_cast<std::size_t>(length)});
+    }
+    auto output = make_temp_string(static_cast<std::size_t>(length), '\0');
+    std::snprintf(output.data(), output.size() + 1, _source, value);
+    return output;
+  }
+};
+
+}  // namespace _detail
+
+}  // namespace cpp_dump
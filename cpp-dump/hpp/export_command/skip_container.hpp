@@ -7,10 +7,12 @@
 
 #pragma once
 
-#include <functional>
+#include <array>
+#include <cstddef>
 #include <limits>
 #include <optional>
 #include <tuple>
+#include <type_traits>
 #include <utility>
 
 #include "../iterable.hpp"
@@ -19,27 +21,133 @@ namespace cpp_dump {
 
 namespace _detail {
 
+/*
+ * The indices of the elements shown, as at most two sorted ranges [first, last).
+ * The elements outside the ranges are replaced with an ellipsis for each gap.
+ */
+struct visible_ranges {
+ public:
+  static constexpr std::size_t to_end = std::numeric_limits<std::size_t>::max();
+
+  std::array<std::pair<std::size_t, std::size_t>, 2> ranges;
+  std::size_t size;
+};
+
+/*
+ * The skip policies below compute the visible ranges once per container.
+ * get_size() returns the size of the container, and is called only if the policy needs it.
+ * Any type with the same get_ranges() can be given to skip_container.
+ */
+struct front_policy {
+ public:
+  std::size_t count;
+
+  template <typename SizeFunc>
+  visible_ranges get_ranges(SizeFunc &&) const noexcept {
+    return {{{{0, count}}}, 1};
+  }
+};
+
+struct back_policy {
+ public:
+  std::size_t count;
+
+  template <typename SizeFunc>
+  visible_ranges get_ranges(SizeFunc &&get_size) const noexcept {
+    std::size_t size = get_size();
+    std::size_t first = size >= count ? size - count : 0;
+    return {{{{first, visible_ranges::to_end}}}, 1};
+  }
+};
+
+struct both_ends_policy {
+ public:
+  std::size_t half_count;
+
+  template <typename SizeFunc>
+  visible_ranges get_ranges(SizeFunc &&get_size) const noexcept {
+    std::size_t size = get_size();
+    std::size_t latter_half_first = size >= half_count ? size - half_count : 0;
+    if (latter_half_first <= half_count) {
+      return {{{{0, visible_ranges::to_end}}}, 1};
+    }
+    return {{{{0, half_count}, {latter_half_first, visible_ranges::to_end}}}, 2};
+  }
+};
+
+struct middle_policy {
+ public:
+  std::size_t count;
+
+  template <typename SizeFunc>
+  visible_ranges get_ranges(SizeFunc &&get_size) const noexcept {
+    std::size_t size = get_size();
+    std::size_t first = size >= count ? (size - count) / 2 : 0;
+    return {{{{first, first + count}}}, 1};
+  }
+};
+
+/*
+ * The skip policy that a command holds: the kind of front(), back(), both_ends() or middle(), and
+ * the iteration count. none means the default, which the command replaces with front().
+ * This is a value rather than a function so that manipulators are composed without the heap.
+ * It selects the policy type once per container.
+ */
+struct skip_policy {
+ public:
+  enum class kind_t : unsigned char { none, front, back, both_ends, middle };
+
+  kind_t kind = kind_t::none;
+  std::size_t count = 0;
+
+  explicit operator bool() const noexcept { return kind != kind_t::none; }
+
+  template <typename SizeFunc>
+  visible_ranges get_ranges(SizeFunc &&get_size) const noexcept {
+    switch (kind) {
+      case kind_t::back:
+        return back_policy{count}.get_ranges(get_size);
+      case kind_t::both_ends:
+        return both_ends_policy{count}.get_ranges(get_size);
+      case kind_t::middle:
+        return middle_policy{count}.get_ranges(get_size);
+      default:
+        return front_policy{count}.get_ranges(get_size);
+    }
+  }
+};
+
 template <typename>
 struct skip_container;
 
+/*
+ * The iterator to the first element of the last range, found by stepping backward from the end when
+ * that is shorter than stepping forward to it.
+ */
 template <typename It>
+struct tail_iterator {
+ public:
+  std::size_t first = visible_ranges::to_end;
+  std::optional<It> it;
+};
+
+// BeginIt is the type of the iterator to the first element, which the end may not share.
+template <typename It, typename BeginIt>
 struct skip_iterator {
  public:
   // It is not a reference when the constructor is given an rvalue.
   // It is an lvalue reference when the constructor is given an lvalue (reference).
   It it;
 
-  skip_iterator(
-      It &&it_,
-      const std::function<std::size_t(std::size_t, const std::function<std::size_t()> &)>
-          &skip_size_func,
-      const std::function<std::size_t()> &orig_size_func
-  )
+  skip_iterator(It &&it_, const visible_ranges &ranges, const tail_iterator<BeginIt> &tail)
       : it(std::forward<It>(it_)),
-        _skip_size_func(skip_size_func),
-        _orig_size_func(orig_size_func),
+        _ranges(ranges),
+        _tail(tail),
         _index(0),
-        _done(false) {}
+        _range(0),
+        _done(false) {
+    _update();
+  }
 
   skip_iterator(skip_iterator &&) = delete;
   skip_iterator &operator=(skip_iterator &&) = delete;
@@ -48,53 +156,95 @@ struct skip_iterator {
   skip_iterator() = delete;
 
   std::tuple<bool, It &, std::size_t> operator*() const noexcept {
-    bool is_ellipsis = calc_skip_size() != 0;
     // Pass the iterator to support the case that *it is rvalue.
     // Pass the reference to support non-copyable iterators.
     // https://stackoverflow.com/questions/2568294/is-it-a-good-idea-to-create-an-stl-iterator-which-is-noncopyable
-    return {is_ellipsis, const_cast<It &>(it), _index};
+    return {!_visible, const_cast<It &>(it), _index};
   }
-  template <typename It2>
-  bool operator!=(const skip_iterator<It2> &to) noexcept {
+  template <typename It2, typename BeginIt2>
+  bool operator!=(const skip_iterator<It2, BeginIt2> &to) noexcept {
     return !_done && it != to.it;
   }
   skip_iterator &operator++() noexcept {
-    std::size_t skip_size = calc_skip_size();
-    if (skip_size == std::numeric_limits<std::size_t>::max()) {
-      _done = true;
-    } else if (skip_size == 0) {
+    if (_visible) {
       ++it;
-      ++_index;
+      // Most elements are in the middle of a range.
+      if (++_index < _last) {
+        return *this;
+      }
+    } else if (_range < _ranges.size) {
+      // skip to the first of the next range
+      std::size_t first = _ranges.ranges[_range].first;
+      if constexpr (is_bidirectional_only_iterator<BeginIt>
+                    && std::is_same_v<std::decay_t<It>, BeginIt>) {
+        if (first == _tail.first) {
+          it = *_tail.it;
+        } else {
+          iterator_advance(it, first - _index);
+        }
+      } else {
+        iterator_advance(it, first - _index);
+      }
+      _index = first;
     } else {
-      iterator_advance(it, skip_size);
-      _index += skip_size;
+      // skip to the end
+      _done = true;
     }
+    _update();
     return *this;
   }
 
  private:
-  const std::function<std::size_t(std::size_t, const std::function<std::size_t()> &)>
-      &_skip_size_func;
-  const std::function<std::size_t()> &_orig_size_func;
+  const visible_ranges &_ranges;
+  const tail_iterator<BeginIt> &_tail;
   std::size_t _index;
+  std::size_t _range;
+  // The end of the range that contains the index.
+  std::size_t _last = 0;
+  bool _visible;
   bool _done;
 
-  std::size_t calc_skip_size() const noexcept { return _skip_size_func(_index, _orig_size_func); }
+  // Move to the range that contains the index or comes next.
+  void _update() noexcept {
+    while (_range < _ranges.size && _ranges.ranges[_range].second <= _index) {
+      ++_range;
+    }
+    _visible = _range < _ranges.size && _ranges.ranges[_range].first <= _index;
+    if (_visible) {
+      _last = _ranges.ranges[_range].second;
+    }
+  }
 };
 
-template <typename It>
-skip_iterator(It &&, const std::function<std::size_t(std::size_t, const std::function<std::size_t()> &)> &, const std::function<std::size_t()> &)
-    -> skip_iterator<It>;
+template <typename It, typename BeginIt>
+skip_iterator(It &&, const visible_ranges &, const tail_iterator<BeginIt> &)
+    -> skip_iterator<It, BeginIt>;
 
+/*
+ * If the iterator is bidirectional, the last range is reached by stepping backward from the end
+ * when that is shorter, so back(), both_ends() and the tail of a large std::list or std::map take
+ * time in proportion to the elements shown. A forward iterator steps forward as before.
+ */
 template <typename T>
 struct skip_container {
  public:
-  explicit skip_container(
-      const T &container,
-      const std::function<std::size_t(std::size_t, const std::function<std::size_t()> &)>
-          &skip_size_func
-  )
-      : _original(container), _skip_size_func(skip_size_func) {}
+  template <typename Policy>
+  explicit skip_container(const T &container, const Policy &policy)
+      : _original(container),
+        _ranges(policy.get_ranges([this] { return _size = iterable_size(_original); })) {
+    if constexpr (is_bidirectional_only_iterator<iterator_t>) {
+      if (_size == visible_ranges::to_end) return;
+      std::size_t last = _ranges.size - 1;
+      std::size_t first = _ranges.ranges[last].first;
+      std::size_t from = last == 0 ? 0 : _ranges.ranges[last - 1].second;
+      if (first >= _size || first <= from || _size - first >= first - from) return;
+      using difference_t = typename std::iterator_traits<iterator_t>::difference_type;
+      iterator_t it = iterable_end(_original);
+      std::advance(it, -static_cast<difference_t>(_size - first));
+      _tail.first = first;
+      _tail.it.emplace(std::move(it));
+    }
+  }
 
   skip_container(skip_container &&) = delete;
   skip_container &operator=(skip_container &&) = delete;
@@ -102,25 +252,17 @@ struct skip_container {
   skip_container &operator=(const skip_container &) = delete;
   skip_container() = delete;
 
-  auto begin() const noexcept {
-    return skip_iterator(iterable_begin(_original), _skip_size_func, _orig_size_func);
-  }
-  auto end() const noexcept {
-    return skip_iterator(iterable_end(_original), _skip_size_func, _orig_size_func);
-  }
+  auto begin() const noexcept { return skip_iterator(iterable_begin(_original), _ranges, _tail); }
+  auto end() const noexcept { return skip_iterator(iterable_end(_original), _ranges, _tail); }
 
  private:
-  const T &_original;
-  const std::function<std::size_t(std::size_t, const std::function<std::size_t()> &)>
-      &_skip_size_func;
+  using iterator_t = std::decay_t<decltype(iterable_begin(std::declval<const T &>()))>;
 
-  std::optional<std::size_t> _orig_size_cache;
-  const std::function<std::size_t()> _orig_size_func = [this] {
-    if (!_orig_size_cache) {
-      _orig_size_cache = iterable_size(_original);
-    }
-    return _orig_size_cache.value();
-  };
+  const T &_original;
+  // The size of the container, or to_end if the policy did not need it.
+  std::size_t _size = visible_ranges::to_end;
+  const visible_ranges _ranges;
+  tail_iterator<iterator_t> _tail;
 };
 
 }  // namespace _detail
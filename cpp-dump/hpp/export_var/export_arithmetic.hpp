@@ -9,77 +9,53 @@
 
 #include <algorithm>
 #include <cctype>
-#include <iomanip>
-#include <ios>
+#include <cstddef>
 #include <limits>
-#include <sstream>
 #include <string>
 #include <string_view>
 #include <type_traits>
 
+#include "../arena.hpp"
+#include "../document/document.hpp"
 #include "../escape_sequence.hpp"
 #include "../export_command/export_command.hpp"
+#include "../integer_format.hpp"
 #include "../type_check.hpp"
 
 namespace cpp_dump {
 
 namespace _detail {
 
+inline namespace _p_CPP_DUMP_ES_NAMESPACE {
+
 namespace _export_arithmetic {
 
-inline std::string export_arithmetic(
-    bool bool_value,
-    const std::string &,
-    std::size_t,
-    std::size_t,
-    bool,
-    const export_command &command
-) {
-  using bool_style_t = export_command::bool_style_t;
-  switch (command.bool_style()) {
-    case bool_style_t::normal:
-      return es::reserved(bool_value ? "true" : "false");
-    case bool_style_t::true_left:
-      return es::reserved(bool_value ? "true " : "false");
-    case bool_style_t::true_right:
-      return es::reserved(bool_value ? " true" : "false");
-    default:
-      return es::number(bool_value ? "1" : "0");
-  }
+inline const doc_node &
+export_arithmetic(bool bool_value, std::size_t, const export_command &command, document &doc) {
+  // The tokens are indexed by bool_style_t: normal, true_left, true_right, and number.
+  auto style = static_cast<std::size_t>(command.bool_style());
+  return doc.token(doc.tokens().bools[style][bool_value]);
 }
 
 template <typename T>
 inline auto export_arithmetic(
-    const T &value,
-    const std::string &indent,
-    std::size_t last_line_length,
-    std::size_t current_depth,
-    bool fail_on_newline,
-    const export_command &command
-) -> std::enable_if_t<is_vector_bool_reference<T>, std::string> {
-  return export_arithmetic(
-      static_cast<bool>(value), indent, last_line_length, current_depth, fail_on_newline, command
-  );
+    const T &value, std::size_t current_depth, const export_command &command, document &doc
+) -> std::enable_if_t<is_vector_bool_reference<T>, const doc_node &> {
+  return export_arithmetic(static_cast<bool>(value), current_depth, command, doc);
 }
 
-inline std::string export_arithmetic(
-    char char_value,
-    const std::string &,
-    std::size_t,
-    std::size_t,
-    bool,
-    const export_command &command
-) {
+inline temp_string _export_char(char char_value, const export_command &command) {
   const bool is_printable = std::isprint(static_cast<unsigned char>(char_value));
   const bool need_escape = !is_printable || char_value == '\'' || char_value == '\\';
 
-  std::string output;
+  auto output = make_temp_string();
   // Escape if needed.
   if (need_escape) {
-    auto escaped_char =
-        is_printable ? std::string({'\\', char_value}) : escape_non_printable_char(char_value);
+    const char backslash_and_char[] = {'\\', char_value};
+    auto escaped_char = is_printable ? std::string_view(backslash_and_char, 2)
+                                     : escape_non_printable_char(char_value);
     if (command.char_as_hex() && escaped_char.size() > 2) {
-      output = std::string(4, ' ');
+      output.assign(4, ' ');
     } else {
       output = es::character("'") + es::escaped_char(escaped_char) + es::character("'");
     }
@@ -110,6 +86,11 @@ inline std::string export_arithmetic(
   return output;
 }
 
+inline const doc_node &
+export_arithmetic(char char_value, std::size_t, const export_command &command, document &doc) {
+  return doc.text(_export_char(char_value, command));
+}
+
 // helper for _get_max_digits
 template <typename UnsignedT>
 constexpr unsigned int _get_max_digits_aux(UnsignedT num, unsigned int base) {
@@ -144,69 +125,25 @@ unsigned int _get_max_digits(unsigned int base) {
 }
 
 // helper for export_arithmetic(T)
-// Convert the absolute integer to a reversed string.
-template <typename T, typename UnsignedTOrInt>
-std::string _abs_to_reversed_str(UnsignedTOrInt abs, unsigned int base) {
-  std::string reversed;
-  if (base == 10) {
-    reversed = std::to_string(abs);
-    std::reverse(reversed.begin(), reversed.end());
-  } else if (base == 2) {
-    // +3 is for the prefix.
-    reversed.reserve(sizeof(T) * 8 + 3);
-    bool is_first = true;
-    while (is_first || abs) {
-      is_first = false;
-      char next_digit = static_cast<char>((abs & 0x01) + '0');
-      reversed.push_back(next_digit);
-      abs >>= 1;
-    }
-  } else {
-    std::stringstream ss;
-    ss << std::setbase(base) << std::uppercase << abs;
-    reversed = ss.str();
-    std::reverse(reversed.begin(), reversed.end());
-  }
-  return reversed;
-}
-
-// helper for export_arithmetic(T)
-// Add spaces between chunks.
-inline std::string _chunk_string(std::string_view input, int base, int chunk) {
-  std::string output;
-  output.reserve(input.size() * 2);
-  for (std::size_t pos = 0; pos < input.size(); pos += chunk) {
-    output.append(input, pos, chunk);
-    output.push_back(' ');
-  }
-  if (base == 10) {
-    output.pop_back();
-  }
-  return output;
-}
-
-// helper for export_arithmetic(T)
-inline const char *_get_reversed_prefix(int base) {
+inline std::string_view _get_prefix(unsigned int base) {
   // base == 10 is handled before this function.
   if (base == 2) {
-    return "b0";
+    return "0b";
   } else if (base == 8) {
-    return "o0";
+    return "0o";
   } else {
-    return "x0";
+    return "0x";
   }
 }
 
 template <typename T>
-inline auto export_arithmetic(
-    T value, const std::string &, std::size_t, std::size_t, bool, const export_command &command
-) -> std::enable_if_t<std::is_integral_v<T>, std::string> {
+inline auto _export_integer(T value, const export_command &command) -> temp_string {
   auto int_style_ = command.int_style();
   // If int_style is not specified, export with no style.
   if (!int_style_) {
-    std::string output = command.format(value);
+    auto output = command.format(value);
     if (output.empty()) {
-      return es::signed_number(std::to_string(value));
+      return es::signed_number(decimal_chars(value).view());
     }
     return es::signed_number(output);
   }
@@ -214,7 +151,7 @@ inline auto export_arithmetic(
   auto [base, digits, chunk, space_fill, make_unsigned_or_no_space_for_minus] = int_style_.value();
   // If base is 10 and the other values are not specified, export with no style.
   if (base == 10 && digits == 0 && chunk == 0) {
-    return es::signed_number(std::to_string(value));
+    return es::signed_number(decimal_chars(value).view());
   }
 
   // Style the integer with int_style.
@@ -231,79 +168,93 @@ inline auto export_arithmetic(
       std::is_signed_v<T> && base != 10 && make_unsigned_or_no_space_for_minus;
   const bool add_extra_space = !(std::is_unsigned_v<T> || make_unsigned_or_no_space_for_minus);
   using UnsignedT = std::make_unsigned_t<T>;
-  // Let stringstream recognize the type as an integer.
-  using UnsignedTOrInt =
-      std::conditional_t<(sizeof(UnsignedT) > sizeof(unsigned int)), UnsignedT, unsigned int>;
-  UnsignedTOrInt abs;
+  UnsignedT abs;
   if constexpr (std::is_signed_v<T>) {
-    if (make_unsigned) {
-      abs = static_cast<UnsignedTOrInt>(static_cast<UnsignedT>(value));
+    if (make_unsigned || value >= 0) {
+      abs = static_cast<UnsignedT>(value);
     } else {
-      // Use explicit conversion to avoid long->size_t conversion issues in MSVC C++23
-      abs = static_cast<UnsignedTOrInt>(value < 0 ? static_cast<UnsignedT>(-value) : static_cast<UnsignedT>(value));
+      // Negate in UnsignedT so that the minimum value does not overflow.
+      abs = static_cast<UnsignedT>(UnsignedT{0} - static_cast<UnsignedT>(value));
     }
   } else {
     abs = value;
   }
 
-  // Create a (reversed) string of the abs with base as the radix
-  std::string output = _abs_to_reversed_str<T, UnsignedTOrInt>(abs, base);
+  // The output is written from the end: the digits, the fill, the chunks, the prefix, and the sign.
+  // The digits and the fill are at most max_digits + 1 characters, and chunking doubles them.
+  constexpr std::size_t max_body_size = sizeof(T) * 8 + 1;
+  backward_buffer<max_body_size> body;
+  body.push_digits(abs, base);
 
   // Add a minus before filling when needed
   const bool need_minus = !make_unsigned && value < 0;
   const bool minus_before_fill = base == 10 && space_fill;
   if (need_minus && minus_before_fill) {
-    output.push_back('-');
+    body.push_front('-');
   }
 
   // Fill with spaces/zeros to make the length `digits`
-  if (output.size() < digits) {
-    output.append(digits - output.size(), space_fill ? ' ' : '0');
+  if (body.size() < digits) {
+    body.push_front(digits - body.size(), space_fill ? ' ' : '0');
   }
 
-  const bool length_was_below_digits = output.size() <= digits;
+  const bool length_was_below_digits = body.size() <= digits;
   // Add a space between chunks
+  backward_buffer<max_body_size * 2 + 3> output;
   if (chunk > 0) {
-    output = _chunk_string(output, base, chunk);
+    output.push_chunks(body.view(), chunk, base == 10);
+  } else {
+    output.push_front(body.view());
   }
 
   // Add prefix.
   if (base != 10) {
-    output.append(_get_reversed_prefix(base));
+    output.push_front(_get_prefix(base));
   }
 
   // Add a minus after filling when needed
   if (need_minus && !minus_before_fill) {
-    output.push_back('-');
+    output.push_front('-');
   } else if (length_was_below_digits && add_extra_space) {
-    output.push_back(' ');
+    output.push_front(' ');
   }
 
-  // Reverse the output and add color and suffix.
-  std::reverse(output.begin(), output.end());
-  output = es::signed_number(output);
+  // Add color and suffix.
+  auto styled_output = es::signed_number(output.view());
   if (make_unsigned) {
-    output.append(es::op(" u"));
+    styled_output.append(es::op(" u"));
   }
 
-  return output;
+  return styled_output;
 }
 
 template <typename T>
-inline auto export_arithmetic(
-    T value, const std::string &, std::size_t, std::size_t, bool, const export_command &command
-) -> std::enable_if_t<std::is_floating_point_v<T>, std::string> {
-  std::string output = command.format(value);
+inline auto _export_floating_point(T value, const export_command &command) -> temp_string {
+  auto output = command.format(value);
   if (output.empty()) {
     return es::signed_number(std::to_string(value));
   }
   return es::signed_number(output);
 }
 
+template <typename T>
+inline auto export_arithmetic(T value, std::size_t, const export_command &command, document &doc)
+    -> std::enable_if_t<std::is_integral_v<T>, const doc_node &> {
+  return doc.text(_export_integer(value, command));
+}
+
+template <typename T>
+inline auto export_arithmetic(T value, std::size_t, const export_command &command, document &doc)
+    -> std::enable_if_t<std::is_floating_point_v<T>, const doc_node &> {
+  return doc.text(_export_floating_point(value, command));
+}
+
 }  // namespace _export_arithmetic
 
 using _export_arithmetic::export_arithmetic;
 
+}  // namespace _p_CPP_DUMP_ES_NAMESPACE
+
 }  // namespace _detail
 
 }  // namespace cpp_dump
@@ -11,6 +11,7 @@
 #include <string_view>
 #include <type_traits>
 
+#include "../document/document.hpp"
 #include "../escape_sequence.hpp"
 #include "../export_command/export_command.hpp"
 #include "../options.hpp"
@@ -22,39 +23,35 @@ namespace cpp_dump {
 
 namespace _detail {
 
+inline namespace _p_CPP_DUMP_ES_NAMESPACE {
+
 namespace _export_asterisk {
 
-inline std::string _es_asterisk(std::string_view s) {
-  return options::es_style == types::es_style_t::original ? es::identifier(s) : es::op(s);
+inline temp_string _es_asterisk(std::string_view s) {
+  return current_options().es_style == types::es_style_t::original ? es::identifier(s) : es::op(s);
 }
 
 template <typename T>
 inline auto export_asterisk(
-    const T &value,
-    const std::string &indent,
-    std::size_t last_line_length,
-    std::size_t current_depth,
-    bool fail_on_newline,
-    const export_command &command
-) -> std::enable_if_t<is_asterisk<T>, std::string> {
-  if (!options::enable_asterisk) {
-    return export_unsupported();
+    const T &value, std::size_t current_depth, const export_command &command, document &doc
+) -> std::enable_if_t<is_asterisk<T>, const doc_node &> {
+  if (!current_options().enable_asterisk) {
+    return export_unsupported(doc);
   }
-  if (current_depth >= options::max_depth) {
-    return _es_asterisk("*") + es::op("...");
+  if (current_depth >= current_options().max_depth) {
+    return doc.prefix(_es_asterisk("*"), doc.token(doc.tokens().ellipsis));
   }
 
   // We increase depth just in case so that *value won't enter an infinite loop.
-  return _es_asterisk("*")
-         + export_var(
-             *value, indent, last_line_length + 1, current_depth + 1, fail_on_newline, command
-         );
+  return doc.prefix(_es_asterisk("*"), export_var(*value, current_depth + 1, command, doc));
 }
 
 }  // namespace _export_asterisk
 
 using _export_asterisk::export_asterisk;
 
+}  // namespace _p_CPP_DUMP_ES_NAMESPACE
+
 }  // namespace _detail
 
 }  // namespace cpp_dump
@@ -11,8 +11,10 @@
 #include <string_view>
 #include <type_traits>
 
+#include "../document/document.hpp"
 #include "../escape_sequence.hpp"
 #include "../export_command/export_command.hpp"
+#include "../integer_format.hpp"
 #include "../iterable.hpp"
 #include "../options.hpp"
 #include "../type_check.hpp"
@@ -23,135 +25,71 @@ namespace cpp_dump {
 
 namespace _detail {
 
+inline namespace _p_CPP_DUMP_ES_NAMESPACE {
+
+// Whether the elements of T are printed on separate lines regardless of the width.
+// This is also used for the Set category.
+template <typename T>
+inline bool shift_indent_of_elems() {
+  using elem_t = iterable_elem_type<T>;
+  switch (current_options().cont_indent_style) {
+    case types::cont_indent_style_t::always:
+      return true;
+    case types::cont_indent_style_t::when_nested:
+      return is_iterable_like<elem_t>;
+    case types::cont_indent_style_t::when_non_tuples_nested:
+      return is_iterable_like<elem_t> && !is_tuple<elem_t>;
+    default:
+      return false;
+  }
+}
+
 template <typename T>
 inline auto export_container(
-    const T &container,
-    const std::string &indent,
-    std::size_t last_line_length,
-    std::size_t current_depth,
-    bool fail_on_newline,
-    const export_command &command
-) -> std::enable_if_t<is_container<T>, std::string> {
+    const T &container, std::size_t current_depth, const export_command &command, document &doc
+) -> std::enable_if_t<is_container<T>, const doc_node &> {
   // In case the container is empty.
   if (is_empty_iterable(container)) {
-    return es::bracket("[ ]", current_depth);
+    return doc.token(doc.tokens().depth(current_depth).empty_square);
   }
   // In case the depth exceeds max_depth.
-  if (current_depth >= options::max_depth) {
-    return es::bracket("[ ", current_depth) + es::op("...") + es::bracket(" ]", current_depth);
+  if (current_depth >= current_options().max_depth) {
+    return doc.token(doc.tokens().depth(current_depth).omitted_square);
   }
 
   // Declare variables.
   std::size_t next_depth = current_depth + 1;
   const auto &next_command = command.next();
   auto skipped_container = command.create_skip_container(container);
-  bool shift_indent = false;
-  if (options::cont_indent_style == types::cont_indent_style_t::always) {
-    shift_indent = true;
-  } else if (options::cont_indent_style == types::cont_indent_style_t::when_nested) {
-    shift_indent = is_iterable_like<iterable_elem_type<T>>;
-  } else if (options::cont_indent_style == types::cont_indent_style_t::when_non_tuples_nested) {
-    shift_indent = is_iterable_like<iterable_elem_type<T>> && !is_tuple<iterable_elem_type<T>>;
-  }
-
-  // Try printing on one line.
-  if (!shift_indent) {
-    std::string output = es::bracket("[ ", current_depth);
-    bool is_first_elem = true;
-    for (auto &&[is_ellipsis, it, index_] : skipped_container) {
-      const auto &elem = *it;
-
-      // Add comma.
-      if (is_first_elem) {
-        is_first_elem = false;
-      } else {
-        output += es::op(", ");
-      }
-
-      // If the `elem` is an ellipsis, skip it.
-      if (is_ellipsis) {
-        output += es::op("...");
-        if (last_line_length + get_length(output) + std::string_view(" ]").size()
-            > options::max_line_width) {
-          shift_indent = true;
-          break;
-        }
-        continue;
-      }
-
-      // Add the index if needed.
-      if (command.show_index()) {
-        output += es::member(std::to_string(index_)) + es::op(": ");
-      }
-
-      // Add the stringified `elem`.
-      std::string elem_str = export_var(
-          elem, indent, last_line_length + get_length(output), next_depth, true, next_command
-      );
-      if (has_newline(elem_str)) {
-        shift_indent = true;
-        break;
-      }
-      output += elem_str;
-
-      // If the line length exceeds, stop the iteration.
-      if (last_line_length + get_length(output) + std::string_view(" ]").size()
-          > options::max_line_width) {
-        shift_indent = true;
-        break;
-      }
-    }
-
-    if (!shift_indent) {
-      output += es::bracket(" ]", current_depth);
-      return output;
-    }
-  }
-
-  // Print on multiple lines.
-
-  if (fail_on_newline) {
-    return "\n";
-  }
-
-  // Declare variables.
-  std::string new_indent = indent + "  ";
-  std::string output = es::bracket("[", current_depth);
-  bool is_first_elem = true;
+  auto &group = doc.bracket_group("[", current_depth, shift_indent_of_elems<T>());
 
   // universal references; it.operator*() might not be const
   for (auto &&[is_ellipsis, it, index_] : skipped_container) {
     const auto &elem = *it;
 
-    // Add comma.
-    if (is_first_elem) {
-      is_first_elem = false;
-    } else {
-      output += es::op(",");
-    }
-
     // If the `elem` is an ellipsis, skip it.
     if (is_ellipsis) {
-      output += "\n" + new_indent + es::op("...");
+      group.add_item({&doc.token(doc.tokens().ellipsis)});
       continue;
     }
 
-    output += "\n" + new_indent;
-
     // Add the index if needed.
     if (command.show_index()) {
-      output += es::member(std::to_string(index_)) + es::op(": ");
+      group.add_item(
+          {&doc.text(concat(es::member(decimal_chars(index_).view()), doc.tokens().colon.str)),
+           &export_var(elem, next_depth, next_command, doc)}
+      );
+      continue;
     }
 
-    // Add the stringified `elem`.
-    output +=
-        export_var(elem, new_indent, get_last_line_length(output), next_depth, false, next_command);
+    group.add_item({&export_var(elem, next_depth, next_command, doc)});
   }
-  output += "\n" + indent + es::bracket("]", current_depth);
 
-  return output;
+  return group;
 }
 
+}  // namespace _p_CPP_DUMP_ES_NAMESPACE
+
 }  // namespace _detail
 
 }  // namespace cpp_dump
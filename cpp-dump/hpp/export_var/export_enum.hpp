@@ -7,10 +7,12 @@
 
 #pragma once
 
-#include <map>
 #include <string>
 #include <string_view>
+#include <utility>
 
+#include "../document/document.hpp"
+#include "../enum_table.hpp"
 #include "../escape_sequence.hpp"
 #include "../expand_va_macro.hpp"
 #include "../export_command/export_command.hpp"
@@ -23,35 +25,45 @@
 /**
  * Make cpp_dump::export_var() support enum TYPE.
  */
-#define CPP_DUMP_DEFINE_EXPORT_ENUM(TYPE, ...)                                                                       \
-  namespace cpp_dump {                                                                                               \
-                                                                                                                     \
-  namespace _detail {                                                                                                \
-                                                                                                                     \
-  template <>                                                                                                        \
-  inline constexpr bool _is_exportable_enum<TYPE> = true;                                                            \
-                                                                                                                     \
-  template <>                                                                                                        \
-  inline std::string                                                                                                 \
-  export_enum(const TYPE &enum_const, const std::string &, std::size_t, std::size_t, bool, const export_command &) { \
-    static const std::map<TYPE, std::string_view> enum_to_string{                                                    \
-        _p_CPP_DUMP_EXPAND_VA(_p_CPP_DUMP_EXPAND_FOR_EXPORT_ENUM, __VA_ARGS__)};                                     \
-    return enum_to_string.count(enum_const)                                                                          \
-               ? es::enumerator(enum_to_string.at(enum_const))                                                       \
-               : es::class_name(#TYPE) + es::op("::") + es::unsupported("?");                                        \
-  }                                                                                                                  \
-                                                                                                                     \
-  } /* namespace _detail */                                                                                          \
-                                                                                                                     \
+#define CPP_DUMP_DEFINE_EXPORT_ENUM(TYPE, ...)                                                     \
+  namespace cpp_dump {                                                                             \
+                                                                                                   \
+  namespace _detail {                                                                              \
+                                                                                                   \
+  inline namespace _p_CPP_DUMP_ES_NAMESPACE {                                                      \
+                                                                                                   \
+  template <>                                                                                      \
+  inline constexpr bool _is_exportable_enum<TYPE> = true;                                          \
+                                                                                                   \
+  template <>                                                                                      \
+  inline const doc_node &                                                                          \
+  export_enum(const TYPE &enum_const, std::size_t, const export_command &, document &doc) {        \
+    static constexpr std::pair<TYPE, std::string_view> enum_entries[] = {                          \
+        _p_CPP_DUMP_EXPAND_VA(_p_CPP_DUMP_EXPAND_FOR_EXPORT_ENUM, __VA_ARGS__)};                   \
+    static constexpr auto enum_to_string = make_enum_table(enum_entries);                          \
+    auto name = enum_to_string.find(enum_const);                                                   \
+    return doc.text(                                                                               \
+        !name.empty() ? es::enumerator(name)                                                       \
+                      : es::class_name(#TYPE) + es::op("::") + es::unsupported("?")                \
+    );                                                                                             \
+  }                                                                                                \
+                                                                                                   \
+  } /* namespace _p_CPP_DUMP_ES_NAMESPACE */                                                       \
+                                                                                                   \
+  } /* namespace _detail */                                                                        \
+                                                                                                   \
   }  // namespace cpp_dump
 
 namespace cpp_dump {
 
 namespace _detail {
 
+inline namespace _p_CPP_DUMP_ES_NAMESPACE {
+
 template <typename T>
-inline std::string
-export_enum(const T &, const std::string &, std::size_t, std::size_t, bool, const export_command &);
+inline const doc_node &export_enum(const T &, std::size_t, const export_command &, document &);
+
+}  // namespace _p_CPP_DUMP_ES_NAMESPACE
 
 }  // namespace _detail
 
@@ -7,10 +7,13 @@
 
 #pragma once
 
-#include <map>
 #include <string>
+#include <string_view>
 #include <type_traits>
+#include <utility>
 
+#include "../document/document.hpp"
+#include "../enum_table.hpp"
 #include "../escape_sequence.hpp"
 #include "../expand_va_macro.hpp"
 #include "../export_command/export_command.hpp"
@@ -24,24 +27,33 @@
  * Make cpp_dump::export_var() support every enum type that has the specified members.
  * Compile errors in this macro, such as ambiguous function calls, are never reported due to SFINAE.
  */
-#define CPP_DUMP_DEFINE_EXPORT_ENUM_GENERIC(...)                                                                     \
-  namespace cpp_dump {                                                                                               \
-                                                                                                                     \
-  namespace _detail {                                                                                                \
-                                                                                                                     \
-  template <typename T>                                                                                              \
-  inline auto                                                                                                        \
-  export_enum_generic(T value, const std::string &, std::size_t, std::size_t, bool, const export_command &)          \
-      -> std::enable_if_t<                                                                                           \
-          std::is_enum_v<T>,                                                                                         \
-          decltype(_p_CPP_DUMP_EXPAND_VA(_p_CPP_DUMP_EXPAND_FOR_EXPORT_ENUM_GENERIC, __VA_ARGS__), std::string())> { \
-    static const std::map<T, std::string_view> enum_to_string{                                                       \
-        _p_CPP_DUMP_EXPAND_VA(_p_CPP_DUMP_EXPAND_FOR_EXPORT_ENUM_GENERIC2, __VA_ARGS__)};                            \
-    return es::class_name(get_typename<T>()) + es::op("::")                                                          \
-           + (enum_to_string.count(value) ? es::member(enum_to_string.at(value))                                     \
-                                          : es::unsupported("?"));                                                   \
-  }                                                                                                                  \
-                                                                                                                     \
-  } /* namespace _detail */                                                                                          \
-                                                                                                                     \
+#define CPP_DUMP_DEFINE_EXPORT_ENUM_GENERIC(...)                                                   \
+  namespace cpp_dump {                                                                             \
+                                                                                                   \
+  namespace _detail {                                                                              \
+                                                                                                   \
+  inline namespace _p_CPP_DUMP_ES_NAMESPACE {                                                      \
+                                                                                                   \
+  template <typename T>                                                                            \
+  inline auto export_enum_generic(T value, std::size_t, const export_command &, document &doc)     \
+      -> std::enable_if_t<                                                                         \
+          std::is_enum_v<T>,                                                                       \
+          decltype(                                                                                \
+              _p_CPP_DUMP_EXPAND_VA(_p_CPP_DUMP_EXPAND_FOR_EXPORT_ENUM_GENERIC, __VA_ARGS__),      \
+              std::declval<const doc_node &>()                                                     \
+          )> {                                                                                     \
+    static constexpr std::pair<T, std::string_view> enum_entries[] = {                             \
+        _p_CPP_DUMP_EXPAND_VA(_p_CPP_DUMP_EXPAND_FOR_EXPORT_ENUM_GENERIC2, __VA_ARGS__)};          \
+    static constexpr auto enum_to_string = make_enum_table(enum_entries);                          \
+    auto name = enum_to_string.find(value);                                                        \
+    return doc.text(                                                                               \
+        es::class_name(get_typename<T>()) + es::op("::")                                           \
+        + (!name.empty() ? es::member(name) : es::unsupported("?"))                                \
+    );                                                                                             \
+  }                                                                                                \
+                                                                                                   \
+  } /* namespace _p_CPP_DUMP_ES_NAMESPACE */                                                       \
+                                                                                                   \
+  } /* namespace _detail */                                                                        \
+                                                                                                   \
   }  // namespace cpp_dump
@@ -10,6 +10,7 @@
 #include <string>
 #include <type_traits>
 
+#include "../document/document.hpp"
 #include "../escape_sequence.hpp"
 #include "../export_command/export_command.hpp"
 #include "../type_check.hpp"
@@ -19,16 +20,16 @@ namespace cpp_dump {
 
 namespace _detail {
 
+inline namespace _p_CPP_DUMP_ES_NAMESPACE {
+
 template <typename T>
 inline auto export_exception(
     const T &exception,
-    const std::string &indent,
-    std::size_t last_line_length,
     std::size_t current_depth,
-    bool fail_on_newline,
-    const export_command &command
-) -> std::enable_if_t<is_exception<T>, std::string> {
-  std::string class_name = es::class_name(get_typename<T>());
+    const export_command &command,
+    document &doc
+) -> std::enable_if_t<is_exception<T>, const doc_node &> {
+  auto class_name = es::class_name(get_typename<T>());
 
   _p_CPP_DUMP_DEFINE_EXPORT_OBJECT_COMMON1;
 
@@ -37,6 +38,8 @@ inline auto export_exception(
   _p_CPP_DUMP_DEFINE_EXPORT_OBJECT_COMMON2;
 }
 
+}  // namespace _p_CPP_DUMP_ES_NAMESPACE
+
 }  // namespace _detail
 
 }  // namespace cpp_dump
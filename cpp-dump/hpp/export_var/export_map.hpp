@@ -11,8 +11,11 @@
 #include <string_view>
 #include <type_traits>
 
+#include "../document/document.hpp"
 #include "../escape_sequence.hpp"
 #include "../export_command/export_command.hpp"
+#include "../integer_format.hpp"
+#include "../key_groups.hpp"
 #include "../options.hpp"
 #include "../type_check.hpp"
 #include "../utility.hpp"
@@ -22,6 +25,8 @@ namespace cpp_dump {
 
 namespace _detail {
 
+inline namespace _p_CPP_DUMP_ES_NAMESPACE {
+
 namespace _export_map {
 
 template <typename T>
@@ -37,36 +42,6 @@ struct _map_dummy_wrapper {
   const T &_map;
 };
 
-template <typename T>
-struct _multimap_wrapper {
- public:
-  explicit _multimap_wrapper(const T &map) : _map(map) {}
-
-  auto begin() const noexcept { return multimap_wrapper_iterator(_map, _map.begin()); }
-  auto end() const noexcept { return multimap_wrapper_iterator(_map, _map.end()); }
-
- private:
-  struct multimap_wrapper_iterator {
-   public:
-    using It = typename T::const_iterator;
-    multimap_wrapper_iterator(const T &map, It it) : _map(map), _it(it) {}
-
-    const auto &operator*() const noexcept { return *_it; }
-    auto operator->() const noexcept { return _it.operator->(); }
-    bool operator!=(const multimap_wrapper_iterator &to) const { return _it != to._it; }
-    multimap_wrapper_iterator &operator++() {
-      _it = _map.equal_range(_it->first).second;
-      return *this;
-    }
-
-   private:
-    const T &_map;
-    It _it;
-  };
-
-  const T &_map;
-};
-
 template <typename It>
 struct _multimap_value_wrapper {
  public:
@@ -97,22 +72,35 @@ struct _multimap_value_wrapper {
   It _end;
 };
 
+// Whether the entries of T are printed on separate lines regardless of the width.
+template <typename T>
+inline bool shift_indent_of_map() {
+  using key_t = typename T::key_type;
+  using mapped_t = typename T::mapped_type;
+  switch (current_options().cont_indent_style) {
+    case types::cont_indent_style_t::always:
+      return true;
+    case types::cont_indent_style_t::when_nested:
+      return is_multimap<T> || is_iterable_like<key_t> || is_iterable_like<mapped_t>;
+    case types::cont_indent_style_t::when_non_tuples_nested:
+      return is_multimap<T> || (is_iterable_like<key_t> && !is_tuple<key_t>)
+             || (is_iterable_like<mapped_t> && !is_tuple<mapped_t>);
+    default:
+      return false;
+  }
+}
+
 template <typename T>
 inline auto export_map(
-    const T &map,
-    const std::string &indent,
-    std::size_t last_line_length,
-    std::size_t current_depth,
-    bool fail_on_newline,
-    const export_command &command
-) -> std::enable_if_t<is_map<T>, std::string> {
+    const T &map, std::size_t current_depth, const export_command &command, document &doc
+) -> std::enable_if_t<is_map<T>, const doc_node &> {
   // In case the map is empty.
   if (map.empty()) {
-    return es::bracket("{ }", current_depth);
+    return doc.token(doc.tokens().depth(current_depth).empty_curly);
   }
   // In case the depth exceeds max_depth.
-  if (current_depth >= options::max_depth) {
-    return es::bracket("{ ", current_depth) + es::op("...") + es::bracket(" }", current_depth);
+  if (current_depth >= current_options().max_depth) {
+    return doc.token(doc.tokens().depth(current_depth).omitted_curly);
   }
 
   // Declare variables.
@@ -121,171 +109,56 @@ inline auto export_map(
   const auto &value_command = command.next_for_map_value();
   auto map_wrapper = ([&]() {
     if constexpr (is_multimap<T>) {
-      return _multimap_wrapper(map);
+      return key_groups(map);
     } else {
       // The wrapper is to avoid calling the copy constructor.
       return _map_dummy_wrapper(map);
     }
   })();
   auto skipped_map = command.create_skip_container(map_wrapper);
-  bool shift_indent = false;
-  if (options::cont_indent_style == types::cont_indent_style_t::always) {
-    shift_indent = true;
-  } else if (options::cont_indent_style == types::cont_indent_style_t::when_nested) {
-    shift_indent = is_multimap<T> || is_iterable_like<typename T::key_type>
-                   || is_iterable_like<typename T::mapped_type>;
-  } else if (options::cont_indent_style == types::cont_indent_style_t::when_non_tuples_nested) {
-    shift_indent =
-        is_multimap<T>
-        || (is_iterable_like<typename T::key_type> && !is_tuple<typename T::key_type>)
-        || (is_iterable_like<typename T::mapped_type> && !is_tuple<typename T::mapped_type>);
-  }
-
-  // Try printing on one line.
-  if (!shift_indent) {
-    std::string output = es::bracket("{ ", current_depth);
-    bool is_first_elem = true;
-    for (const auto &[is_ellipsis, it, _index] : skipped_map) {
-      [[maybe_unused]] const auto &_index_unused = _index;  // for g++-7 compiler support
-      const auto &[key, value] = *it;
-
-      // Add comma.
-      if (is_first_elem) {
-        is_first_elem = false;
-      } else {
-        output += es::op(", ");
-      }
-
-      // If the `elem` is an ellipsis, skip it.
-      if (is_ellipsis) {
-        output += es::op("...");
-        if (last_line_length + get_length(output) + std::string_view(" }").size()
-            > options::max_line_width) {
-          shift_indent = true;
-          break;
-        }
-        continue;
-      }
-
-      // Add the string representation of the key and value.
-      std::string elem_str;
-      if constexpr (is_multimap<T>) {
-        auto [_begin, _end] = map.equal_range(key);
-        _multimap_value_wrapper values(_begin, _end);
-
-        // Treat the multiplicity as a member to distinguish it from the keys & values.
-        // Also, multiplicities are similar to members since they are on the left side of values.
-        std::string key_str =
-            export_var(
-                key, indent, last_line_length + get_length(output), next_depth, true, key_command
-            )
-            + es::member(" (" + std::to_string(map.count(key)) + ")") + es::op(": ");
-        std::string value_str = export_var(
-            values,
-            indent,
-            last_line_length + get_length(output) + get_length(key_str),
-            next_depth,
-            true,
-            value_command
-        );
-        elem_str = key_str + value_str;
-      } else {
-        std::string key_str =
-            export_var(
-                key, indent, last_line_length + get_length(output), next_depth, true, key_command
-            )
-            + es::op(": ");
-        std::string value_str = export_var(
-            value,
-            indent,
-            last_line_length + get_length(output) + get_length(key_str),
-            next_depth,
-            true,
-            value_command
-        );
-        elem_str = key_str + value_str;
-      }
-      if (has_newline(elem_str)) {
-        shift_indent = true;
-        break;
-      }
-      output += elem_str;
-
-      // If the line length exceeds, stop the iteration.
-      if (last_line_length + get_length(output) + std::string_view(" }").size()
-          > options::max_line_width) {
-        shift_indent = true;
-        break;
-      }
-    }
-
-    if (!shift_indent) {
-      output += es::bracket(" }", current_depth);
-      return output;
-    }
-  }
-
-  // Print on multiple lines.
-
-  if (fail_on_newline) {
-    return "\n";
-  }
+  auto &group = doc.bracket_group("{", current_depth, shift_indent_of_map<T>());
 
-  // Declare variables.
-  std::string new_indent = indent + "  ";
-  std::string output = es::bracket("{", current_depth);
-  bool is_first_elem = true;
   for (const auto &[is_ellipsis, it, _index] : skipped_map) {
     [[maybe_unused]] const auto &_index_unused = _index;  // for g++-7 compiler support
     const auto &[key, value] = *it;
 
-    // Add comma.
-    if (is_first_elem) {
-      is_first_elem = false;
-    } else {
-      output += es::op(",");
-    }
-
     // If the `elem` is an ellipsis, skip it.
     if (is_ellipsis) {
-      output += "\n" + new_indent + es::op("...");
+      group.add_item({&doc.token(doc.tokens().ellipsis)});
       continue;
     }
 
     // Add the string representation of the key and value.
     if constexpr (is_multimap<T>) {
-      auto [_begin, _end] = map.equal_range(key);
-      _multimap_value_wrapper values(_begin, _end);
+      _multimap_value_wrapper values(it.group_begin(), it.group_end());
 
       // Treat the multiplicity as a member to distinguish it from the keys & values.
       // Also, multiplicities are similar to members since they are on the left side of values.
-      std::string key_str =
-          "\n" + new_indent
-          + export_var(key, new_indent, new_indent.length(), next_depth, false, key_command)
-          + es::member(" (" + std::to_string(map.count(key)) + ")") + es::op(": ");
-      std::string value_str = export_var(
-          values, new_indent, get_last_line_length(key_str), next_depth, false, value_command
+      group.add_item(
+          {&export_var(key, next_depth, key_command, doc),
+           &doc.text(concat(
+               es::member(concat(" (", decimal_chars(it.count()).view(), ")")), es::op(": ")
+           )),
+           &export_var(values, next_depth, value_command, doc)}
       );
-      output += key_str + value_str;
     } else {
-      std::string key_str =
-          "\n" + new_indent
-          + export_var(key, new_indent, new_indent.length(), next_depth, false, key_command)
-          + es::op(": ");
-      std::string value_str = export_var(
-          value, new_indent, get_last_line_length(key_str), next_depth, false, value_command
+      group.add_item(
+          {&export_var(key, next_depth, key_command, doc),
+           &doc.token(doc.tokens().colon),
+           &export_var(value, next_depth, value_command, doc)}
       );
-      output += key_str + value_str;
     }
   }
-  output += "\n" + indent + es::bracket("}", current_depth);
 
-  return output;
+  return group;
 }
 
 }  // namespace _export_map
 
 using _export_map::export_map;
+using _export_map::shift_indent_of_map;
+
+}  // namespace _p_CPP_DUMP_ES_NAMESPACE
 
 }  // namespace _detail
 
@@ -9,6 +9,7 @@
 
 #include <string>
 
+#include "../document/document.hpp"
 #include "../escape_sequence.hpp"
 #include "../expand_va_macro.hpp"
 #include "../export_command/export_command.hpp"
@@ -26,19 +27,16 @@
                                                                                                    \
   namespace _detail {                                                                              \
                                                                                                    \
+  inline namespace _p_CPP_DUMP_ES_NAMESPACE {                                                      \
+                                                                                                   \
   template <>                                                                                      \
   inline constexpr bool _is_exportable_object<TYPE> = true;                                        \
                                                                                                    \
   template <>                                                                                      \
-  inline std::string export_object(                                                                \
-      const TYPE &value,                                                                           \
-      const std::string &indent,                                                                   \
-      std::size_t last_line_length,                                                                \
-      std::size_t current_depth,                                                                   \
-      bool fail_on_newline,                                                                        \
-      const export_command &command                                                                \
+  inline const doc_node &export_object(                                                            \
+      const TYPE &value, std::size_t current_depth, const export_command &command, document &doc   \
   ) {                                                                                              \
-    std::string class_name = es::class_name(#TYPE);                                                \
+    auto class_name = es::class_name(#TYPE);                                                       \
                                                                                                    \
     _p_CPP_DUMP_DEFINE_EXPORT_OBJECT_COMMON1;                                                      \
                                                                                                    \
@@ -47,6 +45,8 @@
     _p_CPP_DUMP_DEFINE_EXPORT_OBJECT_COMMON2;                                                      \
   }                                                                                                \
                                                                                                    \
+  } /* namespace _p_CPP_DUMP_ES_NAMESPACE */                                                       \
+                                                                                                   \
   } /* namespace _detail */                                                                        \
                                                                                                    \
   }  // namespace cpp_dump
@@ -55,9 +55,12 @@ namespace cpp_dump {
 
 namespace _detail {
 
+inline namespace _p_CPP_DUMP_ES_NAMESPACE {
+
 template <typename T>
-inline std::string
-export_object(const T &, const std::string &, std::size_t, std::size_t, bool, const export_command &);
+inline const doc_node &export_object(const T &, std::size_t, const export_command &, document &);
+
+}  // namespace _p_CPP_DUMP_ES_NAMESPACE
 
 }  // namespace _detail
 
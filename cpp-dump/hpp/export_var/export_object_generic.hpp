@@ -8,7 +8,9 @@
 #pragma once
 
 #include <string>
+#include <utility>
 
+#include "../document/document.hpp"
 #include "../escape_sequence.hpp"
 #include "../expand_va_macro.hpp"
 #include "../export_command/export_command.hpp"
@@ -23,31 +25,33 @@
  * Member functions to be displayed must be const.
  * Compile errors in this macro, such as ambiguous function calls, are never reported due to SFINAE.
  */
-#define CPP_DUMP_DEFINE_EXPORT_OBJECT_GENERIC(...)                                                                 \
-  namespace cpp_dump {                                                                                             \
-                                                                                                                   \
-  namespace _detail {                                                                                              \
-                                                                                                                   \
-  template <typename T>                                                                                            \
-  inline auto export_object_generic(                                                                               \
-      const T &value,                                                                                              \
-      const std::string &indent,                                                                                   \
-      std::size_t last_line_length,                                                                                \
-      std::size_t current_depth,                                                                                   \
-      bool fail_on_newline,                                                                                        \
-      const export_command &command                                                                                \
-  ) -> decltype(_p_CPP_DUMP_EXPAND_VA(_p_CPP_DUMP_EXPAND_FOR_EXPORT_OBJECT_GENERIC, __VA_ARGS__), std::string()) { \
-    std::string class_name = es::class_name(get_typename<T>());                                                    \
-                                                                                                                   \
-    _p_CPP_DUMP_DEFINE_EXPORT_OBJECT_COMMON1;                                                                      \
-                                                                                                                   \
-    _p_CPP_DUMP_EXPAND_VA(_p_CPP_DUMP_EXPAND_FOR_EXPORT_OBJECT_GENERIC2, __VA_ARGS__);                             \
-                                                                                                                   \
-    _p_CPP_DUMP_DEFINE_EXPORT_OBJECT_COMMON2;                                                                      \
-  }                                                                                                                \
-                                                                                                                   \
-  } /* namespace _detail */                                                                                        \
-                                                                                                                   \
+#define CPP_DUMP_DEFINE_EXPORT_OBJECT_GENERIC(...)                                                 \
+  namespace cpp_dump {                                                                             \
+                                                                                                   \
+  namespace _detail {                                                                              \
+                                                                                                   \
+  inline namespace _p_CPP_DUMP_ES_NAMESPACE {                                                      \
+                                                                                                   \
+  template <typename T>                                                                            \
+  inline auto export_object_generic(                                                               \
+      const T &value, std::size_t current_depth, const export_command &command, document &doc      \
+  ) -> decltype(                                                                                   \
+      _p_CPP_DUMP_EXPAND_VA(_p_CPP_DUMP_EXPAND_FOR_EXPORT_OBJECT_GENERIC, __VA_ARGS__),            \
+      std::declval<const doc_node &>()                                                             \
+  ) {                                                                                              \
+    auto class_name = es::class_name(get_typename<T>());                                           \
+                                                                                                   \
+    _p_CPP_DUMP_DEFINE_EXPORT_OBJECT_COMMON1;                                                      \
+                                                                                                   \
+    _p_CPP_DUMP_EXPAND_VA(_p_CPP_DUMP_EXPAND_FOR_EXPORT_OBJECT_GENERIC2, __VA_ARGS__);             \
+                                                                                                   \
+    _p_CPP_DUMP_DEFINE_EXPORT_OBJECT_COMMON2;                                                      \
+  }                                                                                                \
+                                                                                                   \
+  } /* namespace _p_CPP_DUMP_ES_NAMESPACE */                                                       \
+                                                                                                   \
+  } /* namespace _detail */                                                                        \
+                                                                                                   \
   }  // namespace cpp_dump
 
 /**
@@ -11,6 +11,7 @@
 #include <string>
 #include <type_traits>
 
+#include "../document/document.hpp"
 #include "../export_command/export_command.hpp"
 #include "../type_check.hpp"
 #include "./export_unsupported.hpp"
@@ -19,16 +20,19 @@ namespace cpp_dump {
 
 namespace _detail {
 
+inline namespace _p_CPP_DUMP_ES_NAMESPACE {
+
 template <typename T>
-inline auto
-export_ostream(const T &value, const std::string &, std::size_t, std::size_t, bool, const export_command &)
-    -> std::enable_if_t<is_ostream<T>, std::string> {
+inline auto export_ostream(const T &value, std::size_t, const export_command &, document &doc)
+    -> std::enable_if_t<is_ostream<T>, const doc_node &> {
   std::ostringstream ss;
   ss << value;
-  std::string output = ss.str();
-  return output.empty() ? export_unsupported() : output;
+  auto output = ss.str();
+  return output.empty() ? export_unsupported(doc) : doc.text(make_temp_string(output));
 }
 
+}  // namespace _p_CPP_DUMP_ES_NAMESPACE
+
 }  // namespace _detail
 
 }  // namespace cpp_dump
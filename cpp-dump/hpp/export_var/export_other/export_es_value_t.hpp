@@ -11,8 +11,10 @@
 #include <string_view>
 #include <vector>
 
+#include "../../document/document.hpp"
 #include "../../escape_sequence.hpp"
 #include "../../export_command/export_command.hpp"
+#include "../../integer_format.hpp"
 #include "../../options.hpp"
 #include "../../utility.hpp"
 #include "../export_object_common.hpp"
@@ -21,150 +23,76 @@ namespace cpp_dump {
 
 namespace _detail {
 
+inline namespace _p_CPP_DUMP_ES_NAMESPACE {
+
 namespace _export_other {
 
-inline std::string _export_es_value_vector(
+inline const doc_node &_export_es_value_vector(
     const std::vector<std::string> &es_vec,
-    const std::string &indent,
-    std::size_t last_line_length,
     std::size_t current_depth,
-    bool fail_on_newline,
-    const export_command &command
+    const export_command &command,
+    document &doc
 ) {
   // In case the container is empty.
   if (es_vec.empty()) {
-    return es::bracket("[ ]", current_depth);
+    return doc.token(doc.tokens().depth(current_depth).empty_square);
   }
   // In case the depth exceeds max_depth.
-  if (current_depth >= options::max_depth) {
-    return es::bracket("[ ", current_depth) + es::op("...") + es::bracket(" ]", current_depth);
+  if (current_depth >= current_options().max_depth) {
+    return doc.token(doc.tokens().depth(current_depth).omitted_square);
   }
 
   // Declare variables.
   auto skip_cont = command.create_skip_container(es_vec);
-  bool shift_indent = options::cont_indent_style == types::cont_indent_style_t::always;
-
-  // Try printing on one line.
-  if (!shift_indent) {
-    std::string output = es::bracket("[ ", current_depth);
-    bool is_first_elem = true;
-    for (const auto &[is_ellipsis, it, index_] : skip_cont) {
-      const std::string &es = *it;
-
-      // Add comma.
-      if (is_first_elem) {
-        is_first_elem = false;
-      } else {
-        output += es::op(", ");
-      }
-
-      // If the `elem` is an ellipsis, skip it.
-      if (is_ellipsis) {
-        output += es::op("...");
-        if (last_line_length + get_length(output) + std::string_view(" ]").size()
-            > options::max_line_width) {
-          shift_indent = true;
-          break;
-        }
-        continue;
-      }
-
-      // Add the index if needed.
-      if (command.show_index()) {
-        output += es::member(std::to_string(index_)) + es::op(": ");
-      }
-
-      // Add the stringified `es`.
-      output += es::apply(es, escape_string(es));
-
-      // If the line length exceeds, stop the iteration.
-      if (last_line_length + get_length(output) + std::string_view(" ]").size()
-          > options::max_line_width) {
-        shift_indent = true;
-        break;
-      }
-    }
-
-    if (!shift_indent) {
-      output += es::bracket(" ]", current_depth);
-      return output;
-    }
-  }
-
-  // Print on multiple lines.
+  bool shift_indent = current_options().cont_indent_style == types::cont_indent_style_t::always;
 
-  if (fail_on_newline) {
-    return "\n";
-  }
-
-  // Declare variables.
-  std::string new_indent = indent + "  ";
-  std::string output = es::bracket("[", current_depth);
-  bool is_first_elem = true;
+  auto &group = doc.bracket_group("[", current_depth, shift_indent);
   for (const auto &[is_ellipsis, it, index_] : skip_cont) {
     const std::string &es = *it;
 
-    // Add comma.
-    if (is_first_elem) {
-      is_first_elem = false;
-    } else {
-      output += es::op(",");
-    }
-
     // If the `elem` is an ellipsis, skip it.
     if (is_ellipsis) {
-      output += "\n" + new_indent + es::op("...");
+      group.add_item({&doc.token(doc.tokens().ellipsis)});
       continue;
     }
 
-    output += "\n" + new_indent;
-
     // Add the index if needed.
     if (command.show_index()) {
-      output += es::member(std::to_string(index_)) + es::op(": ");
+      group.add_item(
+          {&doc.text(concat(es::member(decimal_chars(index_).view()), doc.tokens().colon.str)),
+           &doc.text(es::apply(es, escape_string(es)))}
+      );
+    } else {
+      group.add_item({&doc.text(es::apply(es, escape_string(es)))});
     }
-
-    // Add the stringified `es`.
-    output += es::apply(es, escape_string(es));
   }
-  output += "\n" + indent + es::bracket("]", current_depth);
 
-  return output;
+  return group;
 }
 
-inline std::string export_es_value_t(
+inline const doc_node &export_es_value_t(
     const types::es_value_t &esv,
-    const std::string &indent,
-    std::size_t last_line_length,
     std::size_t current_depth,
-    bool fail_on_newline,
-    const export_command &command
+    const export_command &command,
+    document &doc
 ) {
-  std::string class_name = es::class_name("cpp_dump::types::es_value_t");
+  auto class_name = es::class_name("cpp_dump::types::es_value_t");
 
   _p_CPP_DUMP_DEFINE_EXPORT_OBJECT_COMMON1_1;
 
   auto append_output = [&](std::string_view member_name, const auto &member) -> void {
-    if (is_first) {
-      is_first = false;
-    } else {
-      output += es::op(", ");
-    }
-    if (shift_indent) {
-      output += "\n" + new_indent;
-    }
     if constexpr (std::is_same_v<decltype(member), const std::string &>) {
-      output += es::apply(member, std::string(member_name) + "= " + escape_string(member));
+      group.add_item(
+          {&doc.text(es::apply(member, concat(member_name, "= ", escape_string(member))))}
+      );
     } else {
-      output += es::member(member_name) + es::op("= ");
-      output += _export_es_value_vector(
-          member, new_indent, get_last_line_length(output), next_depth, false, command
+      group.add_item(
+          {&doc.text(concat(es::member(member_name), doc.tokens().equal.str)),
+           &_export_es_value_vector(member, next_depth, command, doc)}
       );
     }
   };
 
-  _p_CPP_DUMP_DEFINE_EXPORT_OBJECT_COMMON1_3;
-
   append_output("log", esv.log);
   append_output("expression", esv.expression);
   append_output("reserved", esv.reserved);
@@ -184,6 +112,8 @@ inline std::string export_es_value_t(
 
 }  // namespace _export_other
 
+}  // namespace _p_CPP_DUMP_ES_NAMESPACE
+
 }  // namespace _detail
 
 }  // namespace cpp_dump
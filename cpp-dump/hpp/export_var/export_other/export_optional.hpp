@@ -12,6 +12,7 @@
 #include <string_view>
 #include <type_traits>
 
+#include "../../document/document.hpp"
 #include "../../escape_sequence.hpp"
 #include "../../export_command/export_command.hpp"
 #include "../../type_check.hpp"
@@ -21,37 +22,38 @@ namespace cpp_dump {
 
 namespace _detail {
 
+inline namespace _p_CPP_DUMP_ES_NAMESPACE {
+
 namespace _export_other {
 
-inline std::string
-export_optional(const std::nullopt_t &, const std::string &, std::size_t, std::size_t, bool, const export_command &) {
-  return es::class_name("std::nullopt");
+inline const doc_node &
+export_optional(const std::nullopt_t &, std::size_t, const export_command &, document &doc) {
+  return doc.text(es::class_name("std::nullopt"));
 }
 
-inline std::string _es_optional_question(std::string_view s) {
-  return options::es_style == types::es_style_t::original ? es::identifier(s) : es::op(s);
+inline temp_string _es_optional_question(std::string_view s) {
+  return current_options().es_style == types::es_style_t::original ? es::identifier(s) : es::op(s);
 }
 
 template <typename T>
 inline auto export_optional(
     const T &optional,
-    const std::string &indent,
-    std::size_t last_line_length,
     std::size_t current_depth,
-    bool fail_on_newline,
-    const export_command &command
-) -> std::enable_if_t<is_optional<T>, std::string> {
+    const export_command &command,
+    document &doc
+) -> std::enable_if_t<is_optional<T>, const doc_node &> {
   if (optional == std::nullopt) {
-    return es::class_name("std::nullopt");
+    return doc.text(es::class_name("std::nullopt"));
   }
-  return _es_optional_question("?")
-         + export_var(
-             optional.value(), indent, last_line_length + 1, current_depth, fail_on_newline, command
-         );
+  return doc.prefix(
+      _es_optional_question("?"), export_var(optional.value(), current_depth, command, doc)
+  );
 }
 
 }  // namespace _export_other
 
+}  // namespace _p_CPP_DUMP_ES_NAMESPACE
+
 }  // namespace _detail
 
 }  // namespace cpp_dump
@@ -13,6 +13,7 @@
 #include <type_traits>
 #include <variant>
 
+#include "../../document/document.hpp"
 #include "../../escape_sequence.hpp"
 #include "../../export_command/export_command.hpp"
 #include "../../options.hpp"
@@ -27,55 +28,48 @@ namespace cpp_dump {
 
 namespace _detail {
 
+inline namespace _p_CPP_DUMP_ES_NAMESPACE {
+
 namespace _export_other {
 
 template <typename T>
 inline auto export_other(
     const T &optional,
-    const std::string &indent,
-    std::size_t last_line_length,
     std::size_t current_depth,
-    bool fail_on_newline,
-    const export_command &command
-) -> std::enable_if_t<is_optional<T>, std::string> {
-  return export_optional(
-      optional, indent, last_line_length, current_depth, fail_on_newline, command
-  );
+    const export_command &command,
+    document &doc
+) -> std::enable_if_t<is_optional<T>, const doc_node &> {
+  return export_optional(optional, current_depth, command, doc);
 }
 
 template <typename T>
 inline auto export_other(
     const T &type_info,
-    const std::string &indent,
-    std::size_t last_line_length,
     std::size_t current_depth,
-    bool fail_on_newline,
-    const export_command &command
-) -> std::enable_if_t<is_type_info<T>, std::string> {
-  return export_type_info(
-      type_info, indent, last_line_length, current_depth, fail_on_newline, command
-  );
+    const export_command &command,
+    document &doc
+) -> std::enable_if_t<is_type_info<T>, const doc_node &> {
+  return export_type_info(type_info, current_depth, command, doc);
 }
 
 template <typename... Args>
-inline std::string export_other(
+inline const doc_node &export_other(
     const std::reference_wrapper<Args...> &ref,
-    const std::string &indent,
-    std::size_t last_line_length,
     std::size_t current_depth,
-    bool fail_on_newline,
-    const export_command &command
+    const export_command &command,
+    document &doc
 ) {
-  return export_var(ref.get(), indent, last_line_length, current_depth, fail_on_newline, command);
+  return export_var(ref.get(), current_depth, command, doc);
 }
 
-inline std::string _es_bitset(std::string_view s) {
-  return options::es_style == types::es_style_t::original ? es::identifier(s) : es::number(s);
+inline temp_string _es_bitset(std::string_view s) {
+  return current_options().es_style == types::es_style_t::original ? es::identifier(s)
+                                                                    : es::number(s);
 }
 
 template <std::size_t N>
-inline std::string
-export_other(const std::bitset<N> &bitset, const std::string &, std::size_t, std::size_t, bool, const export_command &) {
+inline const doc_node &
+export_other(const std::bitset<N> &bitset, std::size_t, const export_command &, document &doc) {
   constexpr unsigned int chunk = 4;
 
   std::string bitset_str = bitset.to_string();
@@ -89,96 +83,87 @@ export_other(const std::bitset<N> &bitset, const std::string &, std::size_t, std
     if (pos > 0) output.push_back(' ');
     output.append(bitset_str, pos, chunk);
   }
-  return _es_bitset(output);
+  return doc.text(_es_bitset(output));
 }
 
-inline std::string _es_complex_complex(std::string_view s) {
-  return options::es_style == types::es_style_t::original ? es::identifier(s)
-                                                          : es::signed_number(s);
+inline temp_string _es_complex_complex(std::string_view s) {
+  return current_options().es_style == types::es_style_t::original ? es::identifier(s)
+                                                                    : es::signed_number(s);
 }
 
 template <typename T>
-inline std::string export_other(
+inline const doc_node &export_other(
     const std::complex<T> &complex,
-    const std::string &,
-    std::size_t,
     std::size_t current_depth,
-    bool,
-    const export_command &command
+    const export_command &command,
+    document &doc
 ) {
   constexpr T pi = static_cast<T>(3.141592653589793238462643383279502884L);
-  auto to_str = [&](T value) -> std::string {
-    std::string output = command.format(value);
+  auto to_str = [&](T value) -> temp_string {
+    auto output = command.format(value);
     if (output.empty()) {
-      return std::to_string(value);
+      return make_temp_string(std::to_string(value));
     }
     return output;
   };
   auto imag = std::imag(complex);
   auto imag_sign = imag >= 0 ? "+" : "-";
 
-  return _es_complex_complex(
-             to_str(std::real(complex)) + " " + imag_sign + " " + to_str(std::abs(imag)) + "i "
-         )
-         + es::bracket("( ", current_depth) + es::member("abs") + es::op("= ")
-         + es::signed_number(to_str(std::abs(complex))) + es::op(", ") + es::class_member("arg/pi")
-         + es::op("= ") + es::signed_number(to_str(std::arg(complex) / pi))
-         + es::bracket(" )", current_depth);
+  return doc.text(
+      _es_complex_complex(
+          to_str(std::real(complex)) + " " + imag_sign + " " + to_str(std::abs(imag)) + "i "
+      )
+      + es::bracket("( ", current_depth) + es::member("abs") + es::op("= ")
+      + es::signed_number(to_str(std::abs(complex))) + es::op(", ") + es::class_member("arg/pi")
+      + es::op("= ") + es::signed_number(to_str(std::arg(complex) / pi))
+      + es::bracket(" )", current_depth)
+  );
 }
 
-inline std::string _es_variant_bar(std::string_view s) {
-  return options::es_style == types::es_style_t::original ? es::identifier(s) : es::op(s);
+inline temp_string _es_variant_bar(std::string_view s) {
+  return current_options().es_style == types::es_style_t::original ? es::identifier(s) : es::op(s);
 }
 
 template <typename... Args>
-inline std::string export_other(
+inline const doc_node &export_other(
     const std::variant<Args...> &variant,
-    const std::string &indent,
-    std::size_t last_line_length,
     std::size_t current_depth,
-    bool fail_on_newline,
-    const export_command &command
+    const export_command &command,
+    document &doc
 ) {
   return std::visit(
-      [=, &indent, &command](const auto &value) -> std::string {
-        return _es_variant_bar("|")
-               + export_var(
-                   value, indent, last_line_length + 1, current_depth, fail_on_newline, command
-               );
+      [&](const auto &value) -> const doc_node & {
+        return doc.prefix(_es_variant_bar("|"), export_var(value, current_depth, command, doc));
       },
       variant
   );
 }
 
-inline std::string export_other(
+inline const doc_node &export_other(
     const types::es_value_t &esv,
-    const std::string &indent,
-    std::size_t last_line_length,
     std::size_t current_depth,
-    bool fail_on_newline,
-    const export_command &command
+    const export_command &command,
+    document &doc
 ) {
-  return export_es_value_t(esv, indent, last_line_length, current_depth, fail_on_newline, command);
+  return export_es_value_t(esv, current_depth, command, doc);
 }
 
 template <typename T>
 inline auto export_other(
     const T &value,
-    const std::string &indent,
-    std::size_t last_line_length,
     std::size_t current_depth,
-    bool fail_on_newline,
-    const export_command &command
-) -> std::enable_if_t<is_other_object<T>, std::string> {
-  return export_other_object(
-      value, indent, last_line_length, current_depth, fail_on_newline, command
-  );
+    const export_command &command,
+    document &doc
+) -> std::enable_if_t<is_other_object<T>, const doc_node &> {
+  return export_other_object(value, current_depth, command, doc);
 }
 
 }  // namespace _export_other
 
 using _export_other::export_other;
 
+}  // namespace _p_CPP_DUMP_ES_NAMESPACE
+
 }  // namespace _detail
 
 }  // namespace cpp_dump
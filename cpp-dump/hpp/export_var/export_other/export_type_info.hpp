@@ -15,6 +15,7 @@
 #include <cxxabi.h>
 #endif
 
+#include "../../document/document.hpp"
 #include "../../export_command/export_command.hpp"
 #include "../export_object_common.hpp"
 
@@ -22,18 +23,18 @@ namespace cpp_dump {
 
 namespace _detail {
 
+inline namespace _p_CPP_DUMP_ES_NAMESPACE {
+
 namespace _export_other {
 
 template <typename T>
 inline auto export_type_info(
     const T &type_info,
-    const std::string &indent,
-    std::size_t last_line_length,
     std::size_t current_depth,
-    bool fail_on_newline,
-    const export_command &command
-) -> std::enable_if_t<is_type_info<T>, std::string> {
-  std::string class_name =
+    const export_command &command,
+    document &doc
+) -> std::enable_if_t<is_type_info<T>, const doc_node &> {
+  auto class_name =
       es::class_name(std::is_same_v<T, std::type_info> ? "std::type_info" : "std::type_index");
 
 #if defined(__GNUC__)
@@ -45,14 +46,12 @@ inline auto export_type_info(
 
   _p_CPP_DUMP_DEFINE_EXPORT_OBJECT_COMMON1;
 
-  if (shift_indent) {
-    output += "\n" + new_indent;
-  }
-
-  output += es::class_member("name()") + es::op("= ");
-  output += es::class_op(R"(")") + es::type_name(name) + es::class_op(R"(")");
-
-  is_first = false;
+  group.add_item(
+      {&doc.text(
+          es::class_member("name()") + es::op("= ") + es::class_op(R"(")") + es::type_name(name)
+          + es::class_op(R"(")")
+      )}
+  );
   append_output("hash_code()", type_info.hash_code());
 
   _p_CPP_DUMP_DEFINE_EXPORT_OBJECT_COMMON2;
@@ -60,6 +59,8 @@ inline auto export_type_info(
 
 }  // namespace _export_other
 
+}  // namespace _p_CPP_DUMP_ES_NAMESPACE
+
 }  // namespace _detail
 
 }  // namespace cpp_dump
@@ -8,12 +8,14 @@
 #pragma once
 
 #include <memory>
-#include <sstream>
 #include <string>
+#include <string_view>
 #include <type_traits>
 
+#include "../document/document.hpp"
 #include "../escape_sequence.hpp"
 #include "../export_command/export_command.hpp"
+#include "../integer_format.hpp"
 #include "../options.hpp"
 #include "../type_check.hpp"
 #include "./export_unsupported.hpp"
@@ -23,82 +25,75 @@ namespace cpp_dump {
 
 namespace _detail {
 
+inline namespace _p_CPP_DUMP_ES_NAMESPACE {
+
 namespace _export_pointer {
 
-inline std::string _es_ptr_asterisk(std::string_view s) {
-  return options::es_style == types::es_style_t::original ? es::identifier(s) : es::op(s);
+inline temp_string _es_ptr_asterisk(std::string_view s) {
+  return current_options().es_style == types::es_style_t::original ? es::identifier(s) : es::op(s);
 }
 
-inline std::string _es_raw_address(std::string_view s) {
-  return options::es_style == types::es_style_t::original ? es::identifier(s) : es::number(s);
+inline temp_string _es_raw_address(std::string_view s) {
+  return current_options().es_style == types::es_style_t::original ? es::identifier(s)
+                                                                    : es::number(s);
 }
 
 template <typename T>
 inline auto export_pointer(
     const T &pointer,
-    [[maybe_unused]] const std::string &indent,
-    [[maybe_unused]] std::size_t last_line_length,
     [[maybe_unused]] std::size_t current_depth,
-    [[maybe_unused]] bool fail_on_newline,
-    [[maybe_unused]] const export_command &command
-) -> std::enable_if_t<is_pointer<T>, std::string> {
+    [[maybe_unused]] const export_command &command,
+    document &doc
+) -> std::enable_if_t<is_pointer<T>, const doc_node &> {
   if (pointer == nullptr) {
-    return es::reserved("nullptr");
+    return doc.token(doc.tokens().nullptr_);
   }
   // If the pointer is not exportable, export the address.
   if constexpr (is_null_pointer<T> || !is_exportable<remove_pointer<T>>) {
     if constexpr (std::is_function_v<remove_pointer<T>>) {
-      return export_unsupported();
+      return export_unsupported(doc);
     } else {
-      std::ostringstream ss;
-      ss << std::hex << static_cast<const void *>(pointer);
-
       // Make the entire string an identifier
-      return _es_raw_address(ss.str());
+      return doc.text(_es_raw_address(address_chars(static_cast<const void *>(pointer)).view()));
     }
   } else {
     // If the depth exceeds addr_depth, export the address.
     if (current_depth >= command.addr_depth()) {
-      std::ostringstream ss;
+      const void *address;
       if constexpr (is_smart_pointer<T>) {
-        ss << std::hex << static_cast<const void *>(pointer.get());
+        address = static_cast<const void *>(pointer.get());
       } else {
-        ss << std::hex << static_cast<const void *>(pointer);
+        address = static_cast<const void *>(pointer);
       }
 
       // Make the entire string an identifier
-      return _es_raw_address(ss.str());
+      return doc.text(_es_raw_address(address_chars(address).view()));
     }
     // In case the depth exceeds `max_depth`.
-    if (current_depth >= options::max_depth) {
-      return _es_ptr_asterisk("*") + es::op("...");
+    if (current_depth >= current_options().max_depth) {
+      return doc.prefix(_es_ptr_asterisk("*"), doc.token(doc.tokens().ellipsis));
     }
     // Export *value.
-    return _es_ptr_asterisk("*")
-           + export_var(
-               *pointer, indent, last_line_length + 1, current_depth + 1, fail_on_newline, command
-           );
+    return doc.prefix(_es_ptr_asterisk("*"), export_var(*pointer, current_depth + 1, command, doc));
   }
 }
 
 template <typename... Args>
-inline std::string export_pointer(
+inline const doc_node &export_pointer(
     const std::weak_ptr<Args...> &wk_ptr,
-    const std::string &indent,
-    std::size_t last_line_length,
     std::size_t current_depth,
-    bool fail_on_newline,
-    const export_command &command
+    const export_command &command,
+    document &doc
 ) {
-  return export_pointer(
-      wk_ptr.lock(), indent, last_line_length, current_depth, fail_on_newline, command
-  );
+  return export_pointer(wk_ptr.lock(), current_depth, command, doc);
 }
 
 }  // namespace _export_pointer
 
 using _export_pointer::export_pointer;
 
+}  // namespace _p_CPP_DUMP_ES_NAMESPACE
+
 }  // namespace _detail
 
 }  // namespace cpp_dump
@@ -10,6 +10,7 @@
 #include <string>
 #include <string_view>
 
+#include "../document/document.hpp"
 #include "../escape_sequence.hpp"
 #include "../export_command/export_command.hpp"
 #include "../type_check.hpp"
@@ -19,37 +20,33 @@ namespace cpp_dump {
 
 namespace _detail {
 
-inline std::string export_string(
-    std::string_view value,
-    const std::string &,
-    std::size_t,
-    std::size_t,
-    bool fail_on_newline,
-    const export_command &command
-) {
+inline namespace _p_CPP_DUMP_ES_NAMESPACE {
+
+inline const doc_node &
+export_string(std::string_view value, std::size_t, const export_command &command, document &doc) {
   // Escape and export if needed.
   if (command.escape_str()) {
-    return es::escaped_str(escape_string(value));
+    return doc.text(es::escaped_str(escape_string(value)));
   }
 
   // str = replace_string(str, R"(\)", R"(\\)");
   // str = replace_string(str, R"(`)", R"(\`)");
 
   // If the value has a line break, wrap the value with `
+  // The node containing a newline can never be printed on one line.
   if (has_newline(value)) {
-    if (fail_on_newline) {
-      return "\n";
-    }
-    return "\n" + es::character(std::string(1, '`').append(value)) + es::character("`");
+    return doc.text("\n" + es::character(concat("`", value)) + es::character("`"));
   }
 
   // Wrap the value with " or '
   if (value.find('"') == std::string::npos) {
-    return es::character(std::string(1, '"').append(value)) + es::character("\"");
+    return doc.text(es::character(concat("\"", value)) + es::character("\""));
   }
-  return es::character(std::string(1, '`').append(value)) + es::character("`");
+  return doc.text(es::character(concat("`", value)) + es::character("`"));
 }
 
+}  // namespace _p_CPP_DUMP_ES_NAMESPACE
+
 }  // namespace _detail
 
 }  // namespace cpp_dump
@@ -10,7 +10,9 @@
 #include <string>
 #include <tuple>
 #include <type_traits>
+#include <utility>
 
+#include "../document/document.hpp"
 #include "../escape_sequence.hpp"
 #include "../export_command/export_command.hpp"
 #include "../iterable.hpp"
@@ -23,6 +25,8 @@ namespace cpp_dump {
 
 namespace _detail {
 
+inline namespace _p_CPP_DUMP_ES_NAMESPACE {
+
 namespace _export_tuple {
 
 template <std::size_t i, typename T>
@@ -35,85 +39,40 @@ inline auto get(const T &tuple, priority_tag_low) -> decltype(get<i>(tuple)) {
   return get<i>(tuple);
 }
 
-template <std::size_t i, std::size_t size, typename T>
-inline auto _export_tuple_in_one_line(
+template <typename T, std::size_t... Is>
+inline void _add_tuple_items(
+    doc_node &group,
     const T &tuple,
-    const std::string &indent,
-    std::size_t last_line_length,
     std::size_t next_depth,
-    const export_command &command
-) -> std::enable_if_t<is_tuple<T>, std::string> {
-  std::string output = export_var(
-      _export_tuple::get<i>(tuple, priority_tag_high{}), indent, last_line_length, next_depth, true, command
-  );
-  if (has_newline(output)) {
-    return "\n";
-  }
-
-  if constexpr (i < size - 1) {
-    return output + es::op(", ")
-           + _export_tuple_in_one_line<i + 1, size>(
-               tuple, indent, get_length(output) + 2, next_depth, command
-           );
-  } else {
-    return output;
-  }
-}
-
-template <std::size_t i, std::size_t size, typename T>
-inline auto _export_tuple_in_lines(
-    const T &tuple, const std::string &indent, std::size_t next_depth, const export_command &command
-) -> std::enable_if_t<is_tuple<T>, std::string> {
-  std::string output = export_var(
-      _export_tuple::get<i>(tuple, priority_tag_high{}), indent, get_length(indent), next_depth, false, command
-  );
-
-  if constexpr (i < size - 1) {
-    return output + es::op(",\n") + indent
-           + _export_tuple_in_lines<i + 1, size>(tuple, indent, next_depth, command);
-  } else {
-    return output;
-  }
+    const export_command &command,
+    document &doc,
+    std::index_sequence<Is...>
+) {
+  (group.add_item(
+       {&export_var(_export_tuple::get<Is>(tuple, priority_tag_high{}), next_depth, command, doc)}
+   ),
+   ...);
 }
 
 template <typename T>
 inline auto export_tuple(
-    const T &tuple,
-    const std::string &indent,
-    std::size_t last_line_length,
-    std::size_t current_depth,
-    bool fail_on_newline,
-    const export_command &command
-) -> std::enable_if_t<is_tuple<T>, std::string> {
+    const T &tuple, std::size_t current_depth, const export_command &command, document &doc
+) -> std::enable_if_t<is_tuple<T>, const doc_node &> {
   constexpr std::size_t tuple_size = std::tuple_size_v<T>;
 
   if constexpr (tuple_size == 0) {
-    return es::bracket("( )", current_depth);
+    return doc.token(doc.tokens().depth(current_depth).empty_paren);
   } else {
-    if (current_depth >= options::max_depth) {
-      return es::bracket("( ", current_depth) + es::op("...") + es::bracket(" )", current_depth);
+    if (current_depth >= current_options().max_depth) {
+      return doc.token(doc.tokens().depth(current_depth).omitted_paren);
     }
 
-    // Try exporting on one line.
-    std::size_t next_depth = current_depth + 1;
-    std::string output = es::bracket("( ", current_depth)
-                         + _export_tuple_in_one_line<0, tuple_size>(
-                             tuple, indent, last_line_length + 2, next_depth, command
-                         )
-                         + es::bracket(" )", current_depth);
-    if (!has_newline(output) && last_line_length + get_length(output) <= options::max_line_width) {
-      return output;
-    }
+    auto &group = doc.tuple_group(current_depth);
+    _add_tuple_items(
+        group, tuple, current_depth + 1, command, doc, std::make_index_sequence<tuple_size>()
+    );
 
-    if (fail_on_newline) {
-      return "\n";
-    }
-
-    // Try exporting on multiple lines.
-    std::string new_indent = indent + "  ";
-    return es::bracket("(\n", current_depth) + new_indent
-           + _export_tuple_in_lines<0, tuple_size>(tuple, new_indent, next_depth, command) + "\n"
-           + indent + es::bracket(")", current_depth);
+    return group;
   }
 }
 
@@ -121,6 +80,8 @@ inline auto export_tuple(
 
 using _export_tuple::export_tuple;
 
+}  // namespace _p_CPP_DUMP_ES_NAMESPACE
+
 }  // namespace _detail
 
 }  // namespace cpp_dump
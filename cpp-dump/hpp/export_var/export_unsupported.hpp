@@ -9,13 +9,20 @@
 
 #include <string>
 
+#include "../document/document.hpp"
 #include "../escape_sequence.hpp"
 
 namespace cpp_dump {
 
 namespace _detail {
 
-inline std::string export_unsupported() { return es::unsupported("Unsupported Type"); }
+inline namespace _p_CPP_DUMP_ES_NAMESPACE {
+
+inline const doc_node &export_unsupported(document &doc) {
+  return doc.text(es::unsupported("Unsupported Type"));
+}
+
+}  // namespace _p_CPP_DUMP_ES_NAMESPACE
 
 }  // namespace _detail
 
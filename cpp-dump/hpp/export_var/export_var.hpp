@@ -9,7 +9,13 @@
 
 #include <string>
 
+#include "../arena.hpp"
+#include "../char_span.hpp"
+#include "../document/document.hpp"
+#include "../document/layout.hpp"
+#include "../document/writer.hpp"
 #include "../export_command/export_command.hpp"
+#include "../options.hpp"
 #include "../type_check.hpp"
 #include "./export_arithmetic.hpp"
 #include "./export_asterisk.hpp"
@@ -33,79 +39,91 @@ namespace cpp_dump {
 
 namespace _detail {
 
+inline namespace _p_CPP_DUMP_ES_NAMESPACE {
+
 // This is the real implementation of export_var().
 // This calls itself recursively.
 template <typename T>
-std::string export_var(
+const doc_node &export_var(
     [[maybe_unused]] const T &value,
-    [[maybe_unused]] const std::string &indent,
-    [[maybe_unused]] std::size_t last_line_length,
     [[maybe_unused]] std::size_t current_depth,
-    [[maybe_unused]] bool fail_on_newline,
-    [[maybe_unused]] const export_command &command
+    [[maybe_unused]] const export_command &command,
+    document &doc
 ) {
   if constexpr (is_value_with_command<T>) {
-    return export_var(
-        value.value, indent, last_line_length, current_depth, fail_on_newline, value.command
-    );
+    return export_var(value.value, current_depth, export_command(value.command), doc);
   } else if constexpr (is_exportable_object<T>) {
-    return export_object(value, indent, last_line_length, current_depth, fail_on_newline, command);
+    return export_object(value, current_depth, command, doc);
   } else if constexpr (is_exportable_enum<T>) {
-    return export_enum(value, indent, last_line_length, current_depth, fail_on_newline, command);
+    return export_enum(value, current_depth, command, doc);
   } else if constexpr (is_arithmetic<T>) {
-    return export_arithmetic(
-        value, indent, last_line_length, current_depth, fail_on_newline, command
-    );
+    return export_arithmetic(value, current_depth, command, doc);
   } else if constexpr (is_string<T>) {
-    return export_string(value, indent, last_line_length, current_depth, fail_on_newline, command);
+    return export_string(value, current_depth, command, doc);
   } else if constexpr (is_map<T>) {
-    return export_map(value, indent, last_line_length, current_depth, fail_on_newline, command);
+    return export_map(value, current_depth, command, doc);
   } else if constexpr (is_set<T>) {
-    return export_set(value, indent, last_line_length, current_depth, fail_on_newline, command);
+    return export_set(value, current_depth, command, doc);
   } else if constexpr (is_container<T>) {
-    return export_container(
-        value, indent, last_line_length, current_depth, fail_on_newline, command
-    );
+    return export_container(value, current_depth, command, doc);
   } else if constexpr (is_tuple<T>) {
-    return export_tuple(value, indent, last_line_length, current_depth, fail_on_newline, command);
+    return export_tuple(value, current_depth, command, doc);
   } else if constexpr (is_xixo<T>) {
-    return export_xixo(value, indent, last_line_length, current_depth, fail_on_newline, command);
+    return export_xixo(value, current_depth, command, doc);
   } else if constexpr (is_pointer<T>) {
-    return export_pointer(value, indent, last_line_length, current_depth, fail_on_newline, command);
+    return export_pointer(value, current_depth, command, doc);
   } else if constexpr (is_exception<T>) {
-    return export_exception(
-        value, indent, last_line_length, current_depth, fail_on_newline, command
-    );
+    return export_exception(value, current_depth, command, doc);
   } else if constexpr (is_other_type<T>) {
-    return export_other(value, indent, last_line_length, current_depth, fail_on_newline, command);
+    return export_other(value, current_depth, command, doc);
   } else if constexpr (is_exportable_object_generic<T>) {
-    return export_object_generic(
-        value, indent, last_line_length, current_depth, fail_on_newline, command
-    );
+    return export_object_generic(value, current_depth, command, doc);
   } else if constexpr (is_exportable_enum_generic<T>) {
-    return export_enum_generic(
-        value, indent, last_line_length, current_depth, fail_on_newline, command
-    );
+    return export_enum_generic(value, current_depth, command, doc);
   } else if constexpr (is_ostream<T>) {
-    return export_ostream(value, indent, last_line_length, current_depth, fail_on_newline, command);
+    return export_ostream(value, current_depth, command, doc);
   } else if constexpr (is_asterisk<T>) {
-    return export_asterisk(
-        value, indent, last_line_length, current_depth, fail_on_newline, command
-    );
+    return export_asterisk(value, current_depth, command, doc);
   } else {
     static_assert(!is_exportable<T>, "is_exportable<T> has a bug! This should not be showed.");
-    return export_unsupported();
+    return export_unsupported(doc);
   }
 }
 
+}  // namespace _p_CPP_DUMP_ES_NAMESPACE
+
 }  // namespace _detail
 
+inline namespace _p_CPP_DUMP_ES_NAMESPACE {
+
+/**
+ * Append a string representation of a variable to `sink`.
+ * Sink is std::string, cpp_dump::char_span, or any type that has
+ * append(const char *, std::size_t).
+ */
+template <typename Sink, typename T>
+void export_to(Sink &sink, const T &value, const types::export_options_t &opts = {}) {
+  _detail::dump_scope scope;
+  _detail::dump_options_scope resolved_options;
+  _detail::document doc;
+  const auto &node =
+      _detail::export_var(value, 0, _detail::export_command::default_command, doc);
+  _detail::render_cache cache;
+  _detail::basic_writer<Sink &> output(sink, opts.last_line_length);
+  auto indent = _detail::make_temp_string(opts.indent, ' ');
+  _detail::layout(node, output, indent, false, cache);
+}
+
 /**
  * Return a string representation of a variable.
  */
 template <typename T>
 std::string export_var(const T &value) {
-  return _detail::export_var(value, "", 0, 0, false, _detail::export_command::default_command);
+  std::string output;
+  export_to(output, value);
+  return output;
 }
 
+}  // namespace _p_CPP_DUMP_ES_NAMESPACE
+
 }  // namespace cpp_dump
@@ -7,17 +7,19 @@
 
 #pragma once
 
-#include <string>
-
+#include "../document/document.hpp"
 #include "../export_command/export_command.hpp"
 
 namespace cpp_dump {
 
 namespace _detail {
 
+inline namespace _p_CPP_DUMP_ES_NAMESPACE {
+
 template <typename T>
-std::string
-export_var(const T &, const std::string &, std::size_t, std::size_t, bool, const export_command &);
+const doc_node &export_var(const T &, std::size_t, const export_command &, document &);
+
+}  // namespace _p_CPP_DUMP_ES_NAMESPACE
 
 }  // namespace _detail
 
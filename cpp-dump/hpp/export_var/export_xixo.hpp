@@ -11,6 +11,7 @@
 #include <stack>
 #include <string>
 
+#include "../document/document.hpp"
 #include "../escape_sequence.hpp"
 #include "../export_command/export_command.hpp"
 #include "./export_object_common.hpp"
@@ -19,16 +20,16 @@ namespace cpp_dump {
 
 namespace _detail {
 
+inline namespace _p_CPP_DUMP_ES_NAMESPACE {
+
 template <typename... Args>
-inline std::string export_xixo(
+inline const doc_node &export_xixo(
     const std::queue<Args...> &queue,
-    const std::string &indent,
-    std::size_t last_line_length,
     std::size_t current_depth,
-    bool fail_on_newline,
-    const export_command &command
+    const export_command &command,
+    document &doc
 ) {
-  std::string class_name = es::class_name("std::queue");
+  auto class_name = es::class_name("std::queue");
 
   _p_CPP_DUMP_DEFINE_EXPORT_OBJECT_COMMON1;
 
@@ -44,15 +45,13 @@ inline std::string export_xixo(
 }
 
 template <typename... Args>
-inline std::string export_xixo(
+inline const doc_node &export_xixo(
     const std::priority_queue<Args...> &pq,
-    const std::string &indent,
-    std::size_t last_line_length,
     std::size_t current_depth,
-    bool fail_on_newline,
-    const export_command &command
+    const export_command &command,
+    document &doc
 ) {
-  std::string class_name = es::class_name("std::priority_queue");
+  auto class_name = es::class_name("std::priority_queue");
 
   _p_CPP_DUMP_DEFINE_EXPORT_OBJECT_COMMON1;
 
@@ -65,15 +64,13 @@ inline std::string export_xixo(
 }
 
 template <typename... Args>
-inline std::string export_xixo(
+inline const doc_node &export_xixo(
     const std::stack<Args...> &stack,
-    const std::string &indent,
-    std::size_t last_line_length,
     std::size_t current_depth,
-    bool fail_on_newline,
-    const export_command &command
+    const export_command &command,
+    document &doc
 ) {
-  std::string class_name = es::class_name("std::stack");
+  auto class_name = es::class_name("std::stack");
 
   _p_CPP_DUMP_DEFINE_EXPORT_OBJECT_COMMON1;
 
@@ -85,6 +82,8 @@ inline std::string export_xixo(
   _p_CPP_DUMP_DEFINE_EXPORT_OBJECT_COMMON2;
 }
 
+}  // namespace _p_CPP_DUMP_ES_NAMESPACE
+
 }  // namespace _detail
 
 }  // namespace cpp_dump
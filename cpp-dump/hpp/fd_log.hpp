@@ -0,0 +1,87 @@
+/*
+ * Copyright (c) 2023 Ryota Sasaki.
+ *
+ * This source code is licensed under the MIT license found in the LICENSE file in the root
+ * directory of this source tree.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <string>
+#include <string_view>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#endif
+
+#include "./async_log.hpp"
+
+namespace cpp_dump {
+
+namespace types {
+
+/**
+ * Type of the options of cpp_dump::start_fd_log().
+ */
+struct fd_log_options_t {
+  // The file descriptor that the logs are written to. The default is the standard error output.
+  int fd = 2;
+  // Whether O_APPEND is set on the file descriptor, so that each log of the processes that share
+  // the file is written at its end. This is ignored on Windows.
+  bool append = false;
+};
+
+}  // namespace types
+
+namespace _detail {
+
+// The file descriptor that write_log() writes to, or -1 when it writes to std::clog.
+inline std::atomic<int> &active_log_fd() {
+  static std::atomic<int> fd{-1};
+  return fd;
+}
+
+/*
+ * Write a log and a line break with one writev(), so that the logs of the threads never
+ * interleave. This neither copies the log nor takes a lock.
+ * writev() is called again only for the rest of a partial write.
+ */
+inline void write_fd_log(int fd, std::string_view output) {
+#if defined(_WIN32)
+  // There is no writev(), so each thread copies the log to its own buffer.
+  thread_local std::string staging;
+  staging.assign(output.data(), output.size());
+  staging.push_back('\n');
+  write_bytes(fd, staging);
+#else
+  static char newline = '\n';
+  iovec iov[] = {{const_cast<char *>(output.data()), output.size()}, {&newline, 1}};
+  write_iovecs(fd, iov, 2);
+#endif
+}
+
+}  // namespace _detail
+
+/**
+ * Make cpp_dump() write the logs to a file descriptor instead of std::clog, with one write() for
+ * each log and without any lock. The file descriptor is not closed by cpp-dump.
+ * This replaces the output of the default cpp_dump::write_log(), not a specialization, and
+ * cpp_dump::start_async_log() takes precedence while it is active.
+ */
+inline void start_fd_log(const types::fd_log_options_t &opts = {}) {
+#if !defined(_WIN32)
+  if (opts.append) {
+    int flags = ::fcntl(opts.fd, F_GETFL);
+    if (flags >= 0) ::fcntl(opts.fd, F_SETFL, flags | O_APPEND);
+  }
+#endif
+  _detail::active_log_fd().store(opts.fd, std::memory_order_release);
+}
+
+/**
+ * Make cpp_dump() write the logs to std::clog again.
+ */
+inline void stop_fd_log() { _detail::active_log_fd().store(-1, std::memory_order_release); }
+
+}  // namespace cpp_dump
@@ -0,0 +1,168 @@
+/*
+ * Copyright (c) 2023 Ryota Sasaki.
+ *
+ * This source code is licensed under the MIT license found in the LICENSE file in the root
+ * directory of this source tree.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <string_view>
+#include <type_traits>
+
+namespace cpp_dump {
+
+namespace _detail {
+
+// helper for _decimal_pairs and _hex_pairs
+template <unsigned int Base>
+constexpr std::array<char, Base * Base * 2> _make_digit_pairs() {
+  constexpr char digits[] = "0123456789ABCDEF";
+  std::array<char, Base * Base * 2> pairs{};
+  for (unsigned int i = 0; i < Base * Base; ++i) {
+    pairs[i * 2] = digits[i / Base];
+    pairs[i * 2 + 1] = digits[i % Base];
+  }
+  return pairs;
+}
+
+// "00", "01", ..., "99"
+inline constexpr auto _decimal_pairs = _make_digit_pairs<10>();
+// "00", "01", ..., "FF"
+inline constexpr auto _hex_pairs = _make_digit_pairs<16>();
+
+/*
+ * A buffer that is filled from the end.
+ * The digits of an integer are produced from the least significant one, so writing them from the
+ * end leaves them in their final order, and the fill, the prefix, and the sign can be prepended
+ * without moving them.
+ */
+template <std::size_t N>
+struct backward_buffer {
+ public:
+  std::size_t size() const { return N - _first; }
+  std::string_view view() const { return {_data + _first, size()}; }
+
+  void push_front(char c) { _data[--_first] = c; }
+
+  void push_front(std::size_t count, char c) {
+    _first -= count;
+    std::fill_n(_data + _first, count, c);
+  }
+
+  void push_front(std::string_view s) {
+    _first -= s.size();
+    std::copy(s.begin(), s.end(), _data + _first);
+  }
+
+  // Prepend the digits of the value with base as the radix. The hex digits are uppercase.
+  template <typename UnsignedT>
+  void push_digits(UnsignedT value, unsigned int base) {
+    static_assert(std::is_unsigned_v<UnsignedT>);
+    switch (base) {
+      case 10: {
+        while (value >= 100) {
+          _push_pair(_decimal_pairs.data(), static_cast<std::size_t>(value % 100));
+          value /= 100;
+        }
+        if (value >= 10) {
+          _push_pair(_decimal_pairs.data(), static_cast<std::size_t>(value));
+        } else {
+          push_front(static_cast<char>('0' + value));
+        }
+        break;
+      }
+      case 16: {
+        while (value >= 0x100) {
+          _push_pair(_hex_pairs.data(), static_cast<std::size_t>(value & 0xff));
+          value = static_cast<UnsignedT>(value >> 8);
+        }
+        if (value >= 0x10) {
+          _push_pair(_hex_pairs.data(), static_cast<std::size_t>(value));
+        } else {
+          push_front(_hex_pairs[static_cast<std::size_t>(value) * 2 + 1]);
+        }
+        break;
+      }
+      default: {
+        // base is 2 or 8.
+        const unsigned int shift = base == 2 ? 1 : 3;
+        const auto mask = static_cast<UnsignedT>(base - 1);
+        do {
+          push_front(static_cast<char>('0' + (value & mask)));
+          value = static_cast<UnsignedT>(value >> shift);
+        } while (value);
+      }
+    }
+  }
+
+  // Prepend s with a space before every chunk of `chunk` characters, counted from the end.
+  // If no_leading_space is true, the space before the first chunk is omitted.
+  void push_chunks(std::string_view s, std::size_t chunk, bool no_leading_space) {
+    for (std::size_t end = s.size(); end > 0;) {
+      std::size_t begin = end > chunk ? end - chunk : 0;
+      push_front(s.substr(begin, end - begin));
+      push_front(' ');
+      end = begin;
+    }
+    if (no_leading_space && size() > 0) {
+      ++_first;
+    }
+  }
+
+ private:
+  char _data[N];
+  std::size_t _first = N;
+
+  void _push_pair(const char *pairs, std::size_t index) {
+    _first -= 2;
+    _data[_first] = pairs[index * 2];
+    _data[_first + 1] = pairs[index * 2 + 1];
+  }
+};
+
+/*
+ * A number formatted by std::to_chars(), which depends on neither the locale nor the heap.
+ */
+template <std::size_t N>
+struct number_chars {
+ public:
+  template <typename T>
+  number_chars(T value, int base, std::string_view prefix) {
+    std::copy(prefix.begin(), prefix.end(), _data);
+    auto result = std::to_chars(_data + prefix.size(), _data + N, value, base);
+    _size = static_cast<std::size_t>(result.ptr - _data);
+  }
+
+  std::string_view view() const { return {_data, _size}; }
+
+ private:
+  char _data[N];
+  std::size_t _size;
+};
+
+// Format an integer in decimal, as std::to_string() does.
+template <typename T>
+inline auto decimal_chars(T value) {
+  // +value promotes the character types, which std::to_chars() does not accept.
+  using PromotedT = decltype(+value);
+  return number_chars<std::numeric_limits<PromotedT>::digits10 + 3>(+value, 10, "");
+}
+
+// Format an address in lowercase hex with 0x, as operator<<(const void *) does in libstdc++ and
+// libc++.
+inline auto address_chars(const void *pointer) {
+  return number_chars<2 + sizeof(std::uintptr_t) * 2>(
+      reinterpret_cast<std::uintptr_t>(pointer), 16, "0x"
+  );
+}
+
+}  // namespace _detail
+
+}  // namespace cpp_dump
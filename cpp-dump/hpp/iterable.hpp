@@ -8,6 +8,7 @@
 #pragma once
 
 #include <iterator>
+#include <type_traits>
 
 namespace cpp_dump {
 
@@ -63,8 +64,10 @@ inline auto _iterable_size(const T &t, priority_tag_high, priority_tag_low) -> d
 }
 
 template <typename T>
-inline auto _iterable_size(const T &t, priority_tag_low, priority_tag_low)
-    -> decltype(std::distance(iterable_begin(t), iterable_end(t))) {
+inline auto _iterable_size(const T &t, priority_tag_low, priority_tag_low) -> decltype(
+    typename std::iterator_traits<decltype(iterable_begin(t))>::difference_type(),
+    std::distance(iterable_begin(t), iterable_end(t))
+) {
   return std::distance(iterable_begin(t), iterable_end(t));
 }
 
@@ -85,8 +88,8 @@ inline std::size_t iterable_size(const T &t) {
 }
 
 template <typename It>
-inline auto _iterator_advance(It &it, std::size_t n, priority_tag_high) 
-    -> decltype(std::advance(it, n), void()) {
+inline auto _iterator_advance(It &it, std::size_t n, priority_tag_high)
+    -> decltype(typename std::iterator_traits<It>::iterator_category(), std::advance(it, n), void()) {
   std::advance(it, n);
 }
 
@@ -100,6 +103,20 @@ inline void iterator_advance(It &it, std::size_t n) {
   _iterator_advance(it, n, priority_tag_high{});
 }
 
+// Whether It can step backward but cannot be advanced in constant time, like the iterators of
+// std::list and std::map.
+template <typename It, typename = void>
+inline constexpr bool is_bidirectional_only_iterator = false;
+
+template <typename It>
+inline constexpr bool is_bidirectional_only_iterator<
+    It,
+    std::void_t<typename std::iterator_traits<It>::iterator_category>> = ([] {
+  using category = typename std::iterator_traits<It>::iterator_category;
+  return std::is_base_of_v<std::bidirectional_iterator_tag, category>
+         && !std::is_base_of_v<std::random_access_iterator_tag, category>;
+})();
+
 }  // namespace _detail
 
 }  // namespace cpp_dump
@@ -0,0 +1,124 @@
+/*
+ * Copyright (c) 2023 Ryota Sasaki.
+ *
+ * This source code is licensed under the MIT license found in the LICENSE file in the root
+ * directory of this source tree.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <iterator>
+#include <type_traits>
+
+#include "./type_check.hpp"
+
+namespace cpp_dump {
+
+namespace _detail {
+
+inline namespace _p_CPP_DUMP_ES_NAMESPACE {
+
+// helper for key_groups
+template <typename T, typename = void>
+inline constexpr bool _is_ordered = false;
+
+template <typename T>
+inline constexpr bool _is_ordered<T, std::void_t<typename T::key_compare>> = true;
+
+/*
+ * The groups of the equal keys of a multimap or multiset.
+ * The equal keys are adjacent in both the ordered and the unordered containers, so the groups are
+ * found by a single forward sweep that compares each element with the first of its group.
+ * In an ordered container, a group longer than sweep_limit is left with upper_bound() instead, so
+ * skipping heavily duplicated keys does not walk every element.
+ * Each group gives its first element, the multiplicity and the range of the elements.
+ */
+template <typename T>
+struct key_groups {
+ public:
+  static constexpr std::size_t sweep_limit = 4;
+
+  explicit key_groups(const T &container) : _container(container) {}
+
+  struct iterator {
+   public:
+    using It = typename T::const_iterator;
+
+    iterator(const T &container, It first) : _container(container), _first(first), _last(first) {
+      _sweep();
+    }
+
+    const auto &operator*() const noexcept { return *_first; }
+    auto operator->() const noexcept { return _first.operator->(); }
+    bool operator!=(const iterator &to) const noexcept { return _first != to._first; }
+    iterator &operator++() {
+      _first = _last;
+      _sweep();
+      return *this;
+    }
+
+    // The multiplicity, counted by the sweep or, after upper_bound(), by walking the group.
+    std::size_t count() const noexcept {
+      return _count != 0 ? _count : static_cast<std::size_t>(std::distance(_first, _last));
+    }
+    It group_begin() const noexcept { return _first; }
+    It group_end() const noexcept { return _last; }
+
+   private:
+    using key_t = typename T::key_type;
+
+    const T &_container;
+    It _first;
+    It _last;
+    std::size_t _count = 0;
+
+    static const auto &_key(const typename T::value_type &elem) noexcept {
+      if constexpr (is_multimap<T>) {
+        return elem.first;
+      } else {
+        return elem;
+      }
+    }
+
+    void _sweep() {
+      auto end = _container.end();
+      _count = 0;
+      if (_last == end) return;
+      const auto &key = _key(*_last);
+      while (true) {
+        ++_last;
+        ++_count;
+        if (_last == end || !_is_same_key(key, _key(*_last))) return;
+        if constexpr (_is_ordered<T>) {
+          if (_count == sweep_limit) {
+            _last = _container.upper_bound(key);
+            _count = 0;
+            return;
+          }
+        }
+      }
+    }
+
+    bool _is_same_key(const key_t &a, const key_t &b) const {
+      if constexpr (_is_ordered<T>) {
+        // The keys are sorted, so a is not greater than b.
+        return !_container.key_comp()(a, b);
+      } else {
+        return _container.key_eq()(a, b);
+      }
+    }
+  };
+
+  iterator begin() const { return iterator(_container, _container.begin()); }
+  iterator end() const { return iterator(_container, _container.end()); }
+
+ private:
+  const T &_container;
+};
+
+}  // namespace _p_CPP_DUMP_ES_NAMESPACE
+
+}  // namespace _detail
+
+}  // namespace cpp_dump
@@ -8,19 +8,101 @@
 #pragma once
 
 #include <algorithm>
+#include <atomic>
+#include <cstddef>
 #include <functional>
 #include <string>
 #include <string_view>
+#include <type_traits>
+#include <utility>
 
 namespace cpp_dump {
 
+namespace _detail {
+
+// helper for types::log_label_func_t
+inline std::size_t next_log_label_func_id() {
+  static std::atomic<std::size_t> last_id{0};
+  return last_id.fetch_add(1, std::memory_order_relaxed) + 1;
+}
+
+}  // namespace _detail
+
+namespace types {
+struct log_label_func_t;
+}  // namespace types
+
+namespace log_label {
+types::log_label_func_t uncached(types::log_label_func_t f);
+}  // namespace log_label
+
 namespace types {
 
 /**
  * Type of cpp_dump::options::log_label_func.
+ * This is a std::function with an id that changes on every assignment.
+ * Each call site of cpp_dump() calls the function once and keeps the label until another
+ * function is assigned or the colors change, so the function should return the same label for the
+ * same arguments. Wrap a function whose label changes between calls, such as one with the time or
+ * the thread, in cpp_dump::log_label::uncached() to make cpp_dump() call it every time.
  */
-using log_label_func_t =
-    std::function<std::string(std::string_view, std::size_t, std::string_view)>;
+struct log_label_func_t
+    : std::function<std::string(std::string_view, std::size_t, std::string_view)> {
+ public:
+  using function_type = std::function<std::string(std::string_view, std::size_t, std::string_view)>;
+
+  log_label_func_t() : _id(_detail::next_log_label_func_id()) {}
+
+  template <
+      typename F,
+      typename = std::enable_if_t<
+          !std::is_same_v<std::decay_t<F>, log_label_func_t>
+          && std::is_constructible_v<function_type, F>>>
+  log_label_func_t(F &&f)
+      : function_type(std::forward<F>(f)), _id(_detail::next_log_label_func_id()) {}
+
+  log_label_func_t(const log_label_func_t &) = default;
+  log_label_func_t(log_label_func_t &&) = default;
+
+  // The casts keep std::function from wrapping other as a callable, which would make an empty
+  // function non-empty.
+  log_label_func_t &operator=(const log_label_func_t &other) {
+    function_type::operator=(static_cast<const function_type &>(other));
+    _id = _detail::next_log_label_func_id();
+    _cached = other._cached;
+    return *this;
+  }
+
+  log_label_func_t &operator=(log_label_func_t &&other) {
+    function_type::operator=(static_cast<function_type &&>(other));
+    _id = _detail::next_log_label_func_id();
+    _cached = other._cached;
+    return *this;
+  }
+
+  template <
+      typename F,
+      typename = std::enable_if_t<
+          !std::is_same_v<std::decay_t<F>, log_label_func_t>
+          && std::is_assignable_v<function_type &, F>>>
+  log_label_func_t &operator=(F &&f) {
+    function_type::operator=(std::forward<F>(f));
+    _id = _detail::next_log_label_func_id();
+    _cached = true;
+    return *this;
+  }
+
+  std::size_t id() const { return _id; }
+
+  // Whether the call sites keep the label. See cpp_dump::log_label::uncached().
+  bool cached() const { return _cached; }
+
+ private:
+  std::size_t _id;
+  bool _cached = true;
+
+  friend log_label_func_t log_label::uncached(log_label_func_t f);
+};
 
 }  // namespace types
 
@@ -33,6 +115,15 @@ inline std::string default_func(std::string_view, std::size_t, std::string_view)
   return "[dump] ";
 }
 
+/**
+ * Function that makes cpp_dump() call f on every call instead of keeping the label of each call
+ * site. Use this for a label that changes between calls, such as one with the time.
+ */
+inline types::log_label_func_t uncached(types::log_label_func_t f) {
+  f._cached = false;
+  return f;
+}
+
 /**
  * Function that create a function to assign to cpp_dump::options::log_label_func.
  * See README for details.
@@ -7,19 +7,36 @@
 
 #pragma once
 
+#include <atomic>
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
 #include "./log_label.hpp"
 
 namespace cpp_dump {
 
 /**
  * Set a value to a variable in cpp_dump::options namespace.
+ * The variables are shared by all threads, so do not set them while another thread is dumping.
+ * Use cpp_dump::options_scope to give a thread its own options.
+ * The dumps notice the change through this macro. They also notice the variables other than es_value
+ * assigned directly, but es_value must be set through this macro.
  */
-#define CPP_DUMP_SET_OPTION(variable, value) cpp_dump::options::variable = (value)
+#define CPP_DUMP_SET_OPTION(variable, value)                                                       \
+  ((void)(cpp_dump::options::variable = (value)), cpp_dump::_detail::bump_options_epoch())
 
 namespace _detail {
 
 struct empty_class {};
 
+// The number of times the variables in cpp_dump::options namespace have been set.
+inline std::atomic<std::size_t> options_epoch = 0;
+
+inline void bump_options_epoch() { options_epoch.fetch_add(1, std::memory_order_release); }
+
 }  // namespace _detail
 
 #define _p_CPP_DUMP_SET_OPTION_GLOBAL_AUX2(variable, value, line)                                  \
@@ -30,7 +47,7 @@ struct empty_class {};
   namespace _dummy_variables_for_set_option_global {                                               \
                                                                                                    \
   [[maybe_unused]] inline auto _dummy_##line =                                                     \
-      (cpp_dump::options::variable = (value), empty_class{});                                      \
+      (CPP_DUMP_SET_OPTION(variable, value), empty_class{});                                      \
                                                                                                    \
   } /* namespace _dummy_variables_for_set_option_global */                                         \
                                                                                                    \
@@ -83,6 +100,42 @@ struct es_value_t {
   std::string number_op{};                                // default
 };
 
+/**
+ * Type of the options of cpp_dump::export_to().
+ */
+struct export_options_t {
+  // The length of the line that the output is appended to.
+  std::size_t last_line_length = 0;
+  // The number of spaces that the lines after the first line start with.
+  std::size_t indent = 0;
+};
+
+/**
+ * What cpp_dump() does when the queue of cpp_dump::start_async_log() is full.
+ * block waits for the background thread, drop_newest drops the new log, and drop_oldest drops the
+ * oldest log in the queue. cpp_dump::async_log_dropped_count() counts the dropped logs.
+ */
+enum class log_overflow_t { block, drop_newest, drop_oldest };
+
+/**
+ * Type of the options of cpp_dump::start_async_log().
+ */
+struct async_log_options_t {
+  // The number of logs that the queue holds, rounded up to a power of two.
+  std::size_t capacity = 4096;
+  log_overflow_t overflow = log_overflow_t::block;
+  // The file descriptor that the logs are written to. The default is the standard error output.
+  int fd = 2;
+  // Whether cpp_dump() copies the arguments and the background thread formats them.
+  // Only numbers, enums, strings and the standard sequence containers of them are copied.
+  // cpp_dump() formats the other arguments itself, and the output is the same either way as long
+  // as the options are not changed while the logs are queued.
+  // The dumps in a cpp_dump::options_scope or with a cpp_dump::dumper always format the
+  // arguments themselves.
+  // The label is made by cpp_dump() either way, so log_label_func is called on the calling thread.
+  bool defer_formatting = false;
+};
+
 }  // namespace types
 
 namespace options {
@@ -151,4 +204,204 @@ inline bool detailed_number_es = false;
 
 }  // namespace options
 
+namespace types {
+
+/**
+ * Type of the options of cpp_dump::options_scope.
+ * The members are the variables of the same names in cpp_dump::options namespace.
+ */
+struct options_snapshot_t {
+ public:
+  /**
+   * Copy the current values of the variables in cpp_dump::options namespace.
+   */
+  options_snapshot_t()
+      : max_line_width(options::max_line_width),
+        max_depth(options::max_depth),
+        max_iteration_count(options::max_iteration_count),
+        cont_indent_style(options::cont_indent_style),
+        enable_asterisk(options::enable_asterisk),
+        print_expr(options::print_expr),
+        log_label_func(options::log_label_func),
+        es_style(options::es_style),
+        es_value(options::es_value),
+        detailed_class_es(options::detailed_class_es),
+        detailed_member_es(options::detailed_member_es),
+        detailed_number_es(options::detailed_number_es) {}
+
+  std::size_t max_line_width;
+  std::size_t max_depth;
+  std::size_t max_iteration_count;
+  cont_indent_style_t cont_indent_style;
+  bool enable_asterisk;
+  bool print_expr;
+  log_label_func_t log_label_func;
+  es_style_t es_style;
+  es_value_t es_value;
+  bool detailed_class_es;
+  bool detailed_member_es;
+  bool detailed_number_es;
+};
+
+}  // namespace types
+
+namespace _detail {
+
+// The options installed by the innermost options_scope of this thread, or nullptr.
+inline thread_local const types::options_snapshot_t *scoped_options = nullptr;
+
+// The options of the dump running on this thread, or nullptr.
+inline thread_local const types::options_snapshot_t *dump_options = nullptr;
+
+// helper for token_table::_is_up_to_date()
+inline bool _is_equal(const types::es_value_t &a, const types::es_value_t &b) {
+  return a.log == b.log && a.expression == b.expression && a.reserved == b.reserved
+         && a.number == b.number && a.character == b.character
+         && a.escaped_char == b.escaped_char && a.op == b.op && a.identifier == b.identifier
+         && a.member == b.member && a.unsupported == b.unsupported
+         && a.bracket_by_depth == b.bracket_by_depth && a.class_op == b.class_op
+         && a.member_op == b.member_op && a.number_op == b.number_op;
+}
+
+// helper for global_options()
+// The variables in cpp_dump::options namespace except es_value, which are compared on every dump
+// so that the dumps notice them assigned without CPP_DUMP_SET_OPTION().
+struct _scalar_options {
+ public:
+  std::size_t max_line_width;
+  std::size_t max_depth;
+  std::size_t max_iteration_count;
+  types::cont_indent_style_t cont_indent_style;
+  bool enable_asterisk;
+  bool print_expr;
+  std::size_t log_label_func_id;
+  types::es_style_t es_style;
+  bool detailed_class_es;
+  bool detailed_member_es;
+  bool detailed_number_es;
+
+  static _scalar_options current() {
+    return {
+        options::max_line_width,
+        options::max_depth,
+        options::max_iteration_count,
+        options::cont_indent_style,
+        options::enable_asterisk,
+        options::print_expr,
+        options::log_label_func.id(),
+        options::es_style,
+        options::detailed_class_es,
+        options::detailed_member_es,
+        options::detailed_number_es,
+    };
+  }
+
+  bool operator==(const _scalar_options &o) const {
+    return max_line_width == o.max_line_width && max_depth == o.max_depth
+           && max_iteration_count == o.max_iteration_count
+           && cont_indent_style == o.cont_indent_style && enable_asterisk == o.enable_asterisk
+           && print_expr == o.print_expr && log_label_func_id == o.log_label_func_id
+           && es_style == o.es_style && detailed_class_es == o.detailed_class_es
+           && detailed_member_es == o.detailed_member_es
+           && detailed_number_es == o.detailed_number_es;
+  }
+};
+
+// helper for global_options()
+// Each thread has its own copy so that copying never races with another dump.
+struct _global_snapshot_t {
+ public:
+  std::optional<types::options_snapshot_t> options;
+  // The options_epoch and the scalar options when the options were copied.
+  std::size_t epoch = 0;
+  std::optional<_scalar_options> scalars;
+  // The number of times the options have been copied on this thread.
+  std::size_t generation = 0;
+};
+
+inline _global_snapshot_t &_global_snapshot() {
+  thread_local _global_snapshot_t snapshot;
+  return snapshot;
+}
+
+// Return a snapshot of the variables in cpp_dump::options namespace, copying them again if they
+// have been set since the last call on this thread.
+inline const types::options_snapshot_t &global_options() {
+  auto &snapshot = _global_snapshot();
+  auto epoch = options_epoch.load(std::memory_order_acquire);
+  auto scalars = _scalar_options::current();
+  if (!snapshot.options || snapshot.epoch != epoch || !(*snapshot.scalars == scalars)) {
+    // Assigning would give log_label_func a new id, so construct it again.
+    snapshot.options.emplace();
+    snapshot.epoch = epoch;
+    snapshot.scalars = scalars;
+    ++snapshot.generation;
+  }
+  return *snapshot.options;
+}
+
+// The generation of the snapshot returned by global_options() on this thread. The caches built
+// for the global options are valid while this is unchanged.
+inline std::size_t global_options_generation() { return _global_snapshot().generation; }
+
+// Whether o is the snapshot returned by global_options() on this thread.
+inline bool is_global_options(const types::options_snapshot_t &o) {
+  const auto &snapshot = _global_snapshot();
+  return snapshot.options && &o == &*snapshot.options;
+}
+
+// Return the options that apply to this thread now.
+// Within a dump, these are the options resolved when the outermost dump started.
+inline const types::options_snapshot_t &current_options() {
+  if (dump_options) return *dump_options;
+  if (scoped_options) return *scoped_options;
+  return global_options();
+}
+
+// Whether the dump running on this thread uses the variables in cpp_dump::options namespace
+// rather than the options of an options_scope or a dumper.
+inline bool dump_uses_global_options() {
+  return dump_options && is_global_options(*dump_options);
+}
+
+/*
+ * RAII guard that resolves the options once at the start of a dump, so that the dump never reads
+ * the variables in cpp_dump::options namespace while it renders.
+ * Guards may nest, and the nested dumps use the options of the outermost one.
+ */
+struct dump_options_scope {
+ public:
+  dump_options_scope() : _outer(dump_options) {
+    if (!_outer) dump_options = scoped_options ? scoped_options : &global_options();
+  }
+  ~dump_options_scope() { dump_options = _outer; }
+  dump_options_scope(const dump_options_scope &) = delete;
+  dump_options_scope &operator=(const dump_options_scope &) = delete;
+
+ private:
+  const types::options_snapshot_t *_outer;
+};
+
+}  // namespace _detail
+
+/**
+ * RAII guard that makes cpp_dump() and cpp_dump::export_var() on the current thread use `snapshot`
+ * instead of the variables in cpp_dump::options namespace until it is destroyed.
+ * Guards may nest, and must be destroyed in the reverse order of their construction.
+ */
+struct options_scope {
+ public:
+  explicit options_scope(types::options_snapshot_t snapshot)
+      : _snapshot(std::move(snapshot)), _outer(_detail::scoped_options) {
+    _detail::scoped_options = &_snapshot;
+  }
+  ~options_scope() { _detail::scoped_options = _outer; }
+  options_scope(const options_scope &) = delete;
+  options_scope &operator=(const options_scope &) = delete;
+
+ private:
+  const types::options_snapshot_t _snapshot;
+  const types::options_snapshot_t *_outer;
+};
+
 }  // namespace cpp_dump
@@ -0,0 +1,195 @@
+/*
+ * Copyright (c) 2023 Ryota Sasaki.
+ *
+ * This source code is licensed under the MIT license found in the LICENSE file in the root
+ * directory of this source tree.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <thread>
+
+namespace cpp_dump {
+
+namespace _detail {
+
+/*
+ * The policies of cpp_dump_sampled().
+ * cpp_dump_sampled() keeps one of them in a static variable of the call site and calls
+ * sample(suppressed) on every call.
+ * sample() returns whether the call is printed, and if it is, sets suppressed to the number of the
+ * calls skipped since the last printed one.
+ * The constructors are constexpr so that the static variable is initialized at compile time.
+ */
+
+// helper for the samplers
+// The number of the skipped calls. A skip counts with a relaxed load and store rather than a
+// read-modify-write, so the skips that race may be counted once. A printed call takes the count
+// since the count that the last printed call took.
+struct skip_counter {
+ public:
+  void skip() {
+    _skipped.store(_skipped.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+  }
+
+  std::size_t take() {
+    auto total = _skipped.load(std::memory_order_relaxed);
+    auto taken = _taken.load(std::memory_order_relaxed);
+    while (taken < total
+           && !_taken.compare_exchange_weak(taken, total, std::memory_order_relaxed)) {
+    }
+    return taken < total ? total - taken : 0;
+  }
+
+ private:
+  std::atomic<std::size_t> _skipped{0};
+  std::atomic<std::size_t> _taken{0};
+};
+
+struct first_sampler {
+ public:
+  constexpr explicit first_sampler(std::size_t n) : _n(n) {}
+
+  bool sample(std::size_t &) {
+    // After the first n calls, this is the only work of a call.
+    if (_calls.load(std::memory_order_relaxed) >= _n) return false;
+    return _calls.fetch_add(1, std::memory_order_relaxed) < _n;
+  }
+
+ private:
+  std::size_t _n;
+  std::atomic<std::size_t> _calls{0};
+};
+
+struct every_sampler {
+ public:
+  constexpr explicit every_sampler(std::size_t n) : _n(n > 0 ? n : 1) {}
+
+  // The count decides which calls are printed, so every call increments it.
+  bool sample(std::size_t &suppressed) {
+    auto call = _calls.fetch_add(1, std::memory_order_relaxed);
+    if (call % _n != 0) return false;
+    suppressed = call == 0 ? 0 : _n - 1;
+    return true;
+  }
+
+ private:
+  std::size_t _n;
+  std::atomic<std::size_t> _calls{0};
+};
+
+// A token bucket in the form of GCRA: a call is printed if the bucket of the last second is not
+// full, which allows a burst of k calls and k calls per second on average.
+// If k is 0, no call is printed.
+struct per_second_sampler {
+ public:
+  constexpr explicit per_second_sampler(std::size_t k)
+      : _interval(k > 0 ? static_cast<std::int64_t>(1'000'000'000 / k) : never),
+        _tolerance(k > 0 ? 1'000'000'000 - _interval : 0) {}
+
+  bool sample(std::size_t &suppressed) {
+    if (_interval == never) return false;
+    auto since_epoch = std::chrono::steady_clock::now().time_since_epoch();
+    auto now = std::chrono::duration_cast<std::chrono::nanoseconds>(since_epoch).count();
+    // A skipped call only loads _tat. The CAS is tried only while the call may be printed.
+    auto tat = _tat.load(std::memory_order_relaxed);
+    while (now >= tat - _tolerance) {
+      if (_tat.compare_exchange_weak(
+              tat, (now > tat ? now : tat) + _interval, std::memory_order_relaxed
+          )) {
+        suppressed = _suppressed.take();
+        return true;
+      }
+    }
+    _suppressed.skip();
+    return false;
+  }
+
+ private:
+  static constexpr std::int64_t never = -1;
+
+  std::int64_t _interval;
+  std::int64_t _tolerance;
+  // The theoretical arrival time of the next call in nanoseconds of std::chrono::steady_clock.
+  std::atomic<std::int64_t> _tat{std::numeric_limits<std::int64_t>::min() / 2};
+  skip_counter _suppressed;
+};
+
+// helper for probability_sampler
+// xorshift64* with a state per thread.
+inline std::uint64_t sampling_random() {
+  thread_local std::uint64_t state =
+      (std::hash<std::thread::id>()(std::this_thread::get_id())
+       ^ static_cast<std::uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count()))
+      | 1;
+  state ^= state >> 12;
+  state ^= state << 25;
+  state ^= state >> 27;
+  return state * 0x2545F4914F6CDD1DULL;
+}
+
+struct probability_sampler {
+ public:
+  // The upper 53 bits of a random number are compared with p * 2^53.
+  constexpr explicit probability_sampler(double p)
+      : _threshold(
+            p <= 0   ? 0
+            : p >= 1 ? std::uint64_t{1} << 53
+                     : static_cast<std::uint64_t>(p * 9007199254740992.0)
+        ) {}
+
+  bool sample(std::size_t &suppressed) {
+    if ((sampling_random() >> 11) >= _threshold) {
+      _suppressed.skip();
+      return false;
+    }
+    suppressed = _suppressed.take();
+    return true;
+  }
+
+ private:
+  std::uint64_t _threshold;
+  skip_counter _suppressed;
+};
+
+}  // namespace _detail
+
+/**
+ * The policies of cpp_dump_sampled().
+ * Any other type with a member function bool sample(std::size_t &suppressed) can be a policy.
+ */
+namespace sampling {
+
+/**
+ * Print the first n calls of the call site.
+ */
+constexpr _detail::first_sampler first(std::size_t n) { return _detail::first_sampler(n); }
+
+/**
+ * Print the 1st, (n+1)th, (2n+1)th, ... calls of the call site.
+ */
+constexpr _detail::every_sampler every(std::size_t n) { return _detail::every_sampler(n); }
+
+/**
+ * Print at most k calls of the call site per second, or none if k is 0.
+ */
+constexpr _detail::per_second_sampler per_second(std::size_t k) {
+  return _detail::per_second_sampler(k);
+}
+
+/**
+ * Print each call of the call site with the probability p.
+ */
+constexpr _detail::probability_sampler probability(double p) {
+  return _detail::probability_sampler(p);
+}
+
+}  // namespace sampling
+
+}  // namespace cpp_dump
@@ -0,0 +1,297 @@
+/*
+ * Copyright (c) 2023 Ryota Sasaki.
+ *
+ * This source code is licensed under the MIT license found in the LICENSE file in the root
+ * directory of this source tree.
+ */
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+// Define CPP_DUMP_DISABLE_SIMD to use only the scalar kernels.
+#if !defined(CPP_DUMP_DISABLE_SIMD)                                                                \
+    && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define _p_CPP_DUMP_SSE2
+#include <emmintrin.h>
+#if defined(__GNUC__) || defined(__clang__)
+// The AVX2 kernels are compiled for AVX2 regardless of the flags and chosen at runtime.
+#define _p_CPP_DUMP_AVX2
+#define _p_CPP_DUMP_TARGET_AVX2 __attribute__((target("avx2")))
+#include <immintrin.h>
+#elif defined(__AVX2__)
+#define _p_CPP_DUMP_AVX2
+#define _p_CPP_DUMP_TARGET_AVX2
+#include <immintrin.h>
+#endif
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+#endif
+
+namespace cpp_dump {
+
+namespace _detail {
+
+/*
+ * What a byte is for the text kernels.
+ * needs_escape: escape_string() escapes the byte (not printable in the C locale, " or \).
+ * newline_or_es: the byte is \n or the ESC that starts an escape sequence.
+ * escaped: the escaped form of the byte in a string literal, if it needs escaping.
+ */
+struct byte_info {
+ public:
+  bool needs_escape;
+  bool newline_or_es;
+  char escaped[4];
+  unsigned char escaped_size;
+
+  constexpr std::string_view escaped_view() const { return {escaped, escaped_size}; }
+};
+
+// helper for _byte_table
+constexpr byte_info _make_byte_info(unsigned char c) {
+  byte_info info{false, c == '\n' || c == '\x1b', {'\0', '\0', '\0', '\0'}, 0};
+  char simple = '\0';
+  switch (c) {
+    case '\0':
+      simple = '0';
+      break;
+    case '\a':
+      simple = 'a';
+      break;
+    case '\b':
+      simple = 'b';
+      break;
+    case '\f':
+      simple = 'f';
+      break;
+    case '\n':
+      simple = 'n';
+      break;
+    case '\r':
+      simple = 'r';
+      break;
+    case '\t':
+      simple = 't';
+      break;
+    case '\v':
+      simple = 'v';
+      break;
+    case '"':
+      simple = '"';
+      break;
+    case '\\':
+      simple = '\\';
+      break;
+    default:
+      break;
+  }
+  if (simple != '\0') {
+    info.needs_escape = true;
+    info.escaped[0] = '\\';
+    info.escaped[1] = simple;
+    info.escaped_size = 2;
+  } else if (c < 0x20 || c >= 0x7f) {
+    constexpr char hex[] = "0123456789ABCDEF";
+    info.needs_escape = true;
+    info.escaped[0] = '\\';
+    info.escaped[1] = 'x';
+    info.escaped[2] = hex[c >> 4];
+    info.escaped[3] = hex[c & 0x0f];
+    info.escaped_size = 4;
+  }
+  return info;
+}
+
+// helper for _byte_table
+constexpr std::array<byte_info, 256> _make_byte_table() {
+  std::array<byte_info, 256> table{};
+  for (unsigned int c = 0; c < 256; ++c) {
+    table[c] = _make_byte_info(static_cast<unsigned char>(c));
+  }
+  return table;
+}
+
+inline constexpr std::array<byte_info, 256> _byte_table = _make_byte_table();
+
+inline const byte_info &get_byte_info(char c) { return _byte_table[static_cast<unsigned char>(c)]; }
+
+// The kinds of bytes the kernels search for.
+enum class byte_class { needs_escape, newline_or_es };
+
+template <byte_class Class>
+inline const char *_find_scalar(const char *first, const char *last) {
+  for (; first != last; ++first) {
+    const auto &info = get_byte_info(*first);
+    if (Class == byte_class::needs_escape ? info.needs_escape : info.newline_or_es) {
+      return first;
+    }
+  }
+  return last;
+}
+
+#if defined(_p_CPP_DUMP_SSE2)
+
+inline unsigned int _count_trailing_zeros(std::uint32_t mask) {
+#if defined(_MSC_VER) && !defined(__clang__)
+  unsigned long index;
+  _BitScanForward(&index, mask);
+  return static_cast<unsigned int>(index);
+#else
+  return static_cast<unsigned int>(__builtin_ctz(mask));
+#endif
+}
+
+// helper for _find_sse2()
+template <byte_class Class>
+inline std::uint32_t _mask_sse2(__m128i x) {
+  __m128i m;
+  if constexpr (Class == byte_class::needs_escape) {
+    // Signed comparison: the bytes below 0x20 and the bytes from 0x80 are both "less than 0x20".
+    m = _mm_or_si128(
+        _mm_cmplt_epi8(x, _mm_set1_epi8(0x20)), _mm_cmpeq_epi8(x, _mm_set1_epi8(0x7f))
+    );
+    m = _mm_or_si128(m, _mm_cmpeq_epi8(x, _mm_set1_epi8('"')));
+    m = _mm_or_si128(m, _mm_cmpeq_epi8(x, _mm_set1_epi8('\\')));
+  } else {
+    m = _mm_or_si128(
+        _mm_cmpeq_epi8(x, _mm_set1_epi8('\n')), _mm_cmpeq_epi8(x, _mm_set1_epi8('\x1b'))
+    );
+  }
+  return static_cast<std::uint32_t>(_mm_movemask_epi8(m));
+}
+
+template <byte_class Class>
+inline const char *_find_sse2(const char *first, const char *last) {
+  for (; last - first >= 16; first += 16) {
+    auto mask = _mask_sse2<Class>(_mm_loadu_si128(reinterpret_cast<const __m128i *>(first)));
+    if (mask != 0) {
+      return first + _count_trailing_zeros(mask);
+    }
+  }
+  return _find_scalar<Class>(first, last);
+}
+
+#endif
+
+#if defined(_p_CPP_DUMP_AVX2)
+
+// helper for _find_avx2()
+template <byte_class Class>
+_p_CPP_DUMP_TARGET_AVX2 inline std::uint32_t _mask_avx2(__m256i x) {
+  __m256i m;
+  if constexpr (Class == byte_class::needs_escape) {
+    m = _mm256_or_si256(
+        _mm256_cmpgt_epi8(_mm256_set1_epi8(0x20), x), _mm256_cmpeq_epi8(x, _mm256_set1_epi8(0x7f))
+    );
+    m = _mm256_or_si256(m, _mm256_cmpeq_epi8(x, _mm256_set1_epi8('"')));
+    m = _mm256_or_si256(m, _mm256_cmpeq_epi8(x, _mm256_set1_epi8('\\')));
+  } else {
+    m = _mm256_or_si256(
+        _mm256_cmpeq_epi8(x, _mm256_set1_epi8('\n')), _mm256_cmpeq_epi8(x, _mm256_set1_epi8('\x1b'))
+    );
+  }
+  return static_cast<std::uint32_t>(_mm256_movemask_epi8(m));
+}
+
+template <byte_class Class>
+_p_CPP_DUMP_TARGET_AVX2 inline const char *_find_avx2(const char *first, const char *last) {
+  for (; last - first >= 32; first += 32) {
+    auto mask = _mask_avx2<Class>(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(first)));
+    if (mask != 0) {
+      return first + _count_trailing_zeros(mask);
+    }
+  }
+  return _find_sse2<Class>(first, last);
+}
+
+#endif
+
+/*
+ * The kernels that search a text for a class of bytes.
+ * get() returns the fastest set that the CPU supports, which is chosen once at runtime.
+ */
+struct text_kernels {
+ public:
+  using find_func = const char *(*)(const char *, const char *);
+
+  const char *name;
+  find_func find_needs_escape;
+  find_func find_newline_or_es;
+
+  static const text_kernels &get() {
+    static const text_kernels kernels = _select();
+    return kernels;
+  }
+
+  static text_kernels scalar() {
+    return {
+        "scalar",
+        _find_scalar<byte_class::needs_escape>,
+        _find_scalar<byte_class::newline_or_es>
+    };
+  }
+
+#if defined(_p_CPP_DUMP_SSE2)
+  static text_kernels sse2() {
+    return {
+        "sse2", _find_sse2<byte_class::needs_escape>, _find_sse2<byte_class::newline_or_es>
+    };
+  }
+#endif
+
+#if defined(_p_CPP_DUMP_AVX2)
+  static bool avx2_supported() {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_cpu_supports("avx2");
+#else
+    return true;
+#endif
+  }
+
+  static text_kernels avx2() {
+    return {
+        "avx2", _find_avx2<byte_class::needs_escape>, _find_avx2<byte_class::newline_or_es>
+    };
+  }
+#endif
+
+ private:
+  static text_kernels _select() {
+#if defined(_p_CPP_DUMP_AVX2)
+    if (avx2_supported()) {
+      return avx2();
+    }
+#endif
+#if defined(_p_CPP_DUMP_SSE2)
+    return sse2();
+#else
+    return scalar();
+#endif
+  }
+};
+
+// Return the first byte in [first, last) that escape_string() escapes, or last.
+inline const char *find_needs_escape(const char *first, const char *last) {
+  // A vector is no faster for the short strings most dumps consist of.
+  if (last - first < 16) {
+    return _find_scalar<byte_class::needs_escape>(first, last);
+  }
+  return text_kernels::get().find_needs_escape(first, last);
+}
+
+// Return the first \n or ESC in [first, last), or last.
+inline const char *find_newline_or_es(const char *first, const char *last) {
+  if (last - first < 16) {
+    return _find_scalar<byte_class::newline_or_es>(first, last);
+  }
+  return text_kernels::get().find_newline_or_es(first, last);
+}
+
+}  // namespace _detail
+
+}  // namespace cpp_dump
@@ -36,6 +36,8 @@ namespace cpp_dump {
 
 namespace _detail {
 
+inline namespace _p_CPP_DUMP_ES_NAMESPACE {
+
 template <typename T>
 using remove_cvref = std::remove_cv_t<std::remove_reference_t<T>>;
 
@@ -269,6 +271,7 @@ inline constexpr bool is_exportable_enum = _is_exportable_enum<remove_cvref<T>>;
 
 // User-defined2 ----------------------------------------------------------------------------------
 struct export_command;
+struct document;
 
 template <typename T>
 struct _is_exportable_object_generic {
@@ -277,7 +280,9 @@ struct _is_exportable_object_generic {
 
   template <typename RawT>
   static auto check(priority_tag_high) -> decltype(
-    export_object_generic(std::declval<RawT>(), "", 0, 0, false, std::declval<export_command>()),
+    export_object_generic(
+        std::declval<RawT>(), 0, std::declval<const export_command &>(), std::declval<document &>()
+    ),
     std::true_type()
     //
   );
@@ -299,7 +304,9 @@ struct _is_exportable_enum_generic {
 
   template <typename RawT>
   static auto check(priority_tag_high) -> decltype(
-    export_enum_generic(std::declval<RawT>(), "", 0, 0, false, std::declval<export_command>()),
+    export_enum_generic(
+        std::declval<RawT>(), 0, std::declval<const export_command &>(), std::declval<document &>()
+    ),
     std::true_type()
     //
   );
@@ -383,15 +390,27 @@ template <typename T>
 std::string get_typename() {
 #if defined(__GNUC__) && !defined(__clang__)
   constexpr std::size_t prefix_length =
-      std::string_view("const char* cpp_dump::_detail::_get_typename() [with T = ").size();
+      std::string_view(
+          "const char* cpp_dump::_detail::" _p_CPP_DUMP_ES_NAMESPACE_NAME
+          "::_get_typename() [with T = "
+      )
+          .size();
   constexpr std::size_t suffix_length = std::string_view("]").size();
 #elif defined(__clang__)
   constexpr std::size_t prefix_length =
-      std::string_view("const char *cpp_dump::_detail::_get_typename() [T = ").size();
+      std::string_view(
+          "const char *cpp_dump::_detail::" _p_CPP_DUMP_ES_NAMESPACE_NAME
+          "::_get_typename() [T = "
+      )
+          .size();
   constexpr std::size_t suffix_length = std::string_view("]").size();
 #elif defined(_MSC_VER)
   constexpr std::size_t prefix_length =
-      std::string_view("const char *__cdecl cpp_dump::_detail::_get_typename<").size();
+      std::string_view(
+          "const char *__cdecl cpp_dump::_detail::" _p_CPP_DUMP_ES_NAMESPACE_NAME
+          "::_get_typename<"
+      )
+          .size();
   constexpr std::size_t suffix_length = std::string_view(">(void)").size();
 #else
   constexpr std::size_t prefix_length = 0;
@@ -410,6 +429,8 @@ std::string get_typename() {
   return type_name;
 }
 
+}  // namespace _p_CPP_DUMP_ES_NAMESPACE
+
 }  // namespace _detail
 
 }  // namespace cpp_dump
@@ -9,16 +9,20 @@
 
 #include <algorithm>
 #include <cctype>
-#include <map>
+#include <cstring>
 #include <string>
 #include <string_view>
 
+#include "./arena.hpp"
 #include "./escape_sequence.hpp"
+#include "./text_kernels.hpp"
 
 namespace cpp_dump {
 
 namespace _detail {
 
+inline namespace _p_CPP_DUMP_ES_NAMESPACE {
+
 inline bool has_newline(std::string_view s) { return s.find('\n') != std::string::npos; }
 
 inline std::size_t get_length(std::string_view s) {
@@ -47,6 +51,72 @@ inline std::size_t get_length(std::string_view s) {
   return length;
 }
 
+/*
+ * The visible lengths of a text, measured in one pass.
+ * They are equal to has_newline(), get_first_line_length(), and get_last_line_length().
+ */
+struct text_metrics {
+ public:
+  bool has_newline;
+  std::size_t first_line_length;
+  std::size_t last_line_length;
+};
+
+inline text_metrics measure_text(std::string_view s) {
+  const bool es = use_es();
+  text_metrics metrics{false, 0, 0};
+  std::size_t line_length = 0;
+  const char *first = s.data();
+  const char *last = s.data() + s.size();
+  auto end_line = [&] {
+    if (!metrics.has_newline) {
+      metrics.has_newline = true;
+      metrics.first_line_length = line_length;
+    }
+    line_length = 0;
+  };
+
+  while (first != last) {
+    const char *found = es ? find_newline_or_es(first, last)
+                           : static_cast<const char *>(std::memchr(first, '\n', last - first));
+    if (found == nullptr) {
+      found = last;
+    }
+    line_length += found - first;
+    if (found == last) {
+      break;
+    }
+    first = found + 1;
+    if (*found == '\n') {
+      end_line();
+      continue;
+    }
+
+    // An escape sequence is \x1b[, digits and semicolons, and one more character in the same line.
+    if (first == last || *first != '[') {
+      ++line_length;
+      continue;
+    }
+    const char *digits = ++first;
+    while (first != last && (std::isdigit(static_cast<unsigned char>(*first)) || *first == ';')) {
+      ++first;
+    }
+    if (first == last || *first == '\n') {
+      // The sequence is not terminated in this line, so the digits are visible.
+      line_length += first - digits;
+    } else {
+      ++first;
+    }
+  }
+
+  if (metrics.has_newline) {
+    metrics.last_line_length = line_length;
+  } else {
+    metrics.first_line_length = metrics.last_line_length = line_length;
+  }
+  return metrics;
+}
+
 inline std::size_t get_first_line_length(std::string_view s) {
   auto lf_pos = s.find('\n');
   if (lf_pos == std::string::npos) {
@@ -80,58 +150,30 @@ inline std::string replace_string(
   return retval;
 }
 
-inline std::string escape_non_printable_char(char c) {
-  static const std::map<char, std::string_view> char_to_escaped{
-      {'\0', "\\0"},  // null
-      {'\a', "\\a"},  // bell
-      {'\b', "\\b"},  // backspace
-      {'\f', "\\f"},  // form feed
-      {'\n', "\\n"},  // LF
-      {'\r', "\\r"},  // CR
-      {'\t', "\\t"},  // Horizontal tab
-      {'\v', "\\v"},  // Vertical tab
-  };
-
-  if (char_to_escaped.count(c)) {
-    return std::string(char_to_escaped.at(c));
-  }
-
-  auto to_hex_char = [](unsigned char uc) -> char {
-    return static_cast<char>(uc < 10 ? '0' + uc : 'A' + (uc - 10));
-  };
-  char upper = to_hex_char((c >> 4) & 0x0f);
-  char lower = to_hex_char(c & 0x0f);
-  return std::string({'\\', 'x', upper, lower});
+// The escaped form of a byte that is not printable, such as \n or \x1B.
+inline std::string_view escape_non_printable_char(char c) {
+  return get_byte_info(c).escaped_view();
 }
 
-inline std::string escape_string(std::string_view s) {
-  auto need_escape = [](char c) {
-    return !std::isprint(static_cast<unsigned char>(c)) || c == '"' || c == '\\';
-  };
-  auto escape_char = [](char c) -> std::string {
-    switch (c) {
-      case '"':
-        return R"(\")";
-      case '\\':
-        return R"(\\)";
-      default:
-        return escape_non_printable_char(c);
-    }
-  };
-
-  std::string retval(1, '"');
-  auto begin = s.begin();
-  decltype(begin) end;
-  while ((end = std::find_if(begin, s.end(), need_escape)) != s.end()) {
+inline temp_string escape_string(std::string_view s) {
+  auto retval = make_temp_string();
+  retval.reserve(s.size() + 2);
+  retval.push_back('"');
+  const char *begin = s.data();
+  const char *last = s.data() + s.size();
+  const char *end;
+  while ((end = find_needs_escape(begin, last)) != last) {
     retval.append(begin, end);
-    retval.append(escape_char(*end));
+    retval.append(get_byte_info(*end).escaped_view());
     begin = end + 1;
   }
-  retval.append(begin, end).push_back('"');
+  retval.append(begin, last).push_back('"');
 
   return retval;
 }
 
+}  // namespace _p_CPP_DUMP_ES_NAMESPACE
+
 }  // namespace _detail
 
 }  // namespace cpp_dump
@@ -0,0 +1,81 @@
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <new>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "../cpp-dump.hpp"
+
+#define TEST_COUNT_ALLOCATIONS
+#include "./common.hpp"
+
+//
+using namespace std;
+namespace cp = cpp_dump;
+
+struct record {
+  int id;
+  double score;
+  string name;
+  vector<int> values;
+  map<string, vector<int>> groups;
+  const int *pointer;
+};
+
+CPP_DUMP_DEFINE_EXPORT_OBJECT(record, id, score, name, values, groups, pointer);
+
+string dumped;
+
+template <>
+void cpp_dump::write_log(std::string_view output) {
+  dumped = output;
+}
+
+int main() {
+  record r{
+      42,
+      0.5,
+      "a name longer than the small string buffer",
+      {1, 2, 3, 4, 5, 6, 7, 8},
+      {{"first group", {1, 2, 3}}, {"second group", {4, 5, 6}}},
+      nullptr};
+  dumped.reserve(4096);
+
+  auto dump = [&] {
+    cpp_dump(r);
+    cpp_dump(r, r.values);
+  };
+
+  // The first calls grow the buffer of the thread and build the token table and the labels of
+  // the call sites.
+  dump();
+  string first = dumped;
+
+  // Repeating the same calls allocates nothing.
+  allocation_count = 0;
+  for (int i = 0; i < 10; ++i) dump();
+  CHECK(allocation_count == 0);
+  CHECK(dumped == first);
+
+  // So does a narrow line that makes cpp_dump() try every pattern.
+  CPP_DUMP_SET_OPTION(max_line_width, 30);
+  dump();
+  allocation_count = 0;
+  dump();
+  CHECK(allocation_count == 0);
+
+  // The temporaries do not outlive the dump, and the buffer is not used outside of it.
+  CHECK(cp::_detail::dump_arena::resource() == std::pmr::get_default_resource());
+  CHECK(cp::_detail::dump_arena::get().capacity() > 0);
+
+  // A dump larger than the limit does not make the thread keep its peak memory.
+  CPP_DUMP_SET_OPTION(max_line_width, 160);
+  CPP_DUMP_SET_OPTION(max_iteration_count, 1 << 20);
+  vector<int> large(1 << 18, 12345);
+  cpp_dump(large);
+  CHECK(cp::_detail::dump_arena::get().capacity() <= cp::_detail::dump_arena::max_capacity);
+
+  return 0;
+}
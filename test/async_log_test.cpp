@@ -0,0 +1,158 @@
+#include <array>
+#include <atomic>
+#include <cstdio>
+#include <deque>
+#include <iostream>
+#include <list>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../cpp-dump.hpp"
+#include "./common.hpp"
+
+//
+using namespace std;
+namespace cp = cpp_dump;
+
+enum class color { red, green };
+CPP_DUMP_DEFINE_EXPORT_ENUM(color, color::red, color::green);
+
+static_assert(cp::_detail::is_capturable<vector<list<string>>>);
+static_assert(cp::_detail::is_capturable<const char (&)[4]>);
+static_assert(!cp::_detail::is_capturable<const char *>);
+static_assert(!cp::_detail::is_capturable<map<int, int>>);
+static_assert(!cp::_detail::is_capturable<vector<int *>>);
+
+vector<string> read_lines(FILE *file) {
+  fflush(file);
+  rewind(file);
+  vector<string> lines;
+  string line;
+  for (int c; (c = fgetc(file)) != EOF;) {
+    if (c == '\n') {
+      lines.push_back(line);
+      line.clear();
+    } else {
+      line.push_back(static_cast<char>(c));
+    }
+  }
+  return lines;
+}
+
+int main() {
+  CPP_DUMP_SET_OPTION(es_style, cp::types::es_style_t::no_es);
+  CPP_DUMP_SET_OPTION(log_label_func, nullptr);
+
+  // The ring keeps the order and refuses records when full.
+  {
+    cp::_detail::log_ring ring(3);
+    CHECK(ring.capacity() == 4);
+    for (int i = 0; i < 4; ++i) {
+      cp::_detail::log_record record{to_string(i), nullptr};
+      CHECK(ring.try_push(record));
+    }
+    cp::_detail::log_record record{"4", nullptr};
+    CHECK(!ring.try_push(record) && record.text == "4");
+    for (int i = 0; i < 4; ++i) {
+      CHECK(ring.try_pop(record) && record.text == to_string(i));
+    }
+    CHECK(ring.empty() && !ring.try_pop(record));
+  }
+
+  // Every record of every thread is written once, in the order of each thread.
+  {
+    FILE *file = tmpfile();
+    CHECK(file != nullptr);
+    cp::start_async_log({64, cp::types::log_overflow_t::block, fileno(file)});
+    vector<thread> threads;
+    for (int t = 0; t < 8; ++t) {
+      threads.emplace_back([t] {
+        for (int i = 0; i < 500; ++i) cpp_dump(t, i);
+      });
+    }
+    for (auto &th : threads) th.join();
+    cp::flush_async_log();
+    CHECK(cp::async_log_dropped_count() == 0);
+
+    auto lines = read_lines(file);
+    CHECK(lines.size() == 8 * 500);
+    vector<int> next(8, 0);
+    for (const auto &line : lines) {
+      int t = -1, i = -1;
+      CHECK(sscanf(line.c_str(), "t => %d, i => %d", &t, &i) == 2);
+      CHECK(t >= 0 && t < 8 && i == next[t]++);
+    }
+
+    // cpp_dump() writes synchronously again after stop_async_log().
+    cp::stop_async_log();
+    CHECK(cp::_detail::active_async_logger().load() == nullptr);
+    fclose(file);
+  }
+
+  // The dropped records are counted, and drop_oldest always keeps the newest record.
+  using overflow_t = cp::types::log_overflow_t;
+  for (auto overflow : {overflow_t::drop_newest, overflow_t::drop_oldest}) {
+    FILE *file = tmpfile();
+    CHECK(file != nullptr);
+    cp::start_async_log({4, overflow, fileno(file)});
+    for (int i = 0; i < 10000; ++i) cp::write_log(to_string(i));
+    cp::flush_async_log();
+    auto dropped = cp::async_log_dropped_count();
+    auto lines = read_lines(file);
+    CHECK(lines.size() + dropped == 10000);
+    if (overflow == overflow_t::drop_oldest) {
+      CHECK(lines.back() == "9999");
+    }
+    cp::stop_async_log();
+    fclose(file);
+  }
+
+  // The deferred records are formatted by the background thread with the same output.
+  {
+    vector<int> long_vec(100);
+    for (int i = 0; i < 100; ++i) long_vec[i] = i * i;
+    list<string> strings{"a", "b\n", "c"};
+    vector<vector<int>> vec2d{{1, 2}, long_vec, {}};
+    deque<double> dq{1.5, -2.25};
+    array<char, 3> chars{'x', 'y', 'z'};
+    vector<bool> bits{true, false, true};
+    map<int, int> m{{1, 2}};
+    int value = 42;
+    string str = "str";
+    auto dump_all = [&] {
+      cpp_dump(value, str, "literal", color::green, 3.5, 'c');
+      cpp_dump(long_vec, strings, vec2d);
+      cpp_dump(dq, chars, bits);
+      cpp_dump(value, m, &value);
+    };
+
+    vector<vector<string>> outputs;
+    auto main_thread = this_thread::get_id();
+    atomic<int> labels = 0, background_labels = 0;
+    // uncached() makes every dump call the function, and the deferred dumps still call it on the
+    // thread of cpp_dump().
+    CPP_DUMP_SET_OPTION(log_label_func, cp::log_label::uncached([&](auto, auto, auto) {
+      ++labels;
+      if (this_thread::get_id() != main_thread) ++background_labels;
+      return string("[dump] ");
+    }));
+    for (bool defer : {false, true}) {
+      FILE *file = tmpfile();
+      CHECK(file != nullptr);
+      cp::start_async_log({64, cp::types::log_overflow_t::block, fileno(file), defer});
+      dump_all();
+      cp::flush_async_log();
+      CHECK(labels.exchange(0) == 4 && background_labels.exchange(0) == 0);
+      cp::stop_async_log();
+      outputs.push_back(read_lines(file));
+      fclose(file);
+    }
+    CHECK(outputs[0] == outputs[1]);
+    CHECK(outputs[0].size() > 4);
+    CPP_DUMP_SET_OPTION(log_label_func, nullptr);
+  }
+
+  return 0;
+}
@@ -0,0 +1,233 @@
+#include <array>
+#include <cstdint>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <list>
+#include <map>
+#include <memory>
+#include <optional>
+#include <random>
+#include <set>
+#include <sstream>
+#include <string>
+#include <tuple>
+#include <variant>
+#include <vector>
+
+#include "../cpp-dump.hpp"
+#include "./common.hpp"
+
+//
+using namespace std;
+namespace cp = cpp_dump;
+
+struct point {
+  int x;
+  string label;
+};
+CPP_DUMP_DEFINE_EXPORT_OBJECT(point, x, label);
+
+enum class color { red, green };
+CPP_DUMP_DEFINE_EXPORT_ENUM(color, color::red, color::green);
+
+// The text that cpp_dump() prints, written to a file by start_async_log().
+template <typename Dump>
+string print(Dump dump) {
+  FILE *file = tmpfile();
+  cp::start_async_log({64, cp::types::log_overflow_t::block, fileno(file)});
+  dump();
+  cp::stop_async_log();
+  auto text = read_all(file);
+  fclose(file);
+  return text;
+}
+
+template <typename Dump>
+string record(Dump dump) {
+  FILE *file = tmpfile();
+  cp::start_binary_log(fileno(file));
+  dump();
+  cp::stop_binary_log();
+  auto stream = read_all(file);
+  fclose(file);
+  return stream;
+}
+
+bool replay(const string &stream, string &text) {
+  text.clear();
+  return cp::replay_binary_log(stream, [&](const cp::types::binary_log_record_t &r) {
+    text.append(r.text).push_back('\n');
+  });
+}
+
+template <typename... Args>
+void dump_variadic(const Args &...args) {
+  cpp_dump(args...);
+}
+
+int main(int argc, char *argv[]) {
+  vector<int> long_vec(100);
+  for (int i = 0; i < 100; ++i) long_vec[i] = i * i;
+  vector<vector<int>> vec2d{{1, 2}, long_vec, {}};
+  list<string> strings{"a", "b\n", "c\""};
+  map<string, vector<double>> m{{"one", {1.5}}, {"two", {2.5, -0.25}}};
+  multimap<int, char> mm{{1, 'a'}, {1, 'b'}, {2, '\n'}};
+  set<int> s{3, 1, 2};
+  multiset<int> ms{1, 1, 2};
+  tuple<int, string, pair<bool, char>> t{1, "t", {true, 'c'}};
+  optional<int> opt = 7, none;
+  variant<int, string> var = string("var");
+  int value = 42;
+  unique_ptr<int> ptr = make_unique<int>(5);
+  int *null = nullptr;
+  vector<vector<vector<vector<vector<int>>>>> deep{{{{{1}}}}};
+  vector<bool> bits{true, false};
+  array<unsigned char, 2> bytes{1, 255};
+  auto dump_typed = [&] {
+    cpp_dump(value, 3.5, 'c', "literal", string("str"), -1LL, 2.5f, true);
+    cpp_dump(long_vec, vec2d, strings);
+    cpp_dump(m, mm, s, ms);
+    cpp_dump(t, opt, none, var, ptr, null, deep, bits, bytes);
+    dump_variadic(value, s);
+  };
+  auto dump_all = [&] {
+    dump_typed();
+    point p{1, "p"};
+    vector<point> points{p, {2, "q"}};
+    cpp_dump(p, points, color::green, cp::hex(value), &value);
+  };
+
+  // The replay prints the same text for any max_line_width.
+  auto stream = record(dump_all);
+  CHECK(stream.compare(0, 8, "cpp-dump") == 0);
+  string text;
+  for (size_t width : {160, 40, 12}) {
+    CPP_DUMP_SET_OPTION(max_line_width, width);
+    CHECK(replay(stream, text));
+    CHECK(text == print(dump_all));
+  }
+  CPP_DUMP_SET_OPTION(max_line_width, 160);
+
+  // The escape sequences of every value are chosen at the replay, including those of the values
+  // written as their documents.
+  for (auto recorded : {cp::types::es_style_t::original, cp::types::es_style_t::no_es}) {
+    CPP_DUMP_SET_OPTION(es_style, recorded);
+    stream = record(dump_all);
+    for (auto style : {cp::types::es_style_t::no_es, cp::types::es_style_t::by_syntax}) {
+      CPP_DUMP_SET_OPTION(es_style, style);
+      CHECK(replay(stream, text));
+      CHECK(text == print(dump_all));
+    }
+    CPP_DUMP_SET_OPTION(es_style, cp::types::es_style_t::original);
+    CPP_DUMP_SET_OPTION(es_value.identifier, "\x1b[35m");
+    CHECK(replay(stream, text));
+    CHECK(text == print(dump_all) && text.find("\x1b[35m") != string::npos);
+    CPP_DUMP_SET_OPTION(es_value, cp::types::es_value_t{});
+  }
+
+  // The records have the time and the thread.
+  {
+    auto before = chrono::system_clock::now();
+    auto stream2 = record([&] { cpp_dump(value); });
+    auto after = chrono::system_clock::now();
+    int count = 0;
+    bool ok = cp::replay_binary_log(stream2, [&](const cp::types::binary_log_record_t &r) {
+      ++count;
+      if (r.time < before || r.time > after || r.thread != cp::_detail::binary_log_thread_number())
+        count = -100;
+    });
+    CHECK(ok && count == 1);
+  }
+
+  // A truncated stream is reported.
+  CHECK(!replay(stream.substr(0, stream.size() - 1), text));
+  CHECK(!replay("text", text));
+
+  // A broken stream is reported without throwing or exhausting the stack.
+  {
+    CPP_DUMP_SET_OPTION(es_style, cp::types::es_style_t::no_es);
+    auto header = record([] {});
+    auto with_record = [&](std::uint64_t value_count, const string &values, size_t exprs = 1) {
+      string stream2 = header;
+      cp::_detail::binary_encoder encoder(stream2);
+      encoder.byte('s');
+      encoder.varint(0);
+      encoder.string("file.cpp");
+      encoder.varint(1);
+      encoder.string("function");
+      encoder.byte(1);
+      encoder.varint(exprs);
+      for (size_t i = 0; i < exprs; ++i) encoder.string("args");
+      encoder.byte('r');
+      encoder.varint(0);
+      encoder.raw(std::int64_t{0});
+      encoder.varint(0);
+      encoder.varint(0);
+      encoder.varint(value_count);
+      stream2.append(values);
+      return stream2;
+    };
+    auto optional_tag = static_cast<char>(cp::_detail::binary_tag::optional);
+    auto nullopt_tag = static_cast<char>(cp::_detail::binary_tag::nullopt);
+    CHECK(replay(with_record(1, string(1, nullopt_tag)), text));
+    CHECK(text == "[dump] args[0] => std::nullopt\n");
+    CHECK(!replay(with_record(1, string(1, nullopt_tag), 0), text));
+    CHECK(!replay(with_record(uint64_t{1} << 62, string(1, nullopt_tag)), text));
+    CHECK(!replay(with_record(3, string(3, '\xff')), text));
+    CHECK(replay(with_record(1, string(100, optional_tag) + nullopt_tag), text));
+    CHECK(!replay(with_record(1, string(1000000, optional_tag) + nullopt_tag), text));
+
+    // Nor does a record with its bytes changed.
+    auto valid = record(dump_typed);
+    mt19937 engine(1);
+    for (int i = 0; i < 2000; ++i) {
+      auto corrupted = valid;
+      uniform_int_distribution<size_t> position(header.size(), corrupted.size() - 1);
+      for (int j = 0; j < 4; ++j) corrupted[position(engine)] = static_cast<char>(engine());
+      replay(corrupted, text);
+    }
+  }
+
+  // The call sites are written once, so the stream is smaller than the text.
+  CPP_DUMP_SET_OPTION(es_style, cp::types::es_style_t::no_es);
+  auto repeat = [&] {
+    for (int i = 0; i < 100; ++i) cpp_dump(i, long_vec);
+  };
+  CHECK(record(repeat).size() * 2 < print(repeat).size());
+
+  // The records keep the number of the calls skipped by cpp_dump_sampled().
+  auto sampled = record([] {
+    for (int i = 0; i < 3; ++i) cpp_dump_sampled(cp::sampling::every(2), i);
+  });
+  CHECK(replay(sampled, text));
+  CHECK(text == "[dump] i => 0\n[dump] (1 suppressed) i => 2\n");
+
+  // The calls of a dumper are replayed without the expressions, like it prints them.
+  const cp::dumper dumper;
+  auto dump_with_dumper = [&] {
+    dumper(1);
+    dumper(2, 3);
+  };
+  CHECK(replay(record(dump_with_dumper), text));
+  CHECK(text == print(dump_with_dumper) && text == "[dump] 1\n[dump] 2, 3\n");
+
+  // The command replays a stream written to a file.
+  if (argc > 1) {
+    {
+      ofstream("binary_log_test.bin", ios::binary) << record(dump_typed);
+    }
+    string command = string("\"") + argv[1]
+                     + "\" --es-style=no_es --max-line-width=40 binary_log_test.bin"
+                       " > binary_log_test.txt";
+    CHECK(system(command.c_str()) == 0);
+    stringstream replayed;
+    replayed << ifstream("binary_log_test.txt", ios::binary).rdbuf();
+    CPP_DUMP_SET_OPTION(max_line_width, 40);
+    CHECK(replayed.str() == print(dump_typed));
+  }
+
+  return 0;
+}
@@ -0,0 +1,176 @@
+#include <atomic>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../cpp-dump.hpp"
+
+#define TEST_CAPTURE_LINES
+#define TEST_COUNT_ALLOCATIONS
+#include "./common.hpp"
+
+//
+using namespace std;
+namespace cp = cpp_dump;
+
+void named_function(int i) { cpp_dump(i); }
+
+template <typename... Args>
+void dump_variadic(const Args &...args) {
+  cpp_dump(args...);
+}
+
+// A type whose operator<<() dumps at the call site that dumps it.
+struct nested {
+  int depth;
+};
+
+void dump_nested(const nested &n) { cpp_dump(n); }
+
+ostream &operator<<(ostream &os, const nested &n) {
+  if (n.depth > 0) dump_nested(nested{n.depth - 1});
+  return os << "nested" << n.depth;
+}
+
+int main() {
+  CPP_DUMP_SET_OPTION(es_style, cp::types::es_style_t::no_es);
+
+  // The label function is called once for each call site.
+  atomic<int> label_calls = 0;
+  auto counting_label = [&](string_view, size_t line, string_view func) {
+    ++label_calls;
+    return "[" + to_string(line) + " " + string(func) + "] ";
+  };
+  CPP_DUMP_SET_OPTION(log_label_func, counting_label);
+  auto dump_twice = [](int i) {
+    cpp_dump(i);
+    cpp_dump(i, i + 1);
+  };
+  for (int i = 0; i < 3; ++i) dump_twice(i);
+  CHECK(label_calls == 2);
+  CHECK(lines.size() == 6);
+  CHECK(lines[4].find("] i => 2") != string::npos);
+  CHECK(lines[5].find("] i => 2, i + 1 => 3") != string::npos);
+  // The function name is the one of the caller.
+  named_function(0);
+  CHECK(lines.back().find(" named_function] i => 0") != string::npos);
+
+  // Assigning the function again builds the labels again.
+  CPP_DUMP_SET_OPTION(log_label_func, counting_label);
+  dump_twice(0);
+  CHECK(label_calls == 5);
+  CPP_DUMP_SET_OPTION(log_label_func, nullptr);
+  lines.clear();
+  dump_twice(0);
+  CHECK((lines == vector<string>{"i => 0", "i => 0, i + 1 => 1"}));
+  // An empty function stays empty when it is assigned.
+  const cp::types::log_label_func_t empty;
+  CPP_DUMP_SET_OPTION(log_label_func, empty);
+  lines.clear();
+  dump_twice(0);
+  CHECK((lines == vector<string>{"i => 0", "i => 0, i + 1 => 1"}));
+
+  // So does changing the colors.
+  CPP_DUMP_SET_OPTION(log_label_func, cp::log_label::default_func);
+  CPP_DUMP_SET_OPTION(es_style, cp::types::es_style_t::original);
+  auto dump_value = [] {
+    int value = 1;
+    cpp_dump(value);
+  };
+  lines.clear();
+  dump_value();
+  CPP_DUMP_SET_OPTION(es_value.expression, "\x1b[35m");
+  dump_value();
+  CHECK(lines.size() == 2);
+  CHECK(lines[0].find("\x1b[36mvalue\x1b[0m") != string::npos);
+  CHECK(lines[1].find("\x1b[35mvalue\x1b[0m") != string::npos);
+  CPP_DUMP_SET_OPTION(es_style, cp::types::es_style_t::no_es);
+  lines.clear();
+  dump_value();
+  CHECK((lines == vector<string>{"[dump] value => 1"}));
+
+  // The expressions of variadic template arguments are numbered for each call.
+  lines.clear();
+  dump_variadic(1, 2);
+  dump_variadic(3);
+  CHECK((lines
+         == vector<string>{"[dump] args...[0] => 1, args...[1] => 2", "[dump] args...[0] => 3"}));
+
+  // A function wrapped in uncached() is called on every dump.
+  label_calls = 0;
+  CPP_DUMP_SET_OPTION(log_label_func, cp::log_label::uncached(counting_label));
+  for (int i = 0; i < 3; ++i) dump_twice(i);
+  CHECK(label_calls == 6);
+
+  // The nested dumps build the labels again, and the outer dump keeps using its own.
+  lines.clear();
+  dump_nested(nested{2});
+  CHECK(lines.size() == 3);
+  for (const auto &line : lines) CHECK(line.find(" dump_nested] n => nested") != string::npos);
+  CHECK(lines.back().find("n => nested2") != string::npos);
+
+  // A call site used with two options in turn keeps the labels for both, and does not pile up
+  // the labels it replaces.
+  {
+    label_calls = 0;
+    CPP_DUMP_SET_OPTION(log_label_func, counting_label);
+    CPP_DUMP_SET_OPTION(es_style, cp::types::es_style_t::original);
+    cp::types::options_snapshot_t first_options;
+    CPP_DUMP_SET_OPTION(es_style, cp::types::es_style_t::by_syntax);
+    cp::types::options_snapshot_t second_options;
+    CPP_DUMP_SET_OPTION(es_style, cp::types::es_style_t::no_es);
+    auto dump_in_turn = [&](int count) {
+      for (int i = 0; i < count; ++i) {
+        cp::options_scope scope(i % 2 == 0 ? first_options : second_options);
+        cpp_dump(i);
+        lines.clear();
+      }
+    };
+    dump_in_turn(10);
+    CHECK(label_calls == 2);
+    auto live = live_allocation_count.load();
+    dump_in_turn(10000);
+    CHECK(label_calls == 2);
+    CHECK(live_allocation_count == live);
+
+    // More options than the call site keeps replace the oldest labels, which are freed.
+    vector<cp::types::options_snapshot_t> many_options;
+    for (int i = 0; i < 16; ++i) {
+      CPP_DUMP_SET_OPTION(es_value.log, "\x1b[3" + to_string(i % 8) + (i < 8 ? "m" : ";1m"));
+      CPP_DUMP_SET_OPTION(es_style, cp::types::es_style_t::original);
+      many_options.emplace_back();
+    }
+    CPP_DUMP_SET_OPTION(es_style, cp::types::es_style_t::no_es);
+    auto dump_with_many = [&] {
+      for (const auto &options : many_options) {
+        cp::options_scope scope(options);
+        cpp_dump(0);
+        lines.clear();
+      }
+    };
+    dump_with_many();
+    live = live_allocation_count.load();
+    for (int i = 0; i < 100; ++i) dump_with_many();
+    CHECK(live_allocation_count == live);
+  }
+
+  // The threads share the labels of a call site.
+  {
+    label_calls = 0;
+    CPP_DUMP_SET_OPTION(log_label_func, counting_label);
+    lines.clear();
+    vector<thread> threads;
+    for (int t = 0; t < 4; ++t) {
+      threads.emplace_back([] {
+        for (int i = 0; i < 100; ++i) cpp_dump(i);
+      });
+    }
+    for (auto &th : threads) th.join();
+    CHECK(lines.size() == 400);
+    CHECK(label_calls >= 1 && label_calls <= 4);
+  }
+
+  return 0;
+}
@@ -0,0 +1,87 @@
+/*
+ * The helpers that the *_test.cpp programs share.
+ * Define TEST_COUNT_ALLOCATIONS before including this to count the calls to operator new in
+ * allocation_count and the blocks not deleted yet in live_allocation_count, and
+ * TEST_CAPTURE_LINES to collect the output of cpp_dump() in lines.
+ * Include this from one translation unit only.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <string_view>
+
+#if defined(TEST_COUNT_ALLOCATIONS)
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#endif
+
+#if defined(TEST_CAPTURE_LINES)
+#include <mutex>
+#include <vector>
+#endif
+
+#include "../cpp-dump.hpp"
+
+#define CHECK(x)                                                                                   \
+  if (!(x)) {                                                                                      \
+    std::clog << __FILE__ << ":" << __LINE__ << ": check failed: " #x << std::endl;                \
+    return 1;                                                                                      \
+  }
+
+// The whole content of the file.
+inline std::string read_all(FILE *file) {
+  std::fflush(file);
+  std::rewind(file);
+  std::string content;
+  for (int c; (c = std::fgetc(file)) != EOF;) content.push_back(static_cast<char>(c));
+  return content;
+}
+
+#if defined(TEST_COUNT_ALLOCATIONS)
+
+inline std::atomic<std::size_t> allocation_count = 0;
+inline std::atomic<std::ptrdiff_t> live_allocation_count = 0;
+
+// GCC cannot tell that these replace the global operators.
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 11
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+void *operator new(std::size_t size) {
+  ++allocation_count;
+  if (void *p = std::malloc(size == 0 ? 1 : size)) {
+    ++live_allocation_count;
+    return p;
+  }
+  throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept {
+  if (p) --live_allocation_count;
+  std::free(p);
+}
+void operator delete(void *p, std::size_t) noexcept { operator delete(p); }
+
+#endif
+
+#if defined(TEST_CAPTURE_LINES)
+
+inline std::vector<std::string> lines;
+inline std::mutex lines_mutex;
+
+namespace cpp_dump {
+
+template <>
+void write_log(std::string_view output) {
+  std::lock_guard<std::mutex> lock(lines_mutex);
+  lines.emplace_back(output);
+}
+
+}  // namespace cpp_dump
+
+#endif
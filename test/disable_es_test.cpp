@@ -0,0 +1,45 @@
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "../cpp-dump.hpp"
+#include "./common.hpp"
+#include "./disable_es_test.hpp"
+
+//
+using namespace std;
+namespace cp = cpp_dump;
+
+int main() {
+  CPP_DUMP_SET_OPTION(es_style, cp::types::es_style_t::original);
+  CPP_DUMP_SET_OPTION(log_label_func, nullptr);
+  vector<point> points{{1, 2}, {3, 4}};
+
+  // A translation unit with CPP_DUMP_DISABLE_ES prints no colors even if the others do.
+  string with_es = cp::export_var(points);
+  string without_es = export_without_es(points);
+  CHECK(with_es.find("\x1b[") != string::npos);
+  CHECK(without_es == "[ point{ x= 1, y= 2 }, point{ x= 3, y= 4 } ]");
+  CHECK(cp::export_var(points) == with_es);
+
+  // Both share the options.
+  CPP_DUMP_SET_OPTION(max_line_width, 30);
+  CHECK(export_without_es(points) == "[\n  point{ x= 1, y= 2 },\n  point{ x= 3, y= 4 }\n]");
+  CPP_DUMP_SET_OPTION(max_line_width, 160);
+
+  // Both write to the destination of the logs.
+  FILE *file = tmpfile();
+  CHECK(file != nullptr);
+  cp::start_fd_log({fileno(file)});
+  int value = 1;
+  cpp_dump(value);
+  dump_without_es(2);
+  cp::stop_fd_log();
+  string text = read_all(file);
+  fclose(file);
+  CHECK(text.find("\x1b[") == 0);
+  CHECK(text.substr(text.find('\n') + 1) == "value => 2\n");
+
+  return 0;
+}
@@ -0,0 +1,15 @@
+#include <string>
+#include <vector>
+
+#include "../cpp-dump.hpp"
+
+struct point {
+  int x;
+  int y;
+};
+
+CPP_DUMP_DEFINE_EXPORT_OBJECT(point, x, y);
+
+// Defined in disable_es_test_no_es.cpp, which defines CPP_DUMP_DISABLE_ES.
+std::string export_without_es(const std::vector<point> &points);
+void dump_without_es(int value);
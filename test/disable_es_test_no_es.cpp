@@ -0,0 +1,11 @@
+#define CPP_DUMP_DISABLE_ES
+
+#include "./disable_es_test.hpp"
+
+#include "../cpp-dump.hpp"
+
+std::string export_without_es(const std::vector<point> &points) {
+  return cpp_dump::export_var(points);
+}
+
+void dump_without_es(int value) { cpp_dump(value); }
@@ -17,7 +17,11 @@ file(MAKE_DIRECTORY "${test_dir}/log")
 list(GET cmd_args 0 suffix)
 list(GET cmd_args 1 width)
 list(GET cmd_args 2 depth)
-set(log_file "${test_dir}/log/dump_indent_${suffix}.log")
+if(log_suffix)
+   set(log_file "${test_dir}/log/dump_indent_${suffix}_${log_suffix}.log")
+else()
+   set(log_file "${test_dir}/log/dump_indent_${suffix}.log")
+endif()
 set(txt_file "${test_dir}/txt/dump_indent_${suffix}.txt")
 
 # no color
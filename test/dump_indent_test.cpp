@@ -496,4 +496,6 @@ here.)");
   self_reference_class self_reference_class2{
       "This is self_reference_class, which has a self-reference.."};
   cpp_dump(self_reference_class2);
+
+  return 0;
 }
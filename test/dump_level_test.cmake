@@ -0,0 +1,32 @@
+if(NOT cmd_path)
+   message(FATAL_ERROR "Variable cmd_path not defined")
+endif()
+
+if(NOT nm)
+   message(FATAL_ERROR "Variable nm not defined")
+endif()
+
+execute_process(COMMAND "${cmd_path}" COMMAND_ERROR_IS_FATAL ANY)
+
+# The disabled calls instantiate no function for their types.
+execute_process(
+   COMMAND "${nm}" -C "${cmd_path}" OUTPUT_VARIABLE symbols COMMAND_ERROR_IS_FATAL ANY
+)
+if(NOT symbols MATCHES "cpp_dump_macro")
+   message(SEND_ERROR "The enabled calls are not found in the symbols.")
+endif()
+foreach(name trace_only_enum debug_only_struct disabled_dump)
+   if(symbols MATCHES "${name}")
+      message(SEND_ERROR "The symbols of the disabled calls are found: ${name}")
+   endif()
+endforeach()
+
+# The disabled calls stringify nothing.
+file(STRINGS "${cmd_path}" strings REGEX "info_value")
+if(NOT strings)
+   message(SEND_ERROR "The expressions of the enabled calls are not found in the strings.")
+endif()
+file(STRINGS "${cmd_path}" strings REGEX "trace_marker_value|debug_marker_value|count_evaluation\\(\\)")
+if(strings)
+   message(SEND_ERROR "The expressions of the disabled calls are found: ${strings}")
+endif()
@@ -0,0 +1,55 @@
+// Built with CPP_DUMP_LEVEL=CPP_DUMP_LEVEL_INFO.
+// dump_level_test.cmake checks that the binary has no trace of the disabled calls.
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "../cpp-dump.hpp"
+
+#define TEST_CAPTURE_LINES
+#include "./common.hpp"
+
+//
+using namespace std;
+namespace cp = cpp_dump;
+
+// Only the disabled calls print these types.
+enum class trace_only_enum { a };
+CPP_DUMP_DEFINE_EXPORT_ENUM(trace_only_enum, trace_only_enum::a);
+
+struct debug_only_struct {
+  int member;
+};
+CPP_DUMP_DEFINE_EXPORT_OBJECT(debug_only_struct, member);
+
+int evaluated = 0;
+
+int count_evaluation() { return ++evaluated; }
+
+template <typename... Args>
+void dump_variadic(const Args &...args) {
+  cpp_dump_trace(args...);
+  cpp_dump_info(args...);
+}
+
+int main() {
+  CPP_DUMP_SET_OPTION(es_style, cp::types::es_style_t::no_es);
+  CPP_DUMP_SET_OPTION(log_label_func, nullptr);
+
+  int info_value = 1;
+  auto trace_marker_value = trace_only_enum::a;
+  debug_only_struct debug_marker_value{2};
+
+  cpp_dump_trace(trace_marker_value, count_evaluation());
+  cpp_dump_debug(debug_marker_value, count_evaluation());
+  cpp_dump_info(info_value);
+  dump_variadic(3);
+  // The disabled calls are expressions, too.
+  cpp_dump_trace(trace_marker_value), cpp_dump_info(info_value);
+
+  CHECK(evaluated == 0);
+  CHECK((lines == vector<string>{"info_value => 1", "args...[0] => 3", "info_value => 1"}));
+
+  return 0;
+}
@@ -82,13 +82,9 @@ int main(int argc, char *argv[]) {
       std::string member_func() { return "This is a member_func."; }
     };
 
+    cpp_dump::_detail::document doc;
     cpp_dump::_detail::export_enum_generic(
-        original_scoped_enum::member1,
-        "",
-        0,
-        0,
-        false,
-        cpp_dump::_detail::export_command::default_command
+        original_scoped_enum::member1, 0, cpp_dump::_detail::export_command::default_command, doc
     );
 
     cpp_dump(original_error1);
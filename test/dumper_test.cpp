@@ -0,0 +1,94 @@
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../cpp-dump.hpp"
+
+#define TEST_CAPTURE_LINES
+#include "./common.hpp"
+
+//
+using namespace std;
+namespace cp = cpp_dump;
+
+cp::types::options_snapshot_t narrow_options() {
+  cp::types::options_snapshot_t options;
+  options.max_line_width = 12;
+  options.max_iteration_count = 2;
+  options.es_style = cp::types::es_style_t::no_es;
+  return options;
+}
+
+int main() {
+  CPP_DUMP_SET_OPTION(log_label_func, nullptr);
+  const cp::dumper narrow(narrow_options());
+  vector<int> vec{1, 2, 3};
+  int value = 1;
+
+  // The options are copied on construction.
+  CPP_DUMP_SET_OPTION(print_expr, false);
+  // operator() does not print the expressions, and cpp_dump_with() prints them because
+  // print_expr was true when narrow was constructed.
+  narrow(vec, value);
+  cpp_dump_with(narrow, vec, value);
+  CHECK(lines.size() == 2);
+  CHECK(lines[0] == "[\n  1,\n  2,\n  ...\n],\n1");
+  CHECK(lines[1] == "vec => [\n  1,\n  2,\n  ...\n],\nvalue => 1");
+  CPP_DUMP_SET_OPTION(print_expr, true);
+
+  // The dumper does not change the shared options.
+  lines.clear();
+  CPP_DUMP_SET_OPTION(es_style, cp::types::es_style_t::no_es);
+  cpp_dump(vec);
+  CHECK((lines == vector<string>{"vec => [ 1, 2, 3 ]"}));
+
+  // scope() applies the options to export_var() too.
+  {
+    cp::types::options_snapshot_t shallow_options;
+    shallow_options.max_depth = 0;
+    const cp::dumper shallow(shallow_options);
+    auto scope = shallow.scope();
+    CHECK(cp::export_var(vec) == "[ ... ]");
+  }
+  CHECK(cp::export_var(vec) == "[ 1, 2, 3 ]");
+
+  // The dumpers of the same options keep their own labels, which are built on construction.
+  {
+    int label_calls = 0;
+    auto make_label = [&](const string &label) {
+      return [&label_calls, label](string_view, size_t, string_view) {
+        ++label_calls;
+        return label;
+      };
+    };
+    CPP_DUMP_SET_OPTION(log_label_func, make_label("[a] "));
+    const cp::dumper a(narrow_options());
+    CPP_DUMP_SET_OPTION(log_label_func, make_label("[b] "));
+    const cp::dumper b(narrow_options());
+    CPP_DUMP_SET_OPTION(log_label_func, nullptr);
+    lines.clear();
+    for (int i = 0; i < 100; ++i) {
+      a(i);
+      b(i);
+    }
+    CHECK(label_calls == 2);
+    CHECK(lines.size() == 200);
+    CHECK(lines[0] == "[a] 0" && lines[1] == "[b] 0" && lines[199] == "[b] 99");
+  }
+
+  // The threads can share a dumper.
+  lines.clear();
+  vector<thread> threads;
+  for (int t = 0; t < 4; ++t) {
+    threads.emplace_back([&] {
+      for (int i = 0; i < 100; ++i) cpp_dump_with(narrow, vec);
+    });
+  }
+  for (auto &th : threads) th.join();
+  CHECK(lines.size() == 400);
+  for (auto &line : lines) CHECK(line == "vec => [\n  1,\n  2,\n  ...\n]");
+
+  return 0;
+}
@@ -0,0 +1,81 @@
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#include "../cpp-dump.hpp"
+#include "./common.hpp"
+
+//
+using namespace std;
+namespace cp = cpp_dump;
+
+enum class dense_enum { a, b, c, d };
+enum class sparse_enum : int { a = -1000000, b = -7, c = 0, d = 42, e = 1 << 30 };
+enum class unsigned_enum : uint64_t { a = 1, b = 0xffffffffffffffff, c = 0x8000000000000000 };
+enum class alias_enum : int8_t { a = -128, b = -128, c = 127 };
+enum generic_enum { g_first = 3, g_second = 4, g_third = 100 };
+
+CPP_DUMP_DEFINE_EXPORT_ENUM(dense_enum, dense_enum::a, dense_enum::b, dense_enum::c, dense_enum::d);
+CPP_DUMP_DEFINE_EXPORT_ENUM(
+    sparse_enum, sparse_enum::e, sparse_enum::a, sparse_enum::d, sparse_enum::b, sparse_enum::c
+);
+CPP_DUMP_DEFINE_EXPORT_ENUM_GENERIC(g_first, g_second, g_third);
+
+// The lookup is a constant expression.
+constexpr pair<dense_enum, string_view> dense_entries[] = {
+    {dense_enum::c, "c"}, {dense_enum::a, "a"}, {dense_enum::b, "b"}};
+constexpr auto dense_table = cp::_detail::make_enum_table(dense_entries);
+static_assert(dense_table.dense());
+static_assert(dense_table.find(dense_enum::a) == "a");
+static_assert(dense_table.find(dense_enum::c) == "c");
+static_assert(dense_table.find(dense_enum::d).empty());
+static_assert(dense_table.find(static_cast<dense_enum>(-1)).empty());
+
+constexpr pair<unsigned_enum, string_view> unsigned_entries[] = {
+    {unsigned_enum::a, "a"}, {unsigned_enum::b, "b"}, {unsigned_enum::c, "c"}};
+constexpr auto unsigned_table = cp::_detail::make_enum_table(unsigned_entries);
+static_assert(!unsigned_table.dense());
+static_assert(unsigned_table.find(unsigned_enum::b) == "b");
+static_assert(unsigned_table.find(unsigned_enum::c) == "c");
+static_assert(unsigned_table.find(static_cast<unsigned_enum>(0)).empty());
+
+// The first of the same values is used.
+constexpr pair<alias_enum, string_view> alias_entries[] = {
+    {alias_enum::c, "c"}, {alias_enum::b, "b"}, {alias_enum::a, "a"}};
+constexpr auto alias_table = cp::_detail::make_enum_table(alias_entries);
+static_assert(!alias_table.dense());
+static_assert(alias_table.find(alias_enum::a) == "b");
+static_assert(alias_table.find(alias_enum::c) == "c");
+static_assert(alias_table.find(static_cast<alias_enum>(0)).empty());
+
+// A large enum with gaps, looked up by index or by binary search.
+enum class large_enum : int {};
+
+int main() {
+  CPP_DUMP_SET_OPTION(es_style, cp::types::es_style_t::no_es);
+
+  CHECK(cp::export_var(dense_enum::b) == "dense_enum::b");
+  CHECK(cp::export_var(static_cast<dense_enum>(4)) == "dense_enum::?");
+  CHECK(cp::export_var(sparse_enum::a) == "sparse_enum::a");
+  CHECK(cp::export_var(sparse_enum::b) == "sparse_enum::b");
+  CHECK(cp::export_var(sparse_enum::e) == "sparse_enum::e");
+  CHECK(cp::export_var(static_cast<sparse_enum>(1)) == "sparse_enum::?");
+  CHECK(cp::export_var(g_third) == "generic_enum::g_third");
+  CHECK(cp::export_var(static_cast<generic_enum>(5)) == "generic_enum::?");
+
+  // Every value of the large tables is found, and no other value.
+  for (int step : {1, 2, 3, 1000}) {
+    pair<large_enum, string_view> entries[1000];
+    for (int i = 0; i < 1000; ++i) entries[i] = {static_cast<large_enum>((1000 - i) * step), "x"};
+    cp::_detail::enum_table<large_enum, 1000> table(entries);
+    CHECK(table.dense() == (step <= 2));
+    for (int v = -5; v < 1000 * step + 5; ++v) {
+      bool expected = v > 0 && v <= 1000 * step && v % step == 0;
+      CHECK(table.find(static_cast<large_enum>(v)).empty() == !expected);
+    }
+  }
+
+  return 0;
+}
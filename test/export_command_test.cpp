@@ -0,0 +1,101 @@
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../cpp-dump.hpp"
+
+#define TEST_COUNT_ALLOCATIONS
+#include "./common.hpp"
+
+//
+using namespace std;
+namespace cp = cpp_dump;
+
+int main() {
+  CPP_DUMP_SET_OPTION(es_style, cp::types::es_style_t::no_es);
+  vector<int> vec{1, 2, 3, 4, 5, 6, 7, 8, 9, 10};
+  map<int, vector<int>> m{{1, {10, 11, 12}}, {2, {20, 21, 22}}, {3, {30, 31, 32}}};
+
+  // Composing manipulators does not allocate.
+  size_t count = allocation_count;
+  {
+    auto vc1 = vec | cp::hex() | cp::front(8);
+    auto vc2 = cp::front(2) << cp::bin(0) << cp::map_kv(cp::hex(3, 3) << cp::back(2), cp::front(2))
+               << m;
+    auto vc3 = m | cp::index() | cp::front(1)
+               | cp::map_v(cp::oct(3, 3) | cp::middle(1) | cp::hex(3, 3) | cp::middle(2));
+    auto lvalue = cp::back(3) | cp::format("%08.3f") | cp::stresc();
+    auto vc4 = vec | lvalue | cp::both_ends(2) | cp::addr(1) | cp::charhex() | cp::boolnum();
+    CHECK(&vc1.value == &vec && &vc2.value == &m && &vc3.value == &m && &vc4.value == &vec);
+  }
+  CHECK(allocation_count == count);
+
+  // The commands are applied as before.
+  CHECK(cp::export_var(vec | cp::uhex(2) | cp::front(3)) == "[ 0x01 u, 0x02 u, 0x03 u, ... ]");
+  CHECK(cp::export_var(vec | cp::front(3) | cp::uhex(2)) == "[ 0x01 u, 0x02 u, 0x03 u, ... ]");
+  CHECK(cp::export_var(cp::back(2) << vec) == "[ ..., 9, 10 ]");
+  CHECK(
+      cp::export_var(m | cp::back(1) | cp::map_kv(cp::uhex(1), cp::front(1)))
+      == "{\n  ...,\n  0x3 u: [ 30, ... ]\n}"
+  );
+  CHECK(
+      cp::export_var(m | cp::ubin(1) | cp::front(1) | cp::map_v(cp::udec(2) | cp::back(1)))
+      == "{\n  0b1 u: [ ..., 12 ],\n  ...\n}"
+  );
+
+  // A command can be used many times, and by many values.
+  auto lvalue = cp::front(1) | cp::index();
+  CHECK(cp::export_var(vec | lvalue) == "[ 0: 1, ... ]");
+  CHECK(cp::export_var(m | lvalue) == cp::export_var(m | lvalue));
+
+  // The nodes and the props beyond the fixed capacity go to the heap and are still applied.
+  auto deep = cp::front(1);
+  for (int i = 0; i < 40; ++i) deep = deep | cp::front(2) | cp::map_kv(cp::hex(), cp::oct());
+  vector<vector<int>> vec2d{{1, 2, 3}, {4}};
+  CHECK(cp::export_var(vec2d | deep) == "[\n  [ 1, 2, ... ],\n  ...\n]");
+
+  // The trees are moved through a chain, so a tree on the heap is not copied.
+  auto moved = deep;
+  count = allocation_count;
+  {
+    auto vc = std::move(moved) << vec2d;
+    auto vc2 = std::move(vc) | cp::index();
+    CHECK(&vc2.value == &vec2d);
+  }
+  CHECK(allocation_count == count);
+
+  map<int, map<int, map<int, bool>>> nested{{1, {{2, {{3, true}}}}}};
+  auto inner = cp::front() | cp::map_kv(cp::bin(), cp::hex());
+  auto prop_heavy = cp::front()
+                    | cp::map_kv(cp::hex(), cp::front() | cp::map_kv(cp::oct(), inner));
+  CHECK(
+      cp::export_var(nested | prop_heavy | cp::boolnum())
+      == "{\n   0x00000001: {\n     0o00000000002: {  0b00000000000000000000000000000011: 1 }\n  "
+         "}\n}"
+  );
+  auto copied = prop_heavy | cp::boolnum();
+  CHECK(cp::export_var(nested | copied) == cp::export_var(nested | prop_heavy | cp::boolnum()));
+
+  // The props are resolved when composing, so an export_command is a few pointers and the threads
+  // can share a command.
+  static_assert(sizeof(cp::_detail::export_command) <= 3 * sizeof(void *));
+  static const auto shared = cp::front(2) | cp::map_kv(cp::hex(2), cp::back(1) | cp::oct(2));
+  string expected = cp::export_var(m | shared);
+  CHECK(expected == "{\n   0x01: [ ...,  0o14 ],\n   0x02: [ ...,  0o26 ],\n  ...\n}");
+  vector<string> results(4);
+  vector<thread> threads;
+  for (auto &result : results) {
+    threads.emplace_back([&] {
+      for (int i = 0; i < 1000; ++i) result = cp::export_var(m | shared);
+    });
+  }
+  for (auto &th : threads) th.join();
+  for (auto &result : results) CHECK(result == expected);
+
+  return 0;
+}
@@ -0,0 +1,53 @@
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "../cpp-dump.hpp"
+#include "./common.hpp"
+
+//
+using namespace std;
+namespace cp = cpp_dump;
+
+int main() {
+  CPP_DUMP_SET_OPTION(max_line_width, 40);
+  CPP_DUMP_SET_OPTION(es_style, cp::types::es_style_t::no_es);
+
+  vector<map<string, vector<int>>> data{
+      {{"a", {1, 2, 3}}, {"b", {4, 5, 6}}},
+      {{"c", {7, 8, 9}}, {"d", {10, 11, 12}}},
+  };
+  string expected = cp::export_var(data);
+  CHECK(expected.find('\n') != string::npos);
+
+  // std::string
+  string output = "prefix: ";
+  cp::export_to(output, data);
+  CHECK(output == "prefix: " + expected);
+
+  // char_span
+  char buffer[1024];
+  cp::char_span span(buffer);
+  cp::export_to(span, data);
+  CHECK(!span.truncated());
+  CHECK(span.view() == expected);
+
+  char small_buffer[8];
+  cp::char_span small_span(small_buffer);
+  cp::export_to(small_span, data);
+  CHECK(small_span.truncated());
+  CHECK(small_span.view() == expected.substr(0, 8));
+
+  // options
+  vector<int> vec{1, 2, 3};
+  string one_line;
+  cp::export_to(one_line, vec, {29, 0});
+  CHECK(one_line == "[ 1, 2, 3 ]");
+
+  string shifted;
+  cp::export_to(shifted, vec, {35, 4});
+  CHECK(shifted == "[\n      1,\n      2,\n      3\n    ]");
+
+  return 0;
+}
@@ -0,0 +1,92 @@
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../cpp-dump.hpp"
+#include "./common.hpp"
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#endif
+
+//
+using namespace std;
+namespace cp = cpp_dump;
+
+int main() {
+  CPP_DUMP_SET_OPTION(es_style, cp::types::es_style_t::no_es);
+  CPP_DUMP_SET_OPTION(log_label_func, nullptr);
+
+  // Each log is written whole, even if it has many lines and the threads log at once.
+  {
+    FILE *file = tmpfile();
+    CHECK(file != nullptr);
+    cp::start_fd_log({fileno(file)});
+    vector<thread> threads;
+    for (int t = 0; t < 8; ++t) {
+      threads.emplace_back([t] {
+        vector<string> vec(8, string(30, static_cast<char>('a' + t)));
+        for (int i = 0; i < 200; ++i) cpp_dump(vec);
+      });
+    }
+    for (auto &th : threads) th.join();
+    cp::stop_fd_log();
+
+    string text = read_all(file);
+    size_t count = 0;
+    for (size_t pos = 0; pos < text.size(); ++count) {
+      // A log is "vec => [\n" followed by 8 lines of one thread and "]\n".
+      CHECK(text.compare(pos, 9, "vec => [\n") == 0);
+      pos += 9;
+      char c = text[pos + 3];
+      string item = "  \"" + string(30, c) + "\"";
+      for (int i = 0; i < 8; ++i) {
+        string line = item + (i < 7 ? ",\n" : "\n");
+        CHECK(text.compare(pos, line.size(), line) == 0);
+        pos += line.size();
+      }
+      CHECK(text.compare(pos, 2, "]\n") == 0);
+      pos += 2;
+    }
+    CHECK(count == 1600);
+    fclose(file);
+  }
+
+  // start_async_log() takes precedence.
+  {
+    FILE *fd_file = tmpfile();
+    FILE *async_file = tmpfile();
+    CHECK(fd_file != nullptr && async_file != nullptr);
+    cp::start_fd_log({fileno(fd_file)});
+    cp::start_async_log({64, cp::types::log_overflow_t::block, fileno(async_file)});
+    int value = 1;
+    cpp_dump(value);
+    cp::stop_async_log();
+    cpp_dump(value);
+    cp::stop_fd_log();
+    CHECK(read_all(async_file) == "value => 1\n");
+    CHECK(read_all(fd_file) == "value => 1\n");
+    fclose(fd_file);
+    fclose(async_file);
+  }
+
+#if !defined(_WIN32)
+  // append sets O_APPEND.
+  {
+    FILE *file = tmpfile();
+    CHECK(file != nullptr);
+    CHECK((fcntl(fileno(file), F_GETFL) & O_APPEND) == 0);
+    cp::start_fd_log({fileno(file), true});
+    CHECK((fcntl(fileno(file), F_GETFL) & O_APPEND) != 0);
+    int value = 2;
+    cpp_dump(value);
+    cp::stop_fd_log();
+    CHECK(read_all(file) == "value => 2\n");
+    fclose(file);
+  }
+#endif
+
+  return 0;
+}
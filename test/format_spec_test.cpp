@@ -0,0 +1,86 @@
+#include <cstdio>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "../cpp-dump.hpp"
+#include "./common.hpp"
+
+//
+using namespace std;
+namespace cp = cpp_dump;
+
+template <typename T>
+int check_formats(const vector<string> &formats, const vector<T> &values) {
+  for (const auto &f : formats) {
+    cp::_detail::format_spec spec(f.c_str());
+    for (T value : values) {
+      char expected[1024];
+      snprintf(expected, sizeof(expected), f.c_str(), value);
+      auto actual = spec.format(value);
+      if (actual != expected) {
+        clog << "\"" << f << "\" with " << value << ": \"" << actual << "\" != \"" << expected
+             << "\"" << endl;
+        return 1;
+      }
+    }
+  }
+  return 0;
+}
+
+int main() {
+  // The common conversions are compiled, and the others are passed to snprintf().
+  for (const char *f : {"%d", "%x", "%.3f", "%e", "[%-+10.3f]", "%020lld", "% 5hhd", "%.0E"}) {
+    CHECK(cp::_detail::format_spec(f).compiled());
+  }
+  for (const char *f : {"%g", "%#x", "%*d", "%.*f", "%a", "%d%%", "%d %d", "100%%", "%s", "%"}) {
+    CHECK(!cp::_detail::format_spec(f).compiled());
+  }
+
+  const vector<string> int_formats{
+      "%d", "%i", "%5d", "%-5d|", "%05d", "%+d", "% d", "%+05d", "%-+8d|", "%.3d", "%8.3d",
+      "%08.3d", "%.0d", "%u", "%x", "%X", "%o", "%#x", "%08x", "%+x", "%hhd", "%hhu", "%hd", "%hx",
+      "x = %d;", "%d%%", "%.0x", "%-08d|", "%10.0d|", "% +d", "%-.5x|", "%+5i",
+  };
+  const vector<int> ints{0, 1, -1, 7, -42, 255, 300, 65535, -65536, 123456789,
+                         numeric_limits<int>::min(), numeric_limits<int>::max()};
+  CHECK(check_formats(int_formats, ints) == 0);
+  CHECK(check_formats(int_formats, vector<unsigned int>{0, 1, 4294967295u, 2147483648u}) == 0);
+  CHECK(check_formats(int_formats, vector<short>{0, -1, 32767, -32768}) == 0);
+
+  const vector<string> long_long_formats{"%lld", "%020lld", "%+llx", "%llX", "%-20llu|", "%jd"};
+  CHECK(check_formats(
+            long_long_formats,
+            vector<long long>{0, -1, 31415926535ll, numeric_limits<long long>::min(),
+                              numeric_limits<long long>::max()}
+        ) == 0);
+
+  const vector<string> double_formats{
+      "%f", "%.3f", "%10.3f", "%-10.3f|", "%010.3f", "%+.3f", "% .3f", "%.0f", "%e", "%.3e", "%E",
+      "%12.2E", "%F", "%lf", "%+010.0e", "[%10.3f]", "%.17f", "%.40e", "%.100f", "%g", "%#.0f",
+      "%.3lf", "%+.15f", "%a",
+  };
+  const vector<double> doubles{
+      0.0, -0.0, 1.0, -1.0, 0.5, 2.5, 3.14159265358979, -2.71828182845904, 1e-300, 1e300, 1e15,
+      0.125, 1e-7, 123456.789, numeric_limits<double>::max(), numeric_limits<double>::denorm_min(),
+      numeric_limits<double>::infinity(), -numeric_limits<double>::infinity(),
+      numeric_limits<double>::quiet_NaN(), -numeric_limits<double>::quiet_NaN(),
+  };
+  CHECK(check_formats(double_formats, doubles) == 0);
+  CHECK(check_formats(double_formats, vector<float>{0.0f, 3.14159265f, -1e10f, 1e-10f}) == 0);
+
+  const vector<string> long_double_formats{"%Lf", "%.15Lf", "%+.15Lf", "%Le", "%020.5Lf"};
+  CHECK(check_formats(
+            long_double_formats,
+            vector<long double>{0.0L, 3.141592653589793238L, -1e100L, 1e-20L,
+                                numeric_limits<long double>::infinity()}
+        ) == 0);
+
+  // The manipulator uses the spec.
+  CPP_DUMP_SET_OPTION(es_style, cp::types::es_style_t::no_es);
+  CHECK(cp::export_var(cp::format("%.3f") << vector<double>{1.0, 2.5}) == "[ 1.000, 2.500 ]");
+  CHECK(cp::export_var(cp::format("%08X") << 48879) == "0000BEEF");
+
+  return 0;
+}
@@ -0,0 +1,149 @@
+#include <algorithm>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "../cpp-dump.hpp"
+#include "./common.hpp"
+
+//
+using namespace std;
+namespace cp = cpp_dump;
+
+// The stringstream-based formatting that the digit-pair formatter replaces.
+template <typename T>
+string reference(T value, int base_, int digits_, int chunk_, bool space_fill, bool mu) {
+  auto base = static_cast<unsigned int>(base_);
+  auto digits = static_cast<unsigned int>(digits_ < 0 ? numeric_limits<int>::max() : digits_);
+  auto chunk = static_cast<unsigned int>(chunk_);
+  if (base == 10 && digits == 0 && chunk == 0) return to_string(value);
+
+  unsigned int max_digits = cp::_detail::_export_arithmetic::_get_max_digits<T>(base);
+  digits = min(digits, max_digits);
+  if (chunk > max_digits) chunk = 0;
+  const bool make_unsigned = is_signed_v<T> && base != 10 && mu;
+  const bool add_extra_space = !(is_unsigned_v<T> || mu);
+  using UnsignedT = make_unsigned_t<T>;
+  // Let stringstream recognize the type as an integer.
+  using UnsignedTOrInt = conditional_t<(sizeof(UnsignedT) > sizeof(int)), UnsignedT, unsigned>;
+  UnsignedTOrInt abs;
+  if (is_signed_v<T> && !make_unsigned && value < 0) {
+    abs = static_cast<UnsignedT>(UnsignedT{0} - static_cast<UnsignedT>(value));
+  } else {
+    abs = static_cast<UnsignedT>(value);
+  }
+
+  string output;
+  if (base == 2) {
+    do {
+      output.push_back(static_cast<char>('0' + (abs & 1)));
+      abs >>= 1;
+    } while (abs);
+  } else {
+    stringstream ss;
+    ss << setbase(static_cast<int>(base)) << uppercase << abs;
+    output = ss.str();
+    reverse(output.begin(), output.end());
+  }
+
+  const bool need_minus = !make_unsigned && value < 0;
+  const bool minus_before_fill = base == 10 && space_fill;
+  if (need_minus && minus_before_fill) output.push_back('-');
+  if (output.size() < digits) output.append(digits - output.size(), space_fill ? ' ' : '0');
+  const bool length_was_below_digits = output.size() <= digits;
+  if (chunk > 0) {
+    string chunked;
+    for (size_t pos = 0; pos < output.size(); pos += chunk) {
+      chunked.append(output, pos, chunk).push_back(' ');
+    }
+    if (base == 10) chunked.pop_back();
+    output = chunked;
+  }
+  if (base != 10) output.append(base == 2 ? "b0" : base == 8 ? "o0" : "x0");
+  if (need_minus && !minus_before_fill) {
+    output.push_back('-');
+  } else if (length_was_below_digits && add_extra_space) {
+    output.push_back(' ');
+  }
+  reverse(output.begin(), output.end());
+  return make_unsigned ? output + " u" : output;
+}
+
+template <typename T>
+int check_type(mt19937_64 &engine) {
+  vector<T> values{
+      numeric_limits<T>::min(),
+      static_cast<T>(numeric_limits<T>::min() + 1),
+      static_cast<T>(numeric_limits<T>::max() - 1),
+      numeric_limits<T>::max(),
+      0,
+      1,
+      static_cast<T>(-1),
+      static_cast<T>(10),
+      static_cast<T>(100),
+  };
+  for (int i = 0; i < 40; ++i) values.push_back(static_cast<T>(engine() >> (engine() % 64)));
+
+  for (T value : values) {
+    // The output without int_style.
+    CHECK(cp::export_var(value) == to_string(value));
+    CHECK(cp::_detail::decimal_chars(value).view() == to_string(value));
+
+    for (int base : {2, 8, 10, 16}) {
+      for (int digits : {-1, 0, 1, 3, 8, 64}) {
+        for (int chunk : {0, 1, 3, 4, 70}) {
+          for (bool space_fill : {false, true}) {
+            for (bool mu : {false, true}) {
+              auto style = cp::int_style(base, digits, chunk, space_fill, mu);
+              string expected = reference(value, base, digits, chunk, space_fill, mu);
+              string actual = cp::export_var(style << value);
+              if (actual != expected) {
+                clog << "int_style(" << base << ", " << digits << ", " << chunk << ", "
+                     << space_fill << ", " << mu << ") << " << +value << ": \"" << actual
+                     << "\" != \"" << expected << "\"" << endl;
+                return 1;
+              }
+            }
+          }
+        }
+      }
+    }
+  }
+  return 0;
+}
+
+int main() {
+  CPP_DUMP_SET_OPTION(es_style, cp::types::es_style_t::no_es);
+
+  mt19937_64 engine(1);
+  CHECK(check_type<signed char>(engine) == 0);
+  CHECK(check_type<unsigned char>(engine) == 0);
+  CHECK(check_type<short>(engine) == 0);
+  CHECK(check_type<unsigned short>(engine) == 0);
+  CHECK(check_type<int>(engine) == 0);
+  CHECK(check_type<unsigned int>(engine) == 0);
+  CHECK(check_type<long>(engine) == 0);
+  CHECK(check_type<unsigned long>(engine) == 0);
+  CHECK(check_type<long long>(engine) == 0);
+  CHECK(check_type<unsigned long long>(engine) == 0);
+
+  // Addresses are formatted as operator<<(const void *) formats them.
+  int x = 0;
+  for (const void *p : {static_cast<const void *>(&x), reinterpret_cast<const void *>(0x1)}) {
+    ostringstream ss;
+    ss << hex << p;
+    CHECK(cp::_detail::address_chars(p).view() == ss.str());
+  }
+  CHECK(cp::export_var(cp::addr() << &x) == cp::_detail::address_chars(&x).view());
+  auto shared = make_shared<int>(1);
+  CHECK(cp::export_var(cp::addr() << shared) == cp::_detail::address_chars(shared.get()).view());
+
+  return 0;
+}
@@ -0,0 +1,97 @@
+#include <iostream>
+#include <map>
+#include <random>
+#include <set>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "../cpp-dump.hpp"
+#include "./common.hpp"
+
+//
+using namespace std;
+namespace cp = cpp_dump;
+
+size_t comparison_count = 0;
+
+struct counting_less {
+  bool operator()(int a, int b) const { return ++comparison_count, a < b; }
+};
+
+template <typename T>
+const auto &key_of(const T &elem) {
+  if constexpr (cp::_detail::is_tuple<T>) {
+    return elem.first;
+  } else {
+    return elem;
+  }
+}
+
+// Every group agrees with equal_range() and count().
+template <typename T>
+bool check_groups(const T &container) {
+  size_t groups = 0;
+  size_t elements = 0;
+  cp::_detail::key_groups<T> grouped(container);
+  for (auto it = grouped.begin(); it != grouped.end(); ++it) {
+    auto [first, last] = container.equal_range(key_of(*it));
+    if (it.group_begin() != first || it.group_end() != last) return false;
+    if (it.count() != container.count(key_of(*it))) return false;
+    ++groups;
+    elements += it.count();
+  }
+  size_t distinct = 0;
+  for (auto it = container.begin(); it != container.end();
+       it = container.equal_range(key_of(*it)).second) {
+    ++distinct;
+  }
+  return groups == distinct && elements == container.size();
+}
+
+int main() {
+  CPP_DUMP_SET_OPTION(es_style, cp::types::es_style_t::no_es);
+
+  mt19937 engine(1);
+  for (int i = 0; i < 200; ++i) {
+    int keys = 1 + static_cast<int>(engine() % 50);
+    multimap<int, int> mmap;
+    unordered_multimap<int, int> ummap;
+    multiset<int> mset;
+    unordered_multiset<int> umset;
+    for (int j = static_cast<int>(engine() % 300); j > 0; --j) {
+      int key = static_cast<int>(engine()) % keys;
+      mmap.emplace(key, j);
+      ummap.emplace(key, j);
+      mset.insert(key);
+      umset.insert(key);
+    }
+    CHECK(check_groups(mmap));
+    CHECK(check_groups(ummap));
+    CHECK(check_groups(mset));
+    CHECK(check_groups(umset));
+  }
+
+  // The groups are found with one comparison per element, and long groups are skipped.
+  for (int multiplicity : {1, 1000}) {
+    multimap<int, int, counting_less> large;
+    for (int i = 0; i < 100000; ++i) large.emplace_hint(large.end(), i / multiplicity, i);
+    comparison_count = 0;
+    size_t groups = 0;
+    size_t elements = 0;
+    cp::_detail::key_groups<decltype(large)> grouped(large);
+    for (auto it = grouped.begin(); it != grouped.end(); ++it) ++groups, elements += it.count();
+    CHECK(groups == large.size() / multiplicity && elements == large.size());
+    CHECK(comparison_count < large.size() / (multiplicity == 1 ? 1 : 10));
+  }
+
+  multimap<int, int> mmap{{1, 10}, {1, 11}, {2, 20}, {3, 30}, {3, 31}, {3, 32}};
+  CHECK(
+      cp::export_var(mmap)
+      == "{\n  1 (2): [ 10, 11 ],\n  2 (1): [ 20 ],\n  3 (3): [ 30, 31, 32 ]\n}"
+  );
+  CHECK(cp::export_var(mmap | cp::back(1)) == "{\n  ...,\n  3 (3): [ 30, 31, 32 ]\n}");
+  multiset<char> mset{'a', 'b', 'b', 'c', 'c', 'c'};
+  CHECK(cp::export_var(mset) == "{ 'a' (1), 'b' (2), 'c' (3) }");
+
+  return 0;
+}
@@ -0,0 +1,121 @@
+#include <iostream>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../cpp-dump.hpp"
+#include "./common.hpp"
+
+//
+using namespace std;
+namespace cp = cpp_dump;
+
+thread_local vector<string> lines;
+
+namespace cpp_dump {
+
+template <>
+void write_log(std::string_view output) {
+  lines.emplace_back(output);
+}
+
+}  // namespace cpp_dump
+
+// A type whose operator<<() changes the shared options in the middle of a dump.
+struct changes_options {};
+
+ostream &operator<<(ostream &os, const changes_options &) {
+  CPP_DUMP_SET_OPTION(max_depth, 0);
+  CPP_DUMP_SET_OPTION(max_line_width, 10);
+  return os << "changed";
+}
+
+int main() {
+  CPP_DUMP_SET_OPTION(es_style, cp::types::es_style_t::no_es);
+  CPP_DUMP_SET_OPTION(log_label_func, nullptr);
+  vector<int> vec{1, 2, 3};
+  int value = 1;
+
+  // A scope replaces the shared options on this thread until it ends.
+  {
+    cp::types::options_snapshot_t narrow;
+    narrow.max_line_width = 10;
+    narrow.log_label_func = cp::log_label::default_func;
+    cp::options_scope scope(narrow);
+    CHECK(cp::export_var(vec) == "[\n  1,\n  2,\n  3\n]");
+    cpp_dump(value);
+    CHECK(lines.back().rfind("[dump] ", 0) == 0);
+
+    // Changing the snapshot or the shared options does not affect the scope.
+    narrow.max_line_width = 160;
+    CPP_DUMP_SET_OPTION(max_line_width, 160);
+    CHECK(cp::export_var(vec) == "[\n  1,\n  2,\n  3\n]");
+
+    // Scopes may nest.
+    {
+      cp::types::options_snapshot_t shallow;
+      shallow.max_depth = 0;
+      cp::options_scope inner(shallow);
+      CHECK(cp::export_var(vec) == "[ ... ]");
+    }
+    CHECK(cp::export_var(vec) == "[\n  1,\n  2,\n  3\n]");
+  }
+  CHECK(cp::export_var(vec) == "[ 1, 2, 3 ]");
+  cpp_dump(value);
+  CHECK(lines.back() == "value => 1");
+
+  // A dump uses the options of the time it started even if they change while it prints.
+  auto with_changer = make_tuple(vec, changes_options{}, vec);
+  CHECK(cp::export_var(with_changer) == "( [ 1, 2, 3 ], changed, [ 1, 2, 3 ] )");
+  CHECK(cp::export_var(vec) == "[ ... ]");
+  CPP_DUMP_SET_OPTION(max_depth, 4);
+  CPP_DUMP_SET_OPTION(max_line_width, 160);
+
+  // The dumps also notice log_label_func assigned without the macro.
+  cp::options::log_label_func = cp::log_label::default_func;
+  cpp_dump(value);
+  CHECK(lines.back() == "[dump] value => 1");
+  cp::options::log_label_func = nullptr;
+  cpp_dump(value);
+  CHECK(lines.back() == "value => 1");
+
+  // So do the other options except es_value.
+  cp::options::max_line_width = 10;
+  CHECK(cp::export_var(vec) == "[\n  1,\n  2,\n  3\n]");
+  cp::options::max_line_width = 160;
+  cp::options::print_expr = false;
+  cpp_dump(value);
+  CHECK(lines.back() == "1");
+  cp::options::print_expr = true;
+  cp::options::es_style = cp::types::es_style_t::original;
+  cpp_dump(value);
+  CHECK(lines.back().find("\x1b[") != string::npos);
+  cp::options::es_style = cp::types::es_style_t::no_es;
+  cpp_dump(value);
+  CHECK(lines.back() == "value => 1");
+
+  // The threads can dump with their own options at the same time.
+  auto run = [](cp::types::es_style_t es_style, size_t width, vector<string> &result) {
+    cp::types::options_snapshot_t snapshot;
+    snapshot.es_style = es_style;
+    snapshot.max_line_width = width;
+    cp::options_scope scope(snapshot);
+    vector<int> v{1, 2, 3};
+    for (int i = 0; i < 200; ++i) cpp_dump(v);
+    result = lines;
+  };
+  vector<string> console, audit;
+  thread console_thread(run, cp::types::es_style_t::original, 160, ref(console));
+  thread audit_thread(run, cp::types::es_style_t::no_es, 10, ref(audit));
+  console_thread.join();
+  audit_thread.join();
+  CHECK(console.size() == 200 && audit.size() == 200);
+  for (auto &line : console) CHECK(line == console[0]);
+  for (auto &line : audit) CHECK(line == "v => [\n  1,\n  2,\n  3\n]");
+  CHECK(console[0].find("\x1b[") != string::npos);
+  CHECK(console[0].find("v") != string::npos && console[0].find('\n') == string::npos);
+
+  return 0;
+}
@@ -0,0 +1,77 @@
+#include <iostream>
+#include <map>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "../cpp-dump.hpp"
+#include "./common.hpp"
+
+//
+using namespace std;
+namespace cp = cpp_dump;
+
+// Counts how many times the leaves are rendered.
+struct leaf {
+  int value;
+  static inline int render_count = 0;
+};
+
+ostream &operator<<(ostream &os, const leaf &l) {
+  ++leaf::render_count;
+  return os << "leaf(" << l.value << ")";
+}
+
+string dumped;
+
+template <>
+void cpp_dump::write_log(std::string_view output) {
+  dumped = output;
+}
+
+int main() {
+  // depth 0: vector, 1: map, 2: vector, 3: leaf
+  vector<map<string, vector<leaf>>> data;
+  int leaf_count = 0;
+  for (int i = 0; i < 3; ++i) {
+    auto &m = data.emplace_back();
+    for (int j = 0; j < 3; ++j) {
+      auto &v = m["key" + to_string(j)];
+      for (int k = 0; k < 4; ++k) {
+        v.push_back({leaf_count++});
+      }
+    }
+  }
+
+  // Narrow enough that every pattern of cpp_dump() fails on one line and retries.
+  CPP_DUMP_SET_OPTION(max_line_width, 40);
+
+  cpp_dump(data);
+  CHECK(leaf::render_count == leaf_count);
+
+  leaf::render_count = 0;
+  cpp_dump(data, data);
+  CHECK(leaf::render_count == 2 * leaf_count);
+
+  // The one-line length of every node is computed at most once, and laying out the nodes again
+  // only hits the cache.
+  cp::_detail::document doc;
+  const auto &node =
+      cp::_detail::export_var(data, 0, cp::_detail::export_command::default_command, doc);
+  cp::_detail::render_cache cache;
+
+  auto first = cp::_detail::layout(node, "", 0, false, cache);
+  CHECK(cache.misses() <= doc.size());
+  CHECK(first == cp::export_var(data));
+
+  auto misses = cache.misses();
+  auto hits = cache.hits();
+  CHECK(cp::_detail::layout(node, "", 0, true, cache) == "\n");
+  CHECK(cp::_detail::layout(node, "", 0, false, cache) == first);
+  CHECK(cp::_detail::layout(node, "    ", 4, false, cache).size() > first.size());
+  CHECK(cache.misses() == misses);
+  CHECK(cache.hits() > hits);
+
+  return 0;
+}
@@ -0,0 +1,103 @@
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../cpp-dump.hpp"
+
+#define TEST_CAPTURE_LINES
+#include "./common.hpp"
+
+//
+using namespace std;
+namespace cp = cpp_dump;
+
+int evaluated = 0;
+
+int count_evaluation(int i) {
+  ++evaluated;
+  return i;
+}
+
+int main() {
+  CPP_DUMP_SET_OPTION(es_style, cp::types::es_style_t::no_es);
+  CPP_DUMP_SET_OPTION(log_label_func, nullptr);
+
+  // The skipped calls do not evaluate the arguments.
+  for (int i = 0; i < 100; ++i) cpp_dump_sampled(cp::sampling::first(3), count_evaluation(i));
+  CHECK(evaluated == 3);
+  CHECK((lines == vector<string>{"count_evaluation(i) => 0", "count_evaluation(i) => 1",
+                                 "count_evaluation(i) => 2"}));
+
+  // The number of the skipped calls is printed with the next printed call.
+  lines.clear();
+  for (int i = 0; i < 25; ++i) cpp_dump_sampled(cp::sampling::every(10), i);
+  CHECK((lines == vector<string>{"i => 0", "(9 suppressed) i => 10", "(9 suppressed) i => 20"}));
+
+  // The label of log_label_func comes first.
+  lines.clear();
+  CPP_DUMP_SET_OPTION(log_label_func, cp::log_label::default_func);
+  for (int i = 0; i < 3; ++i) cpp_dump_sampled(cp::sampling::every(2), i);
+  CHECK((lines == vector<string>{"[dump] i => 0", "[dump] (1 suppressed) i => 2"}));
+  CPP_DUMP_SET_OPTION(log_label_func, nullptr);
+
+  // Each call site has its own state.
+  lines.clear();
+  for (int i = 0; i < 10; ++i) {
+    cpp_dump_sampled(cp::sampling::first(1), i);
+    cpp_dump_sampled(cp::sampling::first(2), i);
+  }
+  CHECK((lines == vector<string>{"i => 0", "i => 0", "i => 1"}));
+
+  // The token bucket prints a burst of k calls and then k calls per second.
+  lines.clear();
+  auto dump_per_second = [](int i) { cpp_dump_sampled(cp::sampling::per_second(5), i); };
+  for (int i = 0; i < 100; ++i) dump_per_second(i);
+  CHECK(lines.size() == 5 && lines.back() == "i => 4");
+  this_thread::sleep_for(chrono::milliseconds(450));
+  dump_per_second(100);
+  CHECK(lines.size() == 6 && lines.back() == "(95 suppressed) i => 100");
+
+  // A rate of 0 prints no call.
+  lines.clear();
+  for (int i = 0; i < 100; ++i) cpp_dump_sampled(cp::sampling::per_second(0), i);
+  CHECK(lines.empty());
+
+  lines.clear();
+  for (int i = 0; i < 1000; ++i) cpp_dump_sampled(cp::sampling::probability(0), i);
+  CHECK(lines.empty());
+  for (int i = 0; i < 1000; ++i) cpp_dump_sampled(cp::sampling::probability(1), i);
+  CHECK(lines.size() == 1000 && lines.back() == "i => 999");
+  lines.clear();
+  for (int i = 0; i < 10000; ++i) cpp_dump_sampled(cp::sampling::probability(0.1), i);
+  CHECK(lines.size() > 800 && lines.size() < 1200);
+
+  // The skips that race may be counted once, but a skip is never taken twice.
+  {
+    cp::_detail::skip_counter counter;
+    for (int i = 0; i < 5; ++i) counter.skip();
+    CHECK(counter.take() == 5 && counter.take() == 0);
+    atomic<size_t> taken = 0;
+    vector<thread> threads;
+    for (int t = 0; t < 4; ++t) {
+      threads.emplace_back([&] {
+        for (int i = 0; i < 10000; ++i) {
+          counter.skip();
+          if (i % 100 == 0) taken += counter.take();
+        }
+      });
+    }
+    for (auto &th : threads) th.join();
+    taken += counter.take();
+    CHECK(taken > 0 && taken <= 40000);
+  }
+
+  // The policy is initialized at compile time.
+  [[maybe_unused]] constexpr auto every_3 = cp::sampling::every(3);
+  [[maybe_unused]] constexpr auto per_second_3 = cp::sampling::per_second(3);
+  [[maybe_unused]] constexpr auto probability_half = cp::sampling::probability(0.5);
+
+  return 0;
+}
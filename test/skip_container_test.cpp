@@ -0,0 +1,137 @@
+#include <forward_list>
+#include <iostream>
+#include <limits>
+#include <list>
+#include <numeric>
+#include <set>
+#include <utility>
+#include <vector>
+
+#include "../cpp-dump.hpp"
+#include "./common.hpp"
+
+//
+using namespace std;
+namespace cp = cpp_dump;
+using kind_t = cp::_detail::skip_policy::kind_t;
+
+// The per-element skip functions that the policies replace.
+size_t reference_skip_size(kind_t kind, size_t count, size_t index, size_t size) {
+  constexpr size_t to_end = numeric_limits<size_t>::max();
+  switch (kind) {
+    case kind_t::back: {
+      size_t first = size >= count ? size - count : 0;
+      return index < first ? first - index : 0;
+    }
+    case kind_t::both_ends: {
+      size_t latter_half_first = size >= count ? size - count : 0;
+      return index >= count && index < latter_half_first ? latter_half_first - index : 0;
+    }
+    case kind_t::middle: {
+      size_t first = size >= count ? (size - count) / 2 : 0;
+      if (index < first) return first - index;
+      return index >= first + count ? to_end : 0;
+    }
+    default:
+      return index >= count ? to_end : 0;
+  }
+}
+
+// The shown elements, with -1 for an ellipsis.
+vector<int> reference_elements(kind_t kind, size_t count, size_t size) {
+  vector<int> elements;
+  size_t index = 0;
+  while (index < size) {
+    size_t skip = reference_skip_size(kind, count, index, size);
+    elements.push_back(skip == 0 ? static_cast<int>(index) : -1);
+    if (skip == numeric_limits<size_t>::max()) break;
+    index += skip == 0 ? 1 : skip;
+  }
+  return elements;
+}
+
+template <typename T>
+vector<int> skipped_elements(const T &container, const cp::_detail::skip_policy &policy) {
+  vector<int> elements;
+  cp::_detail::skip_container<T> skipped(container, policy);
+  for (auto &&[is_ellipsis, it, index] : skipped) {
+    if (is_ellipsis) {
+      elements.push_back(-1);
+    } else {
+      // The index is that of the element.
+      elements.push_back(*it == static_cast<int>(index) ? *it : -2);
+    }
+  }
+  return elements;
+}
+
+// A bidirectional iterator that counts its steps.
+struct counting_iterator {
+ public:
+  using iterator_category = bidirectional_iterator_tag;
+  using value_type = int;
+  using difference_type = ptrdiff_t;
+  using pointer = const int *;
+  using reference = const int &;
+
+  vector<int>::const_iterator it;
+  size_t *steps;
+
+  const int &operator*() const { return *it; }
+  counting_iterator &operator++() { return ++*steps, ++it, *this; }
+  counting_iterator &operator--() { return ++*steps, --it, *this; }
+  bool operator==(const counting_iterator &to) const { return it == to.it; }
+  bool operator!=(const counting_iterator &to) const { return it != to.it; }
+};
+
+struct counting_container {
+ public:
+  vector<int> vec;
+  mutable size_t steps = 0;
+
+  counting_iterator begin() const { return {vec.begin(), &steps}; }
+  counting_iterator end() const { return {vec.end(), &steps}; }
+  size_t size() const { return vec.size(); }
+};
+
+int main() {
+  for (auto kind : {kind_t::front, kind_t::back, kind_t::both_ends, kind_t::middle}) {
+    for (size_t size = 1; size <= 20; ++size) {
+      vector<int> vec(size);
+      iota(vec.begin(), vec.end(), 0);
+      list<int> lst(vec.begin(), vec.end());
+      forward_list<int> flst(vec.begin(), vec.end());
+      set<int> st(vec.begin(), vec.end());
+      counting_container counting{vec};
+
+      for (size_t count = 0; count <= 22; ++count) {
+        cp::_detail::skip_policy policy{kind, count};
+        auto expected = reference_elements(kind, count, size);
+        CHECK(skipped_elements(vec, policy) == expected);
+        CHECK(skipped_elements(lst, policy) == expected);
+        CHECK(skipped_elements(flst, policy) == expected);
+        CHECK(skipped_elements(st, policy) == expected);
+        CHECK(skipped_elements(counting, policy) == expected);
+      }
+    }
+  }
+
+  // The tails of bidirectional containers are found from the end.
+  counting_container large{vector<int>(100000)};
+  iota(large.vec.begin(), large.vec.end(), 0);
+  for (auto kind : {kind_t::back, kind_t::both_ends}) {
+    large.steps = 0;
+    CHECK(skipped_elements(large, cp::_detail::skip_policy{kind, 5}).size() <= 11);
+    CHECK(large.steps <= 20);
+  }
+
+  // front() does not need the size.
+  int size_calls = 0;
+  auto get_size = [&] { return ++size_calls, size_t{10}; };
+  cp::_detail::front_policy{3}.get_ranges(get_size);
+  CHECK(size_calls == 0);
+  cp::_detail::skip_policy{kind_t::middle, 3}.get_ranges(get_size);
+  CHECK(size_calls == 1);
+
+  return 0;
+}
@@ -0,0 +1,159 @@
+#include <algorithm>
+#include <cctype>
+#include <iostream>
+#include <map>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "../cpp-dump.hpp"
+#include "./common.hpp"
+
+//
+using namespace std;
+namespace cp = cpp_dump;
+
+// The scalar implementations that the kernels replace.
+namespace reference {
+
+bool use_es = true;
+
+size_t get_length(string_view s) {
+  if (!use_es) return s.length();
+  static constexpr string_view es_begin_token = "\x1b[";
+  size_t length = 0;
+  auto begin = s.begin();
+  decltype(begin) end;
+  while ((end = search(begin, s.end(), es_begin_token.begin(), es_begin_token.end())) != s.end()) {
+    length += end - begin;
+    begin = end + es_begin_token.size();
+    end = find_if(begin, s.end(), [](char c) { return !(isdigit(c) || c == ';'); });
+    if (end == s.end()) break;
+    begin = end + 1;
+  }
+  length += end - begin;
+  return length;
+}
+
+size_t get_first_line_length(string_view s) {
+  auto lf_pos = s.find('\n');
+  return get_length(lf_pos == string::npos ? s : s.substr(0, lf_pos));
+}
+
+size_t get_last_line_length(string_view s) {
+  auto lf_pos = s.rfind('\n');
+  return get_length(lf_pos == string::npos ? s : s.substr(lf_pos + 1));
+}
+
+string escape_non_printable_char(char c) {
+  static const map<char, string_view> char_to_escaped{
+      {'\0', "\\0"},
+      {'\a', "\\a"},
+      {'\b', "\\b"},
+      {'\f', "\\f"},
+      {'\n', "\\n"},
+      {'\r', "\\r"},
+      {'\t', "\\t"},
+      {'\v', "\\v"},
+  };
+  if (char_to_escaped.count(c)) return string(char_to_escaped.at(c));
+  auto to_hex_char = [](unsigned char uc) -> char {
+    return static_cast<char>(uc < 10 ? '0' + uc : 'A' + (uc - 10));
+  };
+  return string({'\\', 'x', to_hex_char((c >> 4) & 0x0f), to_hex_char(c & 0x0f)});
+}
+
+string escape_string(string_view s) {
+  string retval(1, '"');
+  for (char c : s) {
+    if (c == '"') {
+      retval.append(R"(\")");
+    } else if (c == '\\') {
+      retval.append(R"(\\)");
+    } else if (!isprint(static_cast<unsigned char>(c))) {
+      retval.append(escape_non_printable_char(c));
+    } else {
+      retval.push_back(c);
+    }
+  }
+  return retval.append(1, '"');
+}
+
+}  // namespace reference
+
+string random_string(mt19937 &engine, bool escape_sequences) {
+  // Mostly short strings, sometimes long ones that cross several vectors.
+  size_t length = engine() % 8 == 0 ? engine() % 3000 : engine() % 80;
+  string s(length, ' ');
+  for (auto &c : s) {
+    if (escape_sequences) {
+      static constexpr string_view alphabet = "ab\n\x1b\x1b[[[0123;;m";
+      c = alphabet[engine() % alphabet.size()];
+    } else {
+      // Printable text with a few bytes of every kind.
+      c = static_cast<char>(engine() % 4 == 0 ? engine() % 256 : 'a' + engine() % 26);
+    }
+  }
+  return s;
+}
+
+int main() {
+  using namespace cp::_detail;
+
+  // The table agrees with the old escaping for every byte.
+  for (int i = 0; i < 256; ++i) {
+    char c = static_cast<char>(i);
+    bool needs_escape = !isprint(i) || c == '"' || c == '\\';
+    CHECK(get_byte_info(c).needs_escape == needs_escape);
+    CHECK(get_byte_info(c).newline_or_es == (c == '\n' || c == '\x1b'));
+    if (!isprint(i)) {
+      CHECK(escape_non_printable_char(c) == reference::escape_non_printable_char(c));
+    }
+  }
+
+  vector<text_kernels> kernels{text_kernels::scalar()};
+#if defined(_p_CPP_DUMP_SSE2)
+  kernels.push_back(text_kernels::sse2());
+#endif
+#if defined(_p_CPP_DUMP_AVX2)
+  if (text_kernels::avx2_supported()) kernels.push_back(text_kernels::avx2());
+#endif
+  clog << "kernels:";
+  for (const auto &k : kernels) clog << " " << k.name;
+  clog << ", selected: " << text_kernels::get().name << endl;
+
+  mt19937 engine(1);
+  for (int i = 0; i < 20000; ++i) {
+    bool escape_sequences = i % 2 == 0;
+    string s = random_string(engine, escape_sequences);
+
+    // Every kernel finds the same bytes at every alignment.
+    size_t offset = s.empty() ? 0 : engine() % min<size_t>(s.size(), 64);
+    const char *first = s.data() + offset;
+    const char *last = s.data() + s.size();
+    for (const auto &k : kernels) {
+      auto expected_escape = find_if(first, last, [](char c) {
+        return !isprint(static_cast<unsigned char>(c)) || c == '"' || c == '\\';
+      });
+      auto expected_newline = find_if(first, last, [](char c) { return c == '\n' || c == '\x1b'; });
+      CHECK(k.find_needs_escape(first, last) == expected_escape);
+      CHECK(k.find_newline_or_es(first, last) == expected_newline);
+    }
+
+    CHECK(string_view(escape_string(s)) == reference::escape_string(s));
+
+    for (bool es : {true, false}) {
+      CPP_DUMP_SET_OPTION(
+          es_style, es ? cp::types::es_style_t::original : cp::types::es_style_t::no_es
+      );
+      reference::use_es = es;
+      auto metrics = measure_text(s);
+      CHECK(metrics.has_newline == (s.find('\n') != string::npos));
+      CHECK(metrics.first_line_length == reference::get_first_line_length(s));
+      CHECK(metrics.last_line_length == reference::get_last_line_length(s));
+    }
+  }
+
+  return 0;
+}
@@ -0,0 +1,54 @@
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "../cpp-dump.hpp"
+#include "./common.hpp"
+
+//
+using namespace std;
+namespace cp = cpp_dump;
+
+int main() {
+  using cp::_detail::token_table;
+
+  vector<vector<int>> data{{1, 2}, {}, {3}};
+
+  // The table is reused while the options stay the same.
+  auto table = token_table::current();
+  auto epoch = table->epoch;
+  string first = cp::export_var(data);
+  CHECK(token_table::current() == table);
+  CHECK(token_table::current()->epoch == epoch);
+
+  // Changing es_value rebuilds the table, and the output uses the new colors.
+  CPP_DUMP_SET_OPTION(es_style, cp::types::es_style_t::original);
+  CPP_DUMP_SET_OPTION(es_value.bracket_by_depth, (vector<string>{"\x1b[31m", "\x1b[32m"}));
+  CHECK(token_table::current()->epoch == epoch + 1);
+  CHECK(token_table::current()->depth(2).empty_square.str == "\x1b[31m[ ]\x1b[0m");
+  CHECK(token_table::current()->depth(2).empty_square.length() == 3);
+  string second = cp::export_var(data);
+  CHECK(second != first);
+  CHECK(second.find("\x1b[32m[ ]\x1b[0m") != string::npos);
+
+  // So do es_style and the detailed_*_es flags.
+  epoch = token_table::current()->epoch;
+  CPP_DUMP_SET_OPTION(detailed_number_es, true);
+  CHECK(token_table::current()->epoch == epoch + 1);
+  CPP_DUMP_SET_OPTION(es_style, cp::types::es_style_t::no_es);
+  CHECK(token_table::current()->epoch == epoch + 2);
+  CHECK(token_table::current()->depth(0).omitted_square.str == "[ ... ]");
+  CHECK(cp::export_var(data) == "[\n  [ 1, 2 ],\n  [ ],\n  [ 3 ]\n]");
+
+  // A document keeps its table even if the options change while it is alive.
+  cp::_detail::document doc;
+  const auto &node =
+      cp::_detail::export_var(true, 0, cp::_detail::export_command::default_command, doc);
+  CPP_DUMP_SET_OPTION(es_style, cp::types::es_style_t::original);
+  CPP_DUMP_SET_OPTION(es_value.reserved, "\x1b[35m");
+  CHECK(token_table::current()->epoch == epoch + 3);
+  cp::_detail::render_cache cache;
+  CHECK(cp::_detail::layout(node, "", 0, false, cache) == "true");
+
+  return 0;
+}
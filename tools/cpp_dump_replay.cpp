@@ -0,0 +1,96 @@
+/*
+ * Copyright (c) 2023 Ryota Sasaki.
+ *
+ * This source code is licensed under the MIT license found in the LICENSE file in the root
+ * directory of this source tree.
+ */
+
+// Print the text of a stream written by cpp_dump::start_binary_log().
+// The colors and the line width are chosen here, not when the stream was written.
+
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <string_view>
+
+#include "../cpp-dump.hpp"
+
+namespace cp = cpp_dump;
+
+namespace {
+
+constexpr std::string_view usage =
+    "usage: cpp-dump-replay [options] [file]\n"
+    "Print the text of a stream written by cpp_dump::start_binary_log().\n"
+    "The stream is read from the standard input if no file is given.\n"
+    "options:\n"
+    "  --es-style=no_es|original|by_syntax  the coloring (default: original)\n"
+    "  --max-line-width=N                   the maximum line width (default: 160)\n"
+    "  --time                               print the time and the thread of each record\n";
+
+bool starts_with(std::string_view s, std::string_view prefix) {
+  return s.substr(0, prefix.size()) == prefix;
+}
+
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  bool show_time = false;
+  std::string path;
+  for (int i = 1; i < argc; ++i) {
+    std::string_view arg = argv[i];
+    if (starts_with(arg, "--es-style=")) {
+      auto style = arg.substr(11);
+      if (style == "no_es") {
+        CPP_DUMP_SET_OPTION(es_style, cp::types::es_style_t::no_es);
+      } else if (style == "original") {
+        CPP_DUMP_SET_OPTION(es_style, cp::types::es_style_t::original);
+      } else if (style == "by_syntax") {
+        CPP_DUMP_SET_OPTION(es_style, cp::types::es_style_t::by_syntax);
+      } else {
+        std::cerr << usage;
+        return 2;
+      }
+    } else if (starts_with(arg, "--max-line-width=")) {
+      CPP_DUMP_SET_OPTION(max_line_width, std::strtoul(argv[i] + 17, nullptr, 10));
+    } else if (arg == "--time") {
+      show_time = true;
+    } else if (starts_with(arg, "-") || !path.empty()) {
+      std::cerr << usage;
+      return 2;
+    } else {
+      path = arg;
+    }
+  }
+
+  std::string stream;
+  if (path.empty()) {
+    stream.assign(std::istreambuf_iterator<char>(std::cin), std::istreambuf_iterator<char>());
+  } else {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+      std::cerr << "cpp-dump-replay: cannot open " << path << "\n";
+      return 1;
+    }
+    stream.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+  }
+
+  bool ok = cp::replay_binary_log(stream, [&](const cp::types::binary_log_record_t &record) {
+    if (show_time) {
+      auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+          record.time.time_since_epoch()
+      );
+      std::cout << ns.count() << " " << record.thread << " ";
+    }
+    std::cout << record.text << '\n';
+  });
+  std::cout.flush();
+  if (!ok) {
+    std::cerr << "cpp-dump-replay: the stream is broken or truncated\n";
+    return 1;
+  }
+  return 0;
+}